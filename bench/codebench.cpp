@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compiler.hpp"
+#include "process.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Quality of the generated code, as opposed to the speed of the compiler:
+ *
+ *   codebench [--runs N] [--format win64] [--baseline alt.json] [--output neu.json] Kernel.DEnk...
+ *
+ * Every kernel is compiled, assembled, linked and run N times. Per kernel the JSON file records the
+ * exit code, the static instruction count, the frame size from main's 'sub rsp' and the medians of
+ * wall time, cycles and retired instructions (the last two via perf_event_open, null elsewhere).
+ * With a baseline, every metric is printed next to its previous value.
+ */
+using Clock = std::chrono::steady_clock;
+
+struct KernelResult
+{
+    std::string name;
+    int exit_code = -1;
+    uint64_t static_instructions = 0;
+    uint64_t frame_bytes = 0;
+    double seconds = 0;
+    std::optional<uint64_t> cycles;
+    std::optional<uint64_t> instructions;
+};
+
+struct RunResult
+{
+    int exit_code = -1;
+    double seconds = 0;
+    std::optional<uint64_t> cycles;
+    std::optional<uint64_t> instructions;
+};
+
+/* Static Metrics */
+
+// Lines of the .text section that are neither labels, directives nor comments
+static uint64_t count_instructions(std::string_view assembly)
+{
+    uint64_t count = 0;
+    bool text = false;
+
+    std::istringstream lines{ std::string(assembly) };
+    std::string line;
+
+    while (std::getline(lines, line))
+    {
+        const std::string code = line.substr(0, line.find(';'));
+        const size_t start = code.find_first_not_of(" \t");
+
+        if (start == std::string::npos)
+            continue;
+
+        const std::string_view stmt = std::string_view(code).substr(start);
+
+        if (stmt.starts_with("section"))
+        {
+            text = stmt.find(".text") != std::string_view::npos;
+
+            continue;
+        }
+
+        if (!text || stmt.back() == ':' || stmt.starts_with("global") || stmt.starts_with("extern") || stmt.starts_with("align"))
+            continue;
+
+        count++;
+    }
+
+    return count;
+}
+
+// The first 'sub rsp, N' after 'main:' allocates the frame
+static uint64_t frame_size(std::string_view assembly)
+{
+    const size_t main = assembly.find("\nmain:");
+    const size_t sub = assembly.find("sub rsp, ", main == std::string_view::npos ? 0 : main);
+
+    uint64_t size = 0;
+
+    if (sub != std::string_view::npos)
+        std::from_chars(assembly.data() + sub + 9, assembly.data() + assembly.size(), size);
+
+    return size;
+}
+
+/* Running */
+
+#ifndef _WIN32
+#ifdef __linux__
+// Counts for 'pid' once it calls exec; -1 if the kernel or its perf_event_paranoid setting refuses
+static int open_counter(const pid_t pid, const uint64_t config)
+{
+    perf_event_attr attr {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+static std::optional<uint64_t> read_counter(const int fd)
+{
+    uint64_t value;
+
+    if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value))
+        return std::nullopt;
+
+    return value;
+}
+#endif
+
+// The child waits on a pipe until its counters are attached, like 'perf stat' does
+static RunResult run(const std::filesystem::path& exe)
+{
+    RunResult result;
+
+    int go[2];
+
+    if (pipe2(go, O_CLOEXEC) != 0)
+        return result;
+
+    const std::string path = exe.string();
+    const pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        char byte;
+
+        close(go[1]);
+
+        while (read(go[0], &byte, 1) < 0 && errno == EINTR)
+            ;
+
+        execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(go[0]);
+
+    if (pid < 0)
+    {
+        close(go[1]);
+
+        return result;
+    }
+
+#ifdef __linux__
+    const int cycles = open_counter(pid, PERF_COUNT_HW_CPU_CYCLES);
+    const int instructions = open_counter(pid, PERF_COUNT_HW_INSTRUCTIONS);
+#endif
+
+    const Clock::time_point start = Clock::now();
+
+    // EOF on the pipe lets the child exec
+    close(go[1]);
+
+    int status;
+
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+#ifdef __linux__
+    result.cycles = read_counter(cycles);
+    result.instructions = read_counter(instructions);
+
+    for (const int fd : { cycles, instructions })
+        if (fd >= 0)
+            close(fd);
+#endif
+
+    return result;
+}
+#else
+static RunResult run(const std::filesystem::path& exe)
+{
+    RunResult result;
+
+    const Clock::time_point start = Clock::now();
+
+    result.exit_code = system(("\"" + exe.string() + "\"").c_str());
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    return result;
+}
+#endif
+
+template <typename T>
+static T median(std::vector<T> values)
+{
+    std::ranges::sort(values);
+
+    return values[values.size() / 2];
+}
+
+static std::optional<KernelResult> bench_kernel(const std::filesystem::path& input, const std::string& format,
+                                                const size_t runs, const std::filesystem::path& work_dir)
+{
+    std::ifstream file_in(input, std::ios::binary);
+
+    if (!file_in)
+    {
+        std::cerr << "Fehler: Die Datei '" << input.string() << "' konnte nicht geöffnet werden" << std::endl;
+
+        return std::nullopt;
+    }
+
+    const std::string source((std::istreambuf_iterator<char>(file_in)), std::istreambuf_iterator<char>());
+
+    Compiler compiler;
+
+    const CompileResult compiled = compiler.compile(source, { .format = format, .assemble = true }, input.string());
+
+    for (const Diagnostic& diagnostic : compiled.diagnostics)
+        std::cerr << input.string() << ": " << diagnostic.message << std::endl;
+
+    if (!compiled.success)
+        return std::nullopt;
+
+    const std::filesystem::path obj_path = work_dir / (input.stem().string() + ".o");
+    const std::filesystem::path exe_path = work_dir / input.stem();
+
+    std::ofstream(obj_path, std::ios::binary) << compiled.object;
+
+    const ProcessResult linked = run_process({ "gcc", obj_path.string(), "-o", exe_path.string() });
+
+    if (linked.exit_code != 0)
+    {
+        std::cerr << linked.errors << input.string() << ": Fehler: GCC-Linker konnte nicht erfolgreich ausgeführt werden" << std::endl;
+
+        return std::nullopt;
+    }
+
+    KernelResult result;
+    result.name = input.stem().string();
+    result.static_instructions = count_instructions(compiled.assembly);
+    result.frame_bytes = frame_size(compiled.assembly);
+
+    std::vector<double> seconds;
+    std::vector<uint64_t> cycles, instructions;
+
+    for (size_t i = 0; i < runs; i++)
+    {
+        const RunResult run_result = run(exe_path);
+
+        if (i > 0 && run_result.exit_code != result.exit_code)
+        {
+            std::cerr << input.string() << ": Fehler: Die Läufe enden mit unterschiedlichen Exit-Codes" << std::endl;
+
+            return std::nullopt;
+        }
+
+        result.exit_code = run_result.exit_code;
+        seconds.push_back(run_result.seconds);
+
+        if (run_result.cycles.has_value())
+            cycles.push_back(run_result.cycles.value());
+
+        if (run_result.instructions.has_value())
+            instructions.push_back(run_result.instructions.value());
+    }
+
+    result.seconds = median(seconds);
+
+    if (cycles.size() == runs)
+        result.cycles = median(cycles);
+
+    if (instructions.size() == runs)
+        result.instructions = median(instructions);
+
+    return result;
+}
+
+/* Baseline */
+
+static std::string to_json(const std::optional<uint64_t> value)
+{
+    return value.has_value() ? std::to_string(value.value()) : "null";
+}
+
+// One kernel per line, so baselines diff well under version control
+static bool write_json(const std::filesystem::path& path, const std::string& format, const size_t runs, const std::vector<KernelResult>& results)
+{
+    std::ofstream out(path, std::ios::binary);
+
+    out << "{\n  \"format\": \"" << format << "\",\n  \"runs\": " << runs << ",\n  \"kernels\": [";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const KernelResult& r = results[i];
+
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << r.name << "\", \"exit_code\": " << r.exit_code
+            << ", \"static_instructions\": " << r.static_instructions << ", \"frame_bytes\": " << r.frame_bytes
+            << ", \"seconds\": " << std::setprecision(9) << r.seconds
+            << ", \"cycles\": " << to_json(r.cycles) << ", \"instructions\": " << to_json(r.instructions) << "}";
+    }
+
+    out << "\n  ]\n}\n";
+
+    return static_cast<bool>(out);
+}
+
+// Reads back what 'write_json' wrote: every flat object with a "name" becomes one entry
+static std::map<std::string, std::map<std::string, std::string>> read_json(const std::filesystem::path& path)
+{
+    std::map<std::string, std::map<std::string, std::string>> kernels;
+
+    std::ifstream in(path, std::ios::binary);
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    for (size_t open = text.find('{', 1); open != std::string::npos; open = text.find('{', open + 1))
+    {
+        const size_t close = text.find('}', open);
+
+        if (close == std::string::npos)
+            break;
+
+        std::map<std::string, std::string> fields;
+        std::string_view object = std::string_view(text).substr(open + 1, close - open - 1);
+
+        while (!object.empty())
+        {
+            const size_t comma = std::min(object.find(','), object.size());
+            const std::string_view field = object.substr(0, comma);
+            const size_t colon = field.find(':');
+
+            if (colon != std::string_view::npos)
+            {
+                const auto trim = [](std::string_view s)
+                {
+                    const size_t a = s.find_first_not_of(" \t\r\n\"");
+                    const size_t b = s.find_last_not_of(" \t\r\n\"");
+
+                    return a == std::string_view::npos ? std::string() : std::string(s.substr(a, b - a + 1));
+                };
+
+                fields[trim(field.substr(0, colon))] = trim(field.substr(colon + 1));
+            }
+
+            object.remove_prefix(std::min(comma + 1, object.size()));
+        }
+
+        if (fields.contains("name"))
+            kernels[fields["name"]] = fields;
+
+        open = close;
+    }
+
+    return kernels;
+}
+
+static void print_metric(std::string_view label, const std::string& value, const std::optional<std::string>& previous, const bool relative = true)
+{
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::setw(16) << value;
+
+    if (previous.has_value() && previous.value() != "null" && value != "null")
+    {
+        const double old_value = std::strtod(previous->c_str(), nullptr);
+        const double new_value = std::strtod(value.c_str(), nullptr);
+
+        std::cout << std::setw(16) << previous.value();
+
+        if (relative && old_value != 0)
+            std::cout << std::setw(10) << std::fixed << std::setprecision(1) << std::showpos
+                      << 100.0 * (new_value - old_value) / old_value << "%" << std::noshowpos;
+    }
+
+    std::cout << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+    size_t runs = 5;
+    std::string format = "win64";
+    std::optional<std::filesystem::path> baseline_path, output_path;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        if ((arg == "--runs" || arg == "--format" || arg == "--baseline" || arg == "--output") && i + 1 < argc)
+        {
+            const std::string_view value = argv[++i];
+
+            if (arg == "--format")
+                format = value;
+
+            else if (arg == "--baseline")
+                baseline_path = value;
+
+            else if (arg == "--output")
+                output_path = value;
+
+            else if (std::from_chars(value.data(), value.data() + value.size(), runs).ec != std::errc{} || runs == 0)
+            {
+                std::cerr << "Fehler: Ungültige Anzahl von Läufen '" << value << "'" << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+        else
+            inputs.emplace_back(arg);
+    }
+
+    if (inputs.empty())
+    {
+        std::cerr << "Verwendung: codebench [--runs N] [--format win64] [--baseline alt.json] [--output neu.json] Kernel.DEnk..." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    // Read before anything is written, the baseline and the output may be the same file
+    const auto baseline = baseline_path.has_value() ? read_json(baseline_path.value())
+                                                    : std::map<std::string, std::map<std::string, std::string>>{};
+
+    std::error_code ec;
+
+    const std::filesystem::path work_dir = std::filesystem::temp_directory_path(ec) / ("denk-codebench-" + std::to_string(unique_id()));
+
+    std::filesystem::create_directories(work_dir, ec);
+
+    std::vector<KernelResult> results;
+    bool failed = false;
+
+    for (const auto& input : inputs)
+    {
+        const std::optional<KernelResult> result = bench_kernel(input, format, runs, work_dir);
+
+        if (!result.has_value())
+        {
+            failed = true;
+
+            continue;
+        }
+
+        const KernelResult& r = result.value();
+
+        const auto previous = [&](const std::string& key) -> std::optional<std::string>
+        {
+            const auto kernel = baseline.find(r.name);
+
+            if (kernel == baseline.end() || !kernel->second.contains(key))
+                return std::nullopt;
+
+            return kernel->second.at(key);
+        };
+
+        std::ostringstream seconds;
+        seconds << std::setprecision(9) << r.seconds;
+
+        std::cout << r.name << " (neu / alt):\n";
+        print_metric("Exit-Code", std::to_string(r.exit_code), previous("exit_code"), false);
+        print_metric("Statische Befehle", std::to_string(r.static_instructions), previous("static_instructions"));
+        print_metric("Rahmen (Bytes)", std::to_string(r.frame_bytes), previous("frame_bytes"));
+        print_metric("Zeit (s)", seconds.str(), previous("seconds"));
+        print_metric("Zyklen", to_json(r.cycles), previous("cycles"));
+        print_metric("Befehle", to_json(r.instructions), previous("instructions"));
+
+        // A kernel computing something else is a miscompilation, not a performance change
+        if (previous("exit_code").has_value() && previous("exit_code").value() != std::to_string(r.exit_code))
+        {
+            std::cerr << "Fehler: '" << r.name << "' endet mit " << r.exit_code << " statt " << previous("exit_code").value() << std::endl;
+
+            failed = true;
+        }
+
+        results.push_back(r);
+    }
+
+    std::filesystem::remove_all(work_dir, ec);
+
+    if (output_path.has_value() && !write_json(output_path.value(), format, runs, results))
+    {
+        std::cerr << "Fehler: '" << output_path->string() << "' konnte nicht geschrieben werden" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast_file.hpp"
+#include "diagnostics.hpp"
+#include "generator.hpp"
+#include "parser.hpp"
+#include "tokenizer.hpp"
+
+/*
+ * Times Tokenizer, Parser and Generator separately over every input, each phase on its own, and loading the
+ * same tree from its '--emit-ast' form instead of parsing it:
+ *
+ *   denkbench [--runs N] [--jobs N] Datei.DEnk...
+ *
+ * Throughput is reported for the median run, the slow percentiles show the spread. '--jobs' is handed to the
+ * Generator, which spreads the segments of a large program over that many threads.
+ */
+using Clock = std::chrono::steady_clock;
+
+struct Sample
+{
+    std::string_view phase;
+    std::vector<double> seconds;
+};
+
+// Nearest-rank percentile over sorted samples
+static double percentile(const std::vector<double>& sorted, const double p)
+{
+    const size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()) + 0.5);
+
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+template <typename Function>
+static double measure(Function&& function)
+{
+    const Clock::time_point start = Clock::now();
+
+    function();
+
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool bench_file(const std::filesystem::path& input, const size_t runs, const size_t jobs, ArenaAllocator& allocator)
+{
+    std::ifstream file_in(input, std::ios::binary);
+
+    if (!file_in)
+    {
+        std::cerr << "Fehler: Die Datei '" << input.string() << "' konnte nicht geöffnet werden" << std::endl;
+
+        return false;
+    }
+
+    const std::string contents((std::istreambuf_iterator<char>(file_in)), std::istreambuf_iterator<char>());
+
+    Sample samples[] = { { "tokenize", {} }, { "parse", {} }, { "generate", {} }, { "load", {} } };
+
+    size_t tokens = 0, nodes = 0;
+
+    try
+    {
+        for (size_t run = 0; run < runs; run++)
+        {
+            std::vector<Token> token_list;
+
+            samples[0].seconds.push_back(measure([&] { token_list = Tokenizer(contents).tokenize(); }));
+
+            tokens = token_list.size();
+
+            allocator.reset();
+
+            std::optional<NodeProg> prog;
+
+            samples[1].seconds.push_back(measure([&] { prog = Parser(std::move(token_list), allocator).parse_prog(); }));
+
+            if (!prog.has_value())
+                compile_error("Fehler: Ungültiges Programm");
+
+            nodes = count_nodes(prog->stmts);
+
+            const std::string ast = write_ast(prog.value());
+
+            std::string assembly;
+
+            samples[2].seconds.push_back(measure([&] { assembly = Generator(std::move(prog.value()), std::nullopt, false, jobs).gen_prog(); }));
+
+            const std::optional<AstView> view = AstView::open(ast);
+
+            allocator.reset();
+
+            samples[3].seconds.push_back(measure([&] { prog = load_ast(view.value(), allocator); }));
+        }
+    }
+    catch (const CompileError& error)
+    {
+        std::cerr << input.string() << ": " << error.what() << std::endl;
+
+        return false;
+    }
+
+    const double megabytes = static_cast<double>(contents.size()) / (1024.0 * 1024.0);
+
+    std::cout << input.filename().string() << ": " << contents.size() << " Bytes, " << tokens << " Tokens, " << nodes << " Knoten\n";
+
+    for (Sample& sample : samples)
+    {
+        std::ranges::sort(sample.seconds);
+
+        const double median = percentile(sample.seconds, 50);
+
+        std::cout << "  " << std::left << std::setw(10) << sample.phase << std::right << std::fixed
+                  << std::setprecision(3)
+                  << std::setw(10) << median * 1e3
+                  << std::setw(10) << percentile(sample.seconds, 90) * 1e3
+                  << std::setw(10) << percentile(sample.seconds, 99) * 1e3
+                  << std::setprecision(2)
+                  << std::setw(10) << megabytes / median
+                  << std::setw(12) << static_cast<double>(tokens) / median / 1e6
+                  << std::setw(12) << static_cast<double>(nodes) / median / 1e6 << "\n";
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t runs = 20;
+    size_t jobs = 1;
+    std::vector<std::filesystem::path> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--runs" && i + 1 < argc)
+        {
+            const std::string_view value = argv[++i];
+
+            if (std::from_chars(value.data(), value.data() + value.size(), runs).ec != std::errc{} || runs == 0)
+            {
+                std::cerr << "Fehler: Ungültige Anzahl von Läufen '" << value << "'" << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--jobs" && i + 1 < argc)
+        {
+            const std::string_view value = argv[++i];
+
+            if (std::from_chars(value.data(), value.data() + value.size(), jobs).ec != std::errc{} || jobs == 0)
+            {
+                std::cerr << "Fehler: Ungültige Anzahl paralleler Aufträge '" << value << "'" << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+        else
+            inputs.emplace_back(arg);
+    }
+
+    if (inputs.empty())
+    {
+        std::cerr << "Verwendung: denkbench [--runs N] [--jobs N] Datei.DEnk..." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "  " << std::left << std::setw(10) << "Phase" << std::right
+              << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms"
+              << std::setw(10) << "MB/s" << std::setw(12) << "MTokens/s" << std::setw(12) << "MKnoten/s" << "\n";
+
+    // Sized for the largest generated corpus
+    ArenaAllocator allocator(1024 * 1024 * 256);
+
+    bool failed = false;
+
+    for (const auto& input : inputs)
+        failed |= !bench_file(input, runs, jobs, allocator);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Writes a random but valid DEnk program to stdout, shaped by:
+ *
+ *   --stmts N        statements in total, nested ones included
+ *   --depth N        maximum nesting of 'Falls' and plain scopes
+ *   --expr-depth N   maximum nesting of binary expressions
+ *   --idents N       variables declared at the top
+ *   --comments N     percent of statements followed by a comment
+ *   --umlauts N      percent of identifiers spelled with non-ASCII letters
+ *   --seed N
+ */
+struct GenOptions
+{
+    size_t stmts = 1000;
+    size_t depth = 3;
+    size_t expr_depth = 3;
+    size_t idents = 16;
+    size_t comments = 10;
+    size_t umlauts = 20;
+    size_t seed = 1;
+};
+
+class ProgramGenerator
+{
+    public:
+        explicit ProgramGenerator(const GenOptions& options)
+            : m_options(options)
+            , m_rng(options.seed)
+        {
+        }
+
+        std::string generate()
+        {
+            for (size_t i = 0; i < std::max<size_t>(m_options.idents, 1); i++)
+                declare(0);
+
+            size_t budget = m_options.stmts;
+
+            gen_block(0, budget);
+
+            m_out += "Beende mit " + m_visible.front() + ".\n";
+
+            return std::move(m_out);
+        }
+
+    private:
+        size_t roll(const size_t bound)
+        {
+            return std::uniform_int_distribution<size_t>(0, bound - 1)(m_rng);
+        }
+
+        bool chance(const size_t percent)
+        {
+            return roll(100) < percent;
+        }
+
+        void indent(const size_t depth)
+        {
+            m_out.append(depth * 4, ' ');
+        }
+
+        // Every name is unique, so scopes never shadow each other
+        std::string new_name()
+        {
+            static constexpr std::string_view ascii[] = { "Wert", "Summe", "Zahl", "Index", "Rest" };
+            static constexpr std::string_view german[] = { "Größe", "Äpfel", "Maß", "Übertrag", "Öffnung", "Fuß" };
+
+            const std::string_view stem = chance(m_options.umlauts) ? german[roll(std::size(german))] : ascii[roll(std::size(ascii))];
+
+            return std::string(stem) + std::to_string(m_next_name++);
+        }
+
+        const std::string& pick()
+        {
+            return m_visible[roll(m_visible.size())];
+        }
+
+        void declare(const size_t depth)
+        {
+            const std::string name = new_name();
+
+            indent(depth);
+            m_out += "Bestimme " + name + " als " + std::to_string(roll(1000)) + ".\n";
+
+            m_visible.push_back(name);
+        }
+
+        void gen_expr(const size_t depth)
+        {
+            if (depth == 0 || chance(25))
+            {
+                if (chance(60))
+                    m_out += pick();
+                else
+                    m_out += std::to_string(roll(1000));
+
+                return;
+            }
+
+            const bool paren = chance(30);
+
+            if (paren)
+                m_out += "(";
+
+            gen_expr(depth - 1);
+
+            // Only literal divisors, so constant folding never meets a division by zero
+            switch (roll(4))
+            {
+                case 0: m_out += " + "; gen_expr(depth - 1); break;
+                case 1: m_out += " - "; gen_expr(depth - 1); break;
+                case 2: m_out += " * "; gen_expr(depth - 1); break;
+                default: m_out += " / " + std::to_string(1 + roll(9)); break;
+            }
+
+            if (paren)
+                m_out += ")";
+        }
+
+        void gen_condition()
+        {
+            static constexpr std::string_view comparisons[] = {
+                " gleich ", " ungleich ", " kleiner ", " größer ", " kleiner gleich ", " größer gleich "
+            };
+
+            gen_expr(1);
+            m_out += comparisons[roll(std::size(comparisons))];
+            gen_expr(1);
+        }
+
+        void gen_block(const size_t depth, size_t& budget)
+        {
+            const size_t visible = m_visible.size();
+
+            // Nested blocks stay short, so the budget spreads over many of them
+            size_t count = depth == 0 ? SIZE_MAX : 1 + roll(4);
+
+            while (budget > 0 && count-- > 0)
+            {
+                budget--;
+
+                const size_t kind = roll(10);
+
+                if (depth < m_options.depth && kind < 2)
+                {
+                    indent(depth);
+                    m_out += "Falls (";
+                    gen_condition();
+                    m_out += ") dann {\n";
+
+                    gen_block(depth + 1, budget);
+
+                    indent(depth);
+                    m_out += "}";
+
+                    if (chance(40))
+                    {
+                        m_out += " Sonst {\n";
+
+                        gen_block(depth + 1, budget);
+
+                        indent(depth);
+                        m_out += "}";
+                    }
+
+                    m_out += "\n";
+                }
+                else if (depth < m_options.depth && kind < 3)
+                {
+                    indent(depth);
+                    m_out += "{\n";
+
+                    gen_block(depth + 1, budget);
+
+                    indent(depth);
+                    m_out += "}\n";
+                }
+                else if (kind < 5)
+                {
+                    declare(depth);
+                }
+                else
+                {
+                    indent(depth);
+                    m_out += "Ändere " + pick() + " zu ";
+                    gen_expr(m_options.expr_depth);
+                    m_out += ".\n";
+                }
+
+                if (chance(m_options.comments))
+                {
+                    indent(depth);
+
+                    if (chance(50))
+                        m_out += "// Zeilenkommentar über Größen und Maße\n";
+                    else
+                        m_out += "/* Blockkommentar\n   über zwei Zeilen */\n";
+                }
+            }
+
+            m_visible.resize(visible);
+        }
+
+        const GenOptions& m_options;
+        std::mt19937_64 m_rng;
+
+        std::string m_out;
+        std::vector<std::string> m_visible;
+        size_t m_next_name = 0;
+};
+
+static std::optional<GenOptions> parse_args(int argc, char* argv[])
+{
+    GenOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        size_t* target = arg == "--stmts"      ? &options.stmts
+                       : arg == "--depth"      ? &options.depth
+                       : arg == "--expr-depth" ? &options.expr_depth
+                       : arg == "--idents"     ? &options.idents
+                       : arg == "--comments"   ? &options.comments
+                       : arg == "--umlauts"    ? &options.umlauts
+                       : arg == "--seed"       ? &options.seed
+                       : nullptr;
+
+        if (target == nullptr || i + 1 >= argc)
+        {
+            std::cerr << "Fehler: Unbekannte oder unvollständige Option '" << arg << "'" << std::endl;
+
+            return std::nullopt;
+        }
+
+        const std::string_view value = argv[++i];
+
+        if (std::from_chars(value.data(), value.data() + value.size(), *target).ec != std::errc{})
+        {
+            std::cerr << "Fehler: Ungültiger Wert '" << value << "' für '" << arg << "'" << std::endl;
+
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::optional<GenOptions> options = parse_args(argc, argv);
+
+    if (!options.has_value())
+    {
+        std::cerr << "Verwendung: denkgen [--stmts N] [--depth N] [--expr-depth N] [--idents N] [--comments N] [--umlauts N] [--seed N]" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::cout << ProgramGenerator(options.value()).generate();
+
+    return EXIT_SUCCESS;
+}
@@ -1,38 +1,43 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 #include <utility>
 #include <new>
+#include <vector>
 
 class ArenaAllocator
 {
     public:
-        explicit ArenaAllocator(const size_t max_num_bytes)
-            : m_size(max_num_bytes)
-            , m_buffer(new std::byte[max_num_bytes])
-            , m_offset(m_buffer)
+        // 'chunk_size' is the size of the first chunk; once it is full a chunk twice the size of the last one follows
+        explicit ArenaAllocator(const size_t chunk_size)
         {
+            add_chunk(chunk_size);
         }
 
         // Disable copy semantics to avoid double deletion
         ArenaAllocator(const ArenaAllocator&) = delete;
         ArenaAllocator& operator=(const ArenaAllocator&) = delete;
 
-        // Move constructor: transfer ownership of buffer and size
+        // Move constructor: transfer ownership of the chunks
         ArenaAllocator(ArenaAllocator&& other) noexcept
-            : m_size(std::exchange(other.m_size, 0))
-            , m_buffer(std::exchange(other.m_buffer, nullptr))
+            : m_chunks(std::move(other.m_chunks))
+            , m_chunk(std::exchange(other.m_chunk, 0))
             , m_offset(std::exchange(other.m_offset, nullptr))
+            , m_filled(std::exchange(other.m_filled, 0))
+            , m_high_water(std::exchange(other.m_high_water, 0))
         {
         }
 
         // Move assignment operator: swap resources safely
         ArenaAllocator& operator=(ArenaAllocator&& other) noexcept
         {
-            std::swap(m_size, other.m_size);
-            std::swap(m_buffer, other.m_buffer);
+            std::swap(m_chunks, other.m_chunks);
+            std::swap(m_chunk, other.m_chunk);
             std::swap(m_offset, other.m_offset);
+            std::swap(m_filled, other.m_filled);
+            std::swap(m_high_water, other.m_high_water);
 
             return *this;
         }
@@ -41,20 +46,27 @@ class ArenaAllocator
         template <typename T>
         [[nodiscard]] T* alloc()
         {
-            size_t remaining_num_bytes = m_size - static_cast<size_t>(m_offset - m_buffer);
+            while (true)
+            {
+                const Chunk& chunk = m_chunks[m_chunk];
 
-            void* ptr = m_offset;
+                size_t remaining_num_bytes = chunk.size - static_cast<size_t>(m_offset - chunk.data.get());
 
-            // Align pointer to alignment requirement of T and adjust remaining size
-            void* aligned_address = std::align(alignof(T), sizeof(T), ptr, remaining_num_bytes);
+                void* ptr = m_offset;
 
-            if (aligned_address == nullptr)
-                throw std::bad_alloc{};
+                // Align pointer to alignment requirement of T and adjust remaining size
+                void* aligned_address = std::align(alignof(T), sizeof(T), ptr, remaining_num_bytes);
 
-            // Move offset pointer past allocated space
-            m_offset = static_cast<std::byte*>(aligned_address) + sizeof(T);
+                if (aligned_address != nullptr)
+                {
+                    // Move offset pointer past allocated space
+                    m_offset = static_cast<std::byte*>(aligned_address) + sizeof(T);
 
-            return static_cast<T*>(aligned_address);
+                    return static_cast<T*>(aligned_address);
+                }
+
+                next_chunk(sizeof(T) + alignof(T));
+            }
         }
 
         // Allocate and construct an object of type T with given arguments
@@ -66,15 +78,67 @@ class ArenaAllocator
             return new (memory) T(std::forward<Args>(args)...);
         }
 
-        ~ArenaAllocator()
+        // Release every allocation at once so the chunks can be reused for the next compilation
+        void reset()
+        {
+            m_high_water = high_water();
+            m_chunk = 0;
+            m_offset = m_chunks.front().data.get();
+            m_filled = 0;
+        }
+
+        // Bytes handed out since the last reset, including alignment padding
+        size_t used() const
+        {
+            return m_filled + static_cast<size_t>(m_offset - m_chunks[m_chunk].data.get());
+        }
+
+        // Largest 'used()' ever reached; tracked on reset so allocation stays a pointer bump
+        size_t high_water() const
         {
-            // Note: destructors of stored objects are NOT called automatically.
-            // Users must manually destroy objects if needed to avoid resource leaks.
-            delete[] m_buffer;
+            return std::max(m_high_water, used());
         }
+
+        // Note: destructors of stored objects are NOT called automatically.
+        // Users must manually destroy objects if needed to avoid resource leaks.
+        ~ArenaAllocator() = default;
     
     private:
-        size_t m_size;          // total size of buffer in bytes
-        std::byte* m_buffer;    // start of the buffer
-        std::byte* m_offset;    // current allocation offset pointer
-};
\ No newline at end of file
+        struct Chunk
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+
+        void add_chunk(const size_t size)
+        {
+            m_chunks.push_back({ std::make_unique_for_overwrite<std::byte[]>(size), size });
+            m_chunk = m_chunks.size() - 1;
+            m_offset = m_chunks.back().data.get();
+        }
+
+        // Moves on to the next chunk kept from an earlier compilation, or adds one, with room for at least 'min_size' bytes
+        void next_chunk(const size_t min_size)
+        {
+            m_filled += static_cast<size_t>(m_offset - m_chunks[m_chunk].data.get());
+
+            if (m_chunk + 1 < m_chunks.size() && m_chunks[m_chunk + 1].size >= min_size)
+            {
+                m_chunk++;
+                m_offset = m_chunks[m_chunk].data.get();
+
+                return;
+            }
+
+            // Chunks after this one are too small, so they are dropped instead of skipped
+            m_chunks.erase(m_chunks.begin() + static_cast<ptrdiff_t>(m_chunk) + 1, m_chunks.end());
+
+            add_chunk(std::max(2 * m_chunks[m_chunk].size, min_size));
+        }
+
+        std::vector<Chunk> m_chunks;
+        size_t m_chunk = 0;             // index of the chunk allocations are taken from
+        std::byte* m_offset = nullptr;  // current allocation offset pointer in that chunk
+        size_t m_filled = 0;            // bytes handed out from the chunks before it
+        size_t m_high_water = 0;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
 #include <variant>
 
 #include "tokenizer.hpp"
@@ -18,12 +20,26 @@ struct NodeTermIdent
 
 struct NodeExpr; // Forward Declaration
 
+/* Array Element Node */
+struct NodeTermIndex
+{
+    Token ident;
+    NodeExpr* index;
+};
+
 /* Parenthesized Expression Node */
 struct NodeTermParen
 {
     NodeExpr* expr;
 };
 
+/* Function Call Node */
+struct NodeTermCall
+{
+    Token ident;
+    std::vector<NodeExpr*> args;
+};
+
 /* Binary Operators */
 enum class BinOp
 {
@@ -55,7 +71,7 @@ struct NodeLogicExpr
 /* Term Node */
 struct NodeTerm
 {
-    std::variant<NodeTermIntLit*, NodeTermIdent*, NodeTermParen*> var;
+    std::variant<NodeTermIntLit*, NodeTermIdent*, NodeTermIndex*, NodeTermParen*, NodeTermCall*> var;
 };
 
 /* Expression Node */
@@ -76,22 +92,38 @@ struct NodeScope
 struct NodeStmtBestimme
 {
     Token ident;
-    NodeExpr* expr;
+    NodeExpr* expr;     // nullptr for 'Feld' declarations
+    size_t length;      // number of elements of a 'Feld', 0 for scalars
 };
 
 /* Change Statement Node */
 struct NodeStmtÄndere
 {
     Token ident;
+    std::optional<NodeExpr*> index;
     NodeExpr* expr;
 };
 
+/* Hint on how often a 'Falls' takes its 'dann' branch */
+enum class BranchHint
+{
+    None, Likely, Unlikely
+};
+
 /* If Statement Node */
 struct NodeStmtFalls
 {
     NodeExpr* expr;
     NodeScope* scope;
     std::optional<NodeStmt*> sonst;
+    BranchHint hint = BranchHint::None;
+};
+
+/* While Loop Statement Node */
+struct NodeStmtSolange
+{
+    NodeExpr* expr;
+    NodeScope* scope;
 };
 
 /* Exit Statement Node */
@@ -100,14 +132,346 @@ struct NodeStmtBeende
     NodeExpr* expr;
 };
 
+/* Output Statement Node */
+struct NodeStmtSchreibe
+{
+    NodeExpr* expr;
+};
+
+/* Input Statement Node */
+struct NodeStmtLies
+{
+    Token ident;
+};
+
+/* Function Definition Node, only at the top level */
+struct NodeStmtFunktion
+{
+    Token ident;
+    std::vector<Token> params;
+    NodeScope* scope;
+};
+
+/* Return Statement Node, only inside a 'Funktion' */
+struct NodeStmtGib
+{
+    NodeExpr* expr;
+    uint32_t offset;    // of 'Gib'
+};
+
 /* Statement Node */
 struct NodeStmt
 {
-    std::variant<NodeScope*, NodeStmtBestimme*, NodeStmtÄndere*, NodeStmtFalls*, NodeStmtBeende*> var;
+    std::variant<NodeScope*, NodeStmtBestimme*, NodeStmtÄndere*, NodeStmtFalls*, NodeStmtSolange*, NodeStmtBeende*,
+                 NodeStmtSchreibe*, NodeStmtLies*, NodeStmtFunktion*, NodeStmtGib*> var;
+};
+
+/* Node Kinds, for the flat trees of '--emit-ast' and the constexpr front end */
+enum class AstKind : uint8_t
+{
+    IntLit, Ident, Index, Paren, BinExpr, LogicExpr,
+    Scope, Bestimme, Ändere, Falls, Solange, Beende, Schreibe, Lies,
+    Call, Funktion, Gib
 };
 
 /* Program Root Node */
 struct NodeProg
 {
     std::vector<NodeStmt*> stmts;
-};
\ No newline at end of file
+};
+
+/* Node Counting, a size measure for heuristics and statistics */
+inline size_t count_nodes(const NodeExpr* expr)
+{
+    if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+    {
+        if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+            return count_nodes((*paren)->expr);
+
+        if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+            return 1 + count_nodes((*index)->index);
+
+        if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+        {
+            size_t count = 1;
+
+            for (const NodeExpr* arg : (*call)->args)
+                count += count_nodes(arg);
+
+            return count;
+        }
+
+        return 1;
+    }
+
+    if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+        return 1 + count_nodes((*bin_expr)->lhs) + count_nodes((*bin_expr)->rhs);
+
+    const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+    return 1 + count_nodes(logic_expr->lhs) + count_nodes(logic_expr->rhs);
+}
+
+inline size_t count_nodes(const std::vector<NodeStmt*>& stmts)
+{
+    struct Visitor
+    {
+        size_t operator()(const NodeScope* scope) const { return count_nodes(scope->stmts); }
+
+        size_t operator()(const NodeStmtBestimme* s) const { return 1 + (s->expr != nullptr ? count_nodes(s->expr) : 0); }
+
+        size_t operator()(const NodeStmtÄndere* s) const
+        {
+            return 1 + (s->index.has_value() ? count_nodes(s->index.value()) : 0) + count_nodes(s->expr);
+        }
+
+        size_t operator()(const NodeStmtFalls* s) const
+        {
+            return 1 + count_nodes(s->expr) + count_nodes(s->scope->stmts)
+                     + (s->sonst.has_value() ? count_nodes({ s->sonst.value() }) : 0);
+        }
+
+        size_t operator()(const NodeStmtSolange* s) const
+        {
+            return 1 + count_nodes(s->expr) + count_nodes(s->scope->stmts);
+        }
+
+        size_t operator()(const NodeStmtBeende* s) const { return 1 + count_nodes(s->expr); }
+
+        size_t operator()(const NodeStmtSchreibe* s) const { return 1 + count_nodes(s->expr); }
+
+        size_t operator()(const NodeStmtLies*) const { return 1; }
+
+        size_t operator()(const NodeStmtFunktion* s) const { return 1 + count_nodes(s->scope->stmts); }
+
+        size_t operator()(const NodeStmtGib* s) const { return 1 + count_nodes(s->expr); }
+    };
+
+    size_t count = 0;
+
+    for (const NodeStmt* stmt : stmts)
+        count += std::visit(Visitor{}, stmt->var);
+
+    return count;
+}
+
+/* Source Rendering, a readable form of a node for profiles and reports */
+inline std::string format_expr(const NodeExpr* expr)
+{
+    if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+    {
+        struct Visitor
+        {
+            std::string operator()(const NodeTermIntLit* t) const { return t->int_lit.value.value(); }
+
+            std::string operator()(const NodeTermIdent* t) const { return t->ident.value.value(); }
+
+            std::string operator()(const NodeTermIndex* t) const { return t->ident.value.value() + "[" + format_expr(t->index) + "]"; }
+
+            std::string operator()(const NodeTermParen* t) const { return std::string("(").append(format_expr(t->expr)).append(")"); }
+
+            std::string operator()(const NodeTermCall* t) const
+            {
+                std::string text = t->ident.value.value() + "(";
+
+                for (size_t i = 0; i < t->args.size(); i++)
+                    text.append(i > 0 ? ", " : "").append(format_expr(t->args[i]));
+
+                return text.append(")");
+            }
+        };
+
+        return std::visit(Visitor{}, (*term)->var);
+    }
+
+    if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+    {
+        static constexpr const char* ops[] = { " + ", " - ", " * ", " / " };
+
+        return format_expr((*bin_expr)->lhs) + ops[static_cast<size_t>((*bin_expr)->op)] + format_expr((*bin_expr)->rhs);
+    }
+
+    static constexpr const char* ops[] = { " ungleich ", " gleich ", " kleiner ", " kleiner gleich ", " größer ", " größer gleich " };
+
+    const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+    return format_expr(logic_expr->lhs) + ops[static_cast<size_t>(logic_expr->op)] + format_expr(logic_expr->rhs);
+}
+
+inline std::string hint_text(const BranchHint hint)
+{
+    static constexpr const char* hints[] = { "", " wahrscheinlich", " unwahrscheinlich" };
+
+    return hints[static_cast<size_t>(hint)];
+}
+
+// The statement's first line, without nested statements
+inline std::string describe_stmt(const NodeStmt* stmt)
+{
+    struct Visitor
+    {
+        std::string operator()(const NodeScope*) const { return "{ … }"; }
+
+        std::string operator()(const NodeStmtBestimme* s) const
+        {
+            return "Bestimme " + s->ident.value.value() + " als "
+                 + (s->expr != nullptr ? format_expr(s->expr) : "Feld[" + std::to_string(s->length) + "]");
+        }
+
+        std::string operator()(const NodeStmtÄndere* s) const
+        {
+            return "Ändere " + s->ident.value.value() + (s->index.has_value() ? "[" + format_expr(s->index.value()) + "]" : "")
+                 + " zu " + format_expr(s->expr);
+        }
+
+        std::string operator()(const NodeStmtFalls* s) const
+        {
+            return "Falls (" + format_expr(s->expr) + ")" + hint_text(s->hint) + " dann";
+        }
+
+        std::string operator()(const NodeStmtSolange* s) const { return "Solange (" + format_expr(s->expr) + ") dann"; }
+
+        std::string operator()(const NodeStmtBeende* s) const { return "Beende mit " + format_expr(s->expr); }
+
+        std::string operator()(const NodeStmtSchreibe* s) const { return "Schreibe " + format_expr(s->expr); }
+
+        std::string operator()(const NodeStmtLies* s) const { return "Lies " + s->ident.value.value(); }
+
+        std::string operator()(const NodeStmtFunktion* s) const
+        {
+            std::string text = "Funktion " + s->ident.value.value() + "(";
+
+            for (size_t i = 0; i < s->params.size(); i++)
+                text.append(i > 0 ? ", " : "").append(s->params[i].value.value());
+
+            return text.append(")");
+        }
+
+        std::string operator()(const NodeStmtGib* s) const { return "Gib " + format_expr(s->expr) + " zurück"; }
+    };
+
+    return std::visit(Visitor{}, stmt->var);
+}
+
+/* Offset Shifting, for statements that are reused after an edit earlier in the source */
+inline void shift_offset(Token& token, const int64_t delta)
+{
+    token.offset = static_cast<uint32_t>(static_cast<int64_t>(token.offset) + delta);
+}
+
+inline void shift_offsets(NodeExpr* expr, const int64_t delta)
+{
+    if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+    {
+        struct Visitor
+        {
+            int64_t delta;
+
+            void operator()(NodeTermIntLit* t) const { shift_offset(t->int_lit, delta); }
+
+            void operator()(NodeTermIdent* t) const { shift_offset(t->ident, delta); }
+
+            void operator()(NodeTermIndex* t) const
+            {
+                shift_offset(t->ident, delta);
+                shift_offsets(t->index, delta);
+            }
+
+            void operator()(NodeTermParen* t) const { shift_offsets(t->expr, delta); }
+
+            void operator()(NodeTermCall* t) const
+            {
+                shift_offset(t->ident, delta);
+
+                for (NodeExpr* arg : t->args)
+                    shift_offsets(arg, delta);
+            }
+        };
+
+        std::visit(Visitor{ delta }, (*term)->var);
+    }
+    else if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+    {
+        shift_offsets((*bin_expr)->lhs, delta);
+        shift_offsets((*bin_expr)->rhs, delta);
+    }
+    else
+    {
+        const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+        shift_offsets(logic_expr->lhs, delta);
+        shift_offsets(logic_expr->rhs, delta);
+    }
+}
+
+inline void shift_offsets(NodeStmt* stmt, const int64_t delta)
+{
+    struct Visitor
+    {
+        int64_t delta;
+
+        void operator()(NodeScope* scope) const
+        {
+            for (NodeStmt* s : scope->stmts)
+                shift_offsets(s, delta);
+        }
+
+        void operator()(NodeStmtBestimme* s) const
+        {
+            shift_offset(s->ident, delta);
+
+            if (s->expr != nullptr)
+                shift_offsets(s->expr, delta);
+        }
+
+        void operator()(NodeStmtÄndere* s) const
+        {
+            shift_offset(s->ident, delta);
+
+            if (s->index.has_value())
+                shift_offsets(s->index.value(), delta);
+
+            shift_offsets(s->expr, delta);
+        }
+
+        void operator()(NodeStmtFalls* s) const
+        {
+            shift_offsets(s->expr, delta);
+            (*this)(s->scope);
+
+            if (s->sonst.has_value())
+                shift_offsets(s->sonst.value(), delta);
+        }
+
+        void operator()(NodeStmtSolange* s) const
+        {
+            shift_offsets(s->expr, delta);
+            (*this)(s->scope);
+        }
+
+        void operator()(NodeStmtBeende* s) const { shift_offsets(s->expr, delta); }
+
+        void operator()(NodeStmtSchreibe* s) const { shift_offsets(s->expr, delta); }
+
+        void operator()(NodeStmtLies* s) const { shift_offset(s->ident, delta); }
+
+        void operator()(NodeStmtFunktion* s) const
+        {
+            shift_offset(s->ident, delta);
+
+            for (Token& param : s->params)
+                shift_offset(param, delta);
+
+            (*this)(s->scope);
+        }
+
+        void operator()(NodeStmtGib* s) const
+        {
+            s->offset = static_cast<uint32_t>(static_cast<int64_t>(s->offset) + delta);
+
+            shift_offsets(s->expr, delta);
+        }
+    };
+
+    std::visit(Visitor{ delta }, stmt->var);
+}
@@ -0,0 +1,850 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Binary AST written by '--emit-ast' as '<stem>.dast', read in place without pointer fix-ups:
+ *
+ *   AstHeader   magic, version, size and the absolute offsets of the program and the string table
+ *   nodes       fixed-size 'AstNode' records in post-order, so every child comes before its parent
+ *   lists       a count followed by that many references, for scopes and the program
+ *   strings     a count, then (offset, length) per string, then the bytes; every name and literal once
+ *
+ * References between records are offsets relative to the reference itself, so the file works at any address.
+ * All fields are 32-bit little-endian and 4-byte aligned.
+ */
+static_assert(std::endian::native == std::endian::little, "Das AST-Format ist little-endian");
+
+inline constexpr char AST_MAGIC[8] = { 'D', 'E', 'N', 'K', 'A', 'S', 'T', '\0' };
+inline constexpr uint32_t AST_VERSION = 4;
+
+struct AstNode;
+struct AstList;
+
+/* Reference to another record, 0 for none */
+struct AstRef
+{
+    int32_t delta = 0;
+
+    template <typename T>
+    const T* get() const
+    {
+        return delta == 0 ? nullptr : reinterpret_cast<const T*>(reinterpret_cast<const std::byte*>(this) + delta);
+    }
+};
+
+/* Count-prefixed list of references, the references follow the count */
+struct AstList
+{
+    uint32_t count;
+
+    uint32_t size() const
+    {
+        return count;
+    }
+
+    const AstNode& operator[](const size_t i) const
+    {
+        return *reinterpret_cast<const AstRef*>(this + 1)[i].get<AstNode>();
+    }
+};
+
+/*
+ * One node, with the fields its kind uses:
+ *
+ *   IntLit, Ident       text, offset
+ *   Index               text, offset, index()
+ *   Paren               expr()
+ *   BinExpr, LogicExpr  op, lhs(), rhs()
+ *   Scope               stmts()
+ *   Bestimme            text, offset, expr() or length for a 'Feld'
+ *   Ändere              text, offset, index() if it has one, expr()
+ *   Falls               op as 'BranchHint', expr(), scope(), sonst() if it has one
+ *   Solange             expr(), scope()
+ *   Beende, Schreibe    expr()
+ *   Lies                text, offset
+ *   Call                text, offset, args()
+ *   Funktion            text, offset, params() as 'Ident' nodes, scope()
+ *   Gib                 offset of 'Gib', expr()
+ */
+struct AstNode
+{
+    AstKind kind;
+    uint8_t op = 0;         // 'BinOp', 'LogicOp' or 'BranchHint'
+    uint16_t reserved = 0;
+    uint32_t offset = 0;    // of the identifier or literal in the source
+    uint32_t text = 0;      // index into the string table
+    uint32_t length = 0;    // elements of a 'Feld'
+
+    AstRef first = {};
+    AstRef second = {};
+    AstRef third = {};
+
+    const AstNode* expr() const { return first.get<AstNode>(); }
+
+    const AstNode* lhs() const { return first.get<AstNode>(); }
+
+    const AstNode* rhs() const { return second.get<AstNode>(); }
+
+    const AstNode* index() const { return second.get<AstNode>(); }
+
+    const AstNode* scope() const { return second.get<AstNode>(); }
+
+    const AstNode* sonst() const { return third.get<AstNode>(); }
+
+    const AstList& stmts() const { return *first.get<AstList>(); }
+
+    const AstList& args() const { return *first.get<AstList>(); }
+
+    const AstList& params() const { return *first.get<AstList>(); }
+};
+
+struct AstHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t size;          // of the whole file
+    uint32_t nodes;
+    uint32_t program;       // the 'AstList' of top-level statements
+    uint32_t strings;
+};
+
+static_assert(sizeof(AstNode) == 28 && sizeof(AstHeader) == 28);
+
+/* Serialisation, in one pass over the tree */
+class AstWriter
+{
+    public:
+        std::string write(const NodeProg& prog)
+        {
+            m_out.assign(sizeof(AstHeader), '\0');
+
+            std::vector<uint32_t> stmts;
+
+            stmts.reserve(prog.stmts.size());
+
+            for (const NodeStmt* stmt : prog.stmts)
+                stmts.push_back(write(stmt));
+
+            const uint32_t program = write_list(stmts);
+            const uint32_t strings = position();
+
+            append(static_cast<uint32_t>(m_strings.size()));
+
+            uint32_t bytes = position() + static_cast<uint32_t>(m_strings.size() * 8);
+
+            for (const std::string_view string : m_strings)
+            {
+                append(bytes);
+                append(static_cast<uint32_t>(string.size()));
+
+                bytes += static_cast<uint32_t>(string.size());
+            }
+
+            for (const std::string_view string : m_strings)
+                m_out += string;
+
+            if (m_out.size() > UINT32_MAX)
+                compile_error("Fehler: Der AST ist zu groß für das AST-Format");
+
+            AstHeader header {};
+
+            std::memcpy(header.magic, AST_MAGIC, sizeof(AST_MAGIC));
+
+            header.version = AST_VERSION;
+            header.size = position();
+            header.nodes = m_nodes;
+            header.program = program;
+            header.strings = strings;
+
+            std::memcpy(m_out.data(), &header, sizeof(header));
+
+            return std::move(m_out);
+        }
+
+    private:
+        uint32_t position() const
+        {
+            return static_cast<uint32_t>(m_out.size());
+        }
+
+        void append(const uint32_t value)
+        {
+            m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        uint32_t intern(const std::string& string)
+        {
+            const auto [it, inserted] = m_string_ids.try_emplace(string, static_cast<uint32_t>(m_strings.size()));
+
+            if (inserted)
+                m_strings.push_back(it->first);
+
+            return it->second;
+        }
+
+        // Children are already written, so their references point backwards from the new record
+        uint32_t emit(AstNode node, const uint32_t first = 0, const uint32_t second = 0, const uint32_t third = 0)
+        {
+            const uint32_t at = position();
+
+            const auto link = [at](AstRef& ref, const uint32_t target, const size_t field)
+            {
+                if (target != 0)
+                    ref.delta = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + field));
+            };
+
+            link(node.first, first, offsetof(AstNode, first));
+            link(node.second, second, offsetof(AstNode, second));
+            link(node.third, third, offsetof(AstNode, third));
+
+            m_out.append(reinterpret_cast<const char*>(&node), sizeof(node));
+            m_nodes++;
+
+            return at;
+        }
+
+        uint32_t emit_token(const AstKind kind, const Token& token, const uint32_t first = 0, const uint32_t second = 0)
+        {
+            return emit({ .kind = kind, .offset = token.offset, .text = intern(token.value.value()) }, first, second);
+        }
+
+        uint32_t write_list(const std::vector<uint32_t>& items)
+        {
+            const uint32_t at = position();
+
+            append(static_cast<uint32_t>(items.size()));
+
+            for (const uint32_t item : items)
+                append(static_cast<uint32_t>(static_cast<int32_t>(static_cast<int64_t>(item) - static_cast<int64_t>(position()))));
+
+            return at;
+        }
+
+        uint32_t write(const NodeExpr* expr)
+        {
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                struct Visitor
+                {
+                    AstWriter& writer;
+
+                    uint32_t operator()(const NodeTermIntLit* t) const { return writer.emit_token(AstKind::IntLit, t->int_lit); }
+
+                    uint32_t operator()(const NodeTermIdent* t) const { return writer.emit_token(AstKind::Ident, t->ident); }
+
+                    uint32_t operator()(const NodeTermIndex* t) const
+                    {
+                        return writer.emit_token(AstKind::Index, t->ident, 0, writer.write(t->index));
+                    }
+
+                    uint32_t operator()(const NodeTermParen* t) const
+                    {
+                        return writer.emit({ .kind = AstKind::Paren }, writer.write(t->expr));
+                    }
+
+                    uint32_t operator()(const NodeTermCall* t) const
+                    {
+                        std::vector<uint32_t> args;
+
+                        args.reserve(t->args.size());
+
+                        for (const NodeExpr* arg : t->args)
+                            args.push_back(writer.write(arg));
+
+                        return writer.emit_token(AstKind::Call, t->ident, writer.write_list(args));
+                    }
+                };
+
+                return std::visit(Visitor{ *this }, (*term)->var);
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                const uint32_t lhs = write((*bin_expr)->lhs);
+                const uint32_t rhs = write((*bin_expr)->rhs);
+
+                return emit({ .kind = AstKind::BinExpr, .op = static_cast<uint8_t>((*bin_expr)->op) }, lhs, rhs);
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            const uint32_t lhs = write(logic_expr->lhs);
+            const uint32_t rhs = write(logic_expr->rhs);
+
+            return emit({ .kind = AstKind::LogicExpr, .op = static_cast<uint8_t>(logic_expr->op) }, lhs, rhs);
+        }
+
+        uint32_t write(const NodeScope* scope)
+        {
+            std::vector<uint32_t> stmts;
+
+            stmts.reserve(scope->stmts.size());
+
+            for (const NodeStmt* stmt : scope->stmts)
+                stmts.push_back(write(stmt));
+
+            return emit({ .kind = AstKind::Scope }, write_list(stmts));
+        }
+
+        uint32_t write(const NodeStmt* stmt)
+        {
+            struct Visitor
+            {
+                AstWriter& writer;
+
+                uint32_t operator()(const NodeScope* scope) const { return writer.write(scope); }
+
+                uint32_t operator()(const NodeStmtBestimme* s) const
+                {
+                    if (s->expr == nullptr)
+                        return writer.emit({ .kind = AstKind::Bestimme, .offset = s->ident.offset, .text = writer.intern(s->ident.value.value()),
+                                             .length = static_cast<uint32_t>(s->length) });
+
+                    return writer.emit_token(AstKind::Bestimme, s->ident, writer.write(s->expr));
+                }
+
+                uint32_t operator()(const NodeStmtÄndere* s) const
+                {
+                    const uint32_t index = s->index.has_value() ? writer.write(s->index.value()) : 0;
+                    const uint32_t expr = writer.write(s->expr);
+
+                    return writer.emit_token(AstKind::Ändere, s->ident, expr, index);
+                }
+
+                uint32_t operator()(const NodeStmtFalls* s) const
+                {
+                    const uint32_t expr = writer.write(s->expr);
+                    const uint32_t scope = writer.write(s->scope);
+                    const uint32_t sonst = s->sonst.has_value() ? writer.write(s->sonst.value()) : 0;
+
+                    return writer.emit({ .kind = AstKind::Falls, .op = static_cast<uint8_t>(s->hint) }, expr, scope, sonst);
+                }
+
+                uint32_t operator()(const NodeStmtSolange* s) const
+                {
+                    const uint32_t expr = writer.write(s->expr);
+                    const uint32_t scope = writer.write(s->scope);
+
+                    return writer.emit({ .kind = AstKind::Solange }, expr, scope);
+                }
+
+                uint32_t operator()(const NodeStmtBeende* s) const
+                {
+                    return writer.emit({ .kind = AstKind::Beende }, writer.write(s->expr));
+                }
+
+                uint32_t operator()(const NodeStmtSchreibe* s) const
+                {
+                    return writer.emit({ .kind = AstKind::Schreibe }, writer.write(s->expr));
+                }
+
+                uint32_t operator()(const NodeStmtLies* s) const
+                {
+                    return writer.emit_token(AstKind::Lies, s->ident);
+                }
+
+                uint32_t operator()(const NodeStmtFunktion* s) const
+                {
+                    std::vector<uint32_t> params;
+
+                    params.reserve(s->params.size());
+
+                    for (const Token& param : s->params)
+                        params.push_back(writer.emit_token(AstKind::Ident, param));
+
+                    const uint32_t scope = writer.write(s->scope);
+
+                    return writer.emit_token(AstKind::Funktion, s->ident, writer.write_list(params), scope);
+                }
+
+                uint32_t operator()(const NodeStmtGib* s) const
+                {
+                    return writer.emit({ .kind = AstKind::Gib, .offset = s->offset }, writer.write(s->expr));
+                }
+            };
+
+            return std::visit(Visitor{ *this }, stmt->var);
+        }
+
+        std::string m_out;
+        uint32_t m_nodes = 0;
+
+        std::unordered_map<std::string, uint32_t> m_string_ids;
+        std::vector<std::string_view> m_strings;   // keys of 'm_string_ids', which never move
+};
+
+inline std::string write_ast(const NodeProg& prog)
+{
+    return AstWriter().write(prog);
+}
+
+/* Read access to a serialised AST; the bytes stay owned by the caller */
+class AstView
+{
+    public:
+        // Checks the header and the string table; the nodes are trusted, see 'load_ast' for a checked walk
+        static std::optional<AstView> open(std::string_view bytes)
+        {
+            AstHeader header;
+
+            if (bytes.size() < sizeof(header) || reinterpret_cast<uintptr_t>(bytes.data()) % alignof(AstHeader) != 0)
+                return std::nullopt;
+
+            std::memcpy(&header, bytes.data(), sizeof(header));
+
+            if (std::memcmp(header.magic, AST_MAGIC, sizeof(AST_MAGIC)) != 0 || header.version != AST_VERSION || header.size != bytes.size()
+                || header.program % 4 != 0 || header.strings % 4 != 0 || header.program < sizeof(header) || header.program >= header.strings
+                || static_cast<uint64_t>(header.strings) + 4 > header.size)
+                return std::nullopt;
+
+            AstView view(bytes);
+
+            const uint32_t count = view.string_count();
+
+            if (static_cast<uint64_t>(header.strings) + 4 + static_cast<uint64_t>(count) * 8 > header.size)
+                return std::nullopt;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint32_t* entry = view.string_entry(i);
+
+                if (static_cast<uint64_t>(entry[0]) + entry[1] > header.size)
+                    return std::nullopt;
+            }
+
+            return view;
+        }
+
+        const AstList& program() const
+        {
+            return *reinterpret_cast<const AstList*>(m_bytes.data() + header().program);
+        }
+
+        std::string_view text(const uint32_t index) const
+        {
+            const uint32_t* entry = string_entry(index);
+
+            return m_bytes.substr(entry[0], entry[1]);
+        }
+
+        uint32_t nodes() const
+        {
+            return header().nodes;
+        }
+
+        uint32_t string_count() const
+        {
+            return *reinterpret_cast<const uint32_t*>(m_bytes.data() + header().strings);
+        }
+
+        std::string_view bytes() const
+        {
+            return m_bytes;
+        }
+
+    private:
+        explicit AstView(std::string_view bytes) : m_bytes(bytes) {}
+
+        const AstHeader& header() const
+        {
+            return *reinterpret_cast<const AstHeader*>(m_bytes.data());
+        }
+
+        const uint32_t* string_entry(const uint32_t index) const
+        {
+            return reinterpret_cast<const uint32_t*>(m_bytes.data() + header().strings + 4) + static_cast<size_t>(index) * 2;
+        }
+
+        std::string_view m_bytes;
+};
+
+/* Conversion into 'NodeProg' for the 'Generator', allocated in the arena like a parsed tree */
+class AstLoader
+{
+    public:
+        AstLoader(const AstView& view, ArenaAllocator& allocator)
+            : m_view(view)
+            , m_allocator(allocator)
+        {
+        }
+
+        NodeProg load()
+        {
+            NodeProg prog;
+
+            const AstList& program = list(&m_view.program(), m_view.bytes().size());
+
+            prog.stmts.reserve(program.size());
+
+            for (uint32_t i = 0; i < program.size(); i++)
+                prog.stmts.push_back(load_stmt(item(program, i, m_view.bytes().size())));
+
+            return prog;
+        }
+
+    private:
+        [[noreturn]] static void corrupt()
+        {
+            compile_error("Fehler: Die AST-Datei ist beschädigt");
+        }
+
+        size_t position_of(const void* record) const
+        {
+            return static_cast<size_t>(reinterpret_cast<const char*>(record) - m_view.bytes().data());
+        }
+
+        // Records only reference records before them, which bounds the walk even in a damaged file
+        const AstNode& node(const AstRef& ref, const size_t before) const
+        {
+            const int64_t at = static_cast<int64_t>(position_of(&ref)) + ref.delta;
+
+            if (ref.delta == 0 || at < static_cast<int64_t>(sizeof(AstHeader)) || at % 4 != 0
+                || static_cast<size_t>(at) + sizeof(AstNode) > before)
+                corrupt();
+
+            return *ref.get<AstNode>();
+        }
+
+        const AstList& list(const AstList* list, const size_t before) const
+        {
+            const size_t at = position_of(list);
+
+            if (at < sizeof(AstHeader) || at % 4 != 0 || at + 4 > before || at + 4 + static_cast<size_t>(list->count) * 4 > before)
+                corrupt();
+
+            return *list;
+        }
+
+        const AstNode& item(const AstList& list, const uint32_t i, const size_t before) const
+        {
+            return node(reinterpret_cast<const AstRef*>(&list + 1)[i], std::min(before, position_of(&list)));
+        }
+
+        Token token(const TokenType type, const AstNode& node) const
+        {
+            if (node.text >= m_view.string_count())
+                corrupt();
+
+            return { .type = type, .value = std::string(m_view.text(node.text)), .offset = node.offset };
+        }
+
+        NodeExpr* load_expr(const AstNode& n)
+        {
+            const size_t before = position_of(&n);
+
+            NodeExpr* expr = m_allocator.emplace<NodeExpr>();
+
+            const auto term = [&]<typename T>(T* t)
+            {
+                expr->var = m_allocator.emplace<NodeTerm>(NodeTerm{ t });
+            };
+
+            switch (n.kind)
+            {
+                case AstKind::IntLit:
+                    term(m_allocator.emplace<NodeTermIntLit>(NodeTermIntLit{ token(TokenType::int_lit, n) }));
+                    break;
+
+                case AstKind::Ident:
+                    term(m_allocator.emplace<NodeTermIdent>(NodeTermIdent{ token(TokenType::ident, n) }));
+                    break;
+
+                case AstKind::Index:
+                    term(m_allocator.emplace<NodeTermIndex>(NodeTermIndex{ token(TokenType::ident, n), load_expr(node(n.second, before)) }));
+                    break;
+
+                case AstKind::Paren:
+                    term(m_allocator.emplace<NodeTermParen>(NodeTermParen{ load_expr(node(n.first, before)) }));
+                    break;
+
+                case AstKind::BinExpr:
+                    if (n.op > static_cast<uint8_t>(BinOp::Div))
+                        corrupt();
+
+                    expr->var = m_allocator.emplace<NodeBinExpr>(NodeBinExpr{
+                        static_cast<BinOp>(n.op), load_expr(node(n.first, before)), load_expr(node(n.second, before)) });
+                    break;
+
+                case AstKind::LogicExpr:
+                    if (n.op > static_cast<uint8_t>(LogicOp::GreaterEqual))
+                        corrupt();
+
+                    expr->var = m_allocator.emplace<NodeLogicExpr>(NodeLogicExpr{
+                        static_cast<LogicOp>(n.op), load_expr(node(n.first, before)), load_expr(node(n.second, before)) });
+                    break;
+
+                case AstKind::Call:
+                {
+                    const AstList& args = list(n.first.get<AstList>(), before);
+
+                    NodeTermCall* call = m_allocator.emplace<NodeTermCall>(NodeTermCall{ token(TokenType::ident, n), {} });
+
+                    call->args.reserve(args.size());
+
+                    for (uint32_t i = 0; i < args.size(); i++)
+                        call->args.push_back(load_expr(item(args, i, before)));
+
+                    term(call);
+                    break;
+                }
+
+                default:
+                    corrupt();
+            }
+
+            return expr;
+        }
+
+        NodeScope* load_scope(const AstNode& n)
+        {
+            if (n.kind != AstKind::Scope)
+                corrupt();
+
+            const size_t before = position_of(&n);
+
+            const AstList& stmts = list(n.first.get<AstList>(), before);
+
+            NodeScope* scope = m_allocator.emplace<NodeScope>();
+
+            scope->stmts.reserve(stmts.size());
+
+            for (uint32_t i = 0; i < stmts.size(); i++)
+            {
+                scope->stmts.push_back(load_stmt(item(stmts, i, before)));
+
+                // Definitions only stand at the top level, as the parser enforces
+                if (std::holds_alternative<NodeStmtFunktion*>(scope->stmts.back()->var))
+                    corrupt();
+            }
+
+            return scope;
+        }
+
+        NodeStmt* load_stmt(const AstNode& n)
+        {
+            const size_t before = position_of(&n);
+
+            NodeStmt* stmt = m_allocator.emplace<NodeStmt>();
+
+            switch (n.kind)
+            {
+                case AstKind::Scope:
+                    stmt->var = load_scope(n);
+                    break;
+
+                case AstKind::Bestimme:
+                {
+                    if (n.first.delta == 0 && (n.length == 0 || n.length > Parser::MAX_ARRAY_LENGTH))
+                        corrupt();
+
+                    NodeExpr* expr = n.first.delta != 0 ? load_expr(node(n.first, before)) : nullptr;
+
+                    stmt->var = m_allocator.emplace<NodeStmtBestimme>(NodeStmtBestimme{ token(TokenType::ident, n), expr, expr != nullptr ? 0 : n.length });
+                    break;
+                }
+
+                case AstKind::Ändere:
+                {
+                    std::optional<NodeExpr*> index;
+
+                    if (n.second.delta != 0)
+                        index = load_expr(node(n.second, before));
+
+                    stmt->var = m_allocator.emplace<NodeStmtÄndere>(NodeStmtÄndere{ token(TokenType::ident, n), index, load_expr(node(n.first, before)) });
+                    break;
+                }
+
+                case AstKind::Falls:
+                {
+                    std::optional<NodeStmt*> sonst;
+
+                    if (n.op > static_cast<uint8_t>(BranchHint::Unlikely))
+                        corrupt();
+
+                    if (n.third.delta != 0)
+                        sonst = load_stmt(node(n.third, before));
+
+                    stmt->var = m_allocator.emplace<NodeStmtFalls>(NodeStmtFalls{
+                        load_expr(node(n.first, before)), load_scope(node(n.second, before)), sonst, static_cast<BranchHint>(n.op) });
+                    break;
+                }
+
+                case AstKind::Solange:
+                    stmt->var = m_allocator.emplace<NodeStmtSolange>(NodeStmtSolange{
+                        load_expr(node(n.first, before)), load_scope(node(n.second, before)) });
+                    break;
+
+                case AstKind::Beende:
+                    stmt->var = m_allocator.emplace<NodeStmtBeende>(NodeStmtBeende{ load_expr(node(n.first, before)) });
+                    break;
+
+                case AstKind::Schreibe:
+                    stmt->var = m_allocator.emplace<NodeStmtSchreibe>(NodeStmtSchreibe{ load_expr(node(n.first, before)) });
+                    break;
+
+                case AstKind::Lies:
+                    stmt->var = m_allocator.emplace<NodeStmtLies>(NodeStmtLies{ token(TokenType::ident, n) });
+                    break;
+
+                case AstKind::Funktion:
+                {
+                    const AstList& params = list(n.first.get<AstList>(), before);
+
+                    NodeStmtFunktion* funktion = m_allocator.emplace<NodeStmtFunktion>(NodeStmtFunktion{ token(TokenType::ident, n), {}, nullptr });
+
+                    funktion->params.reserve(params.size());
+
+                    for (uint32_t i = 0; i < params.size(); i++)
+                    {
+                        const AstNode& param = item(params, i, before);
+
+                        if (param.kind != AstKind::Ident)
+                            corrupt();
+
+                        funktion->params.push_back(token(TokenType::ident, param));
+                    }
+
+                    m_in_function = true;
+                    funktion->scope = load_scope(node(n.second, before));
+                    m_in_function = false;
+
+                    stmt->var = funktion;
+                    break;
+                }
+
+                case AstKind::Gib:
+                    if (!m_in_function)
+                        corrupt();
+
+                    stmt->var = m_allocator.emplace<NodeStmtGib>(NodeStmtGib{ load_expr(node(n.first, before)), n.offset });
+                    break;
+
+                default:
+                    corrupt();
+            }
+
+            return stmt;
+        }
+
+        const AstView& m_view;
+        ArenaAllocator& m_allocator;
+
+        bool m_in_function = false;     // 'Gib' only stands in a definition
+};
+
+inline NodeProg load_ast(const AstView& view, ArenaAllocator& allocator)
+{
+    return AstLoader(view, allocator).load();
+}
+
+/* A whole file in memory, mapped where the system allows it */
+class MappedFile
+{
+    public:
+        static std::optional<MappedFile> open(const std::filesystem::path& path)
+        {
+            MappedFile file;
+
+#ifndef _WIN32
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if (fd < 0)
+                return std::nullopt;
+
+            struct stat info;
+
+            if (fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (data != MAP_FAILED)
+                {
+                    file.m_data = data;
+                    file.m_size = static_cast<size_t>(info.st_size);
+                }
+            }
+
+            close(fd);
+
+            if (file.m_data != nullptr)
+                return file;
+#endif
+
+            std::ifstream in(path, std::ios::binary);
+
+            if (!in)
+                return std::nullopt;
+
+            file.m_copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+            return file;
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr))
+            , m_size(std::exchange(other.m_size, 0))
+            , m_copy(std::move(other.m_copy))
+        {
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_copy, other.m_copy);
+
+            return *this;
+        }
+
+        ~MappedFile()
+        {
+#ifndef _WIN32
+            if (m_data != nullptr)
+                munmap(m_data, m_size);
+#endif
+        }
+
+        std::string_view bytes() const
+        {
+            if (m_data != nullptr)
+                return { static_cast<const char*>(m_data), m_size };
+
+            return m_copy;
+        }
+
+    private:
+        MappedFile() = default;
+
+        void* m_data = nullptr;
+        size_t m_size = 0;
+        std::string m_copy;     // if the file could not be mapped
+};
@@ -0,0 +1,738 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "parser.hpp"
+
+/*
+ * Second back end behind '--emit-c': translates the tree into plain C for an optimizing C compiler, as a baseline for
+ * the native back end. The program behaves the same: arithmetic wraps around, a division by zero stops the program,
+ * an index out of range exits with 255, and 'Schreibe' and 'Lies' read and write the same text.
+ */
+class CGenerator
+{
+    public:
+        inline explicit CGenerator(NodeProg prog)
+            : m_prog(std::move(prog))
+            {}
+
+        std::string gen_prog()
+        {
+            m_output << PRELUDE;
+
+            // Every function is declared up front, so calls may come before the definition
+            for (const NodeStmt* stmt : m_prog.stmts)
+            {
+                if (const auto funktion = std::get_if<NodeStmtFunktion*>(&stmt->var))
+                {
+                    const Token& ident = (*funktion)->ident;
+
+                    if (!m_functions.emplace(ident.value.value(), *funktion).second)
+                    {
+                        compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' ist bereits definiert");
+                    }
+
+                    m_output << (m_functions.size() == 1 ? "\n" : "") << signature(*funktion) << ";\n";
+                }
+            }
+
+            m_output << "\nint main(void)\n{\n";
+
+            m_depth = 1;
+
+            for (const NodeStmt* stmt : m_prog.stmts)
+                gen_stmt(stmt);
+
+            line() << "fflush(stdout);\n";
+            line() << "return 0;\n";
+
+            m_output << "}\n";
+
+            for (const NodeStmt* stmt : m_prog.stmts)
+                if (const auto funktion = std::get_if<NodeStmtFunktion*>(&stmt->var))
+                    gen_function(*funktion);
+
+            return m_output.str();
+        }
+
+    private:
+        /* Internal State */
+        struct Var
+        {
+            std::string name;
+            size_t length = 0;      // number of elements of a 'Feld', 0 for scalars
+        };
+
+        const NodeProg m_prog;
+        std::stringstream m_output;
+
+        std::vector<Var> m_vars;
+        std::vector<size_t> m_scopes;
+
+        std::unordered_map<std::string, const NodeStmtFunktion*> m_functions;
+        bool m_in_function = false;
+
+        size_t m_depth = 0;
+        size_t m_temp_count = 0;
+
+        // Runtime of every program; the helpers keep C's undefined behaviour out of the translated code
+        static constexpr const char* PRELUDE =
+            "#include <stdint.h>\n"
+            "#include <stdio.h>\n"
+            "#include <stdlib.h>\n"
+            "\n"
+            "static inline int64_t denk_add(int64_t a, int64_t b) { return (int64_t)((uint64_t)a + (uint64_t)b); }\n"
+            "static inline int64_t denk_sub(int64_t a, int64_t b) { return (int64_t)((uint64_t)a - (uint64_t)b); }\n"
+            "static inline int64_t denk_mul(int64_t a, int64_t b) { return (int64_t)((uint64_t)a * (uint64_t)b); }\n"
+            "\n"
+            "/* C truncates like 'idiv'; where 'idiv' traps, the program stops too */\n"
+            "static inline int64_t denk_div(int64_t a, int64_t b)\n"
+            "{\n"
+            "    if (b == 0 || (a == INT64_MIN && b == -1))\n"
+            "        abort();\n"
+            "\n"
+            "    return a / b;\n"
+            "}\n"
+            "\n"
+            "static inline int64_t denk_index(int64_t i, int64_t length)\n"
+            "{\n"
+            "    if ((uint64_t)i >= (uint64_t)length)\n"
+            "    {\n"
+            "        fflush(stdout);\n"
+            "        exit(255);\n"
+            "    }\n"
+            "\n"
+            "    return i;\n"
+            "}\n"
+            "\n"
+            "static void denk_write_int(int64_t value)\n"
+            "{\n"
+            "    printf(\"%lld\\n\", (long long)value);\n"
+            "}\n"
+            "\n"
+            "/* Anything but digits and '-' separates the numbers; 0 at the end of the input */\n"
+            "static int64_t denk_read_int(void)\n"
+            "{\n"
+            "    int c = getchar();\n"
+            "    int negative = 0;\n"
+            "\n"
+            "    for (;;)\n"
+            "    {\n"
+            "        if (c == EOF)\n"
+            "            return 0;\n"
+            "\n"
+            "        if (c >= '0' && c <= '9')\n"
+            "            break;\n"
+            "\n"
+            "        if (c == '-')\n"
+            "        {\n"
+            "            c = getchar();\n"
+            "\n"
+            "            if (c >= '0' && c <= '9')\n"
+            "            {\n"
+            "                negative = 1;\n"
+            "                break;\n"
+            "            }\n"
+            "\n"
+            "            continue;\n"
+            "        }\n"
+            "\n"
+            "        c = getchar();\n"
+            "    }\n"
+            "\n"
+            "    uint64_t value = 0;\n"
+            "\n"
+            "    while (c >= '0' && c <= '9')\n"
+            "    {\n"
+            "        value = value * 10 + (uint64_t)(c - '0');\n"
+            "        c = getchar();\n"
+            "    }\n"
+            "\n"
+            "    if (c != EOF)\n"
+            "        ungetc(c, stdin);\n"
+            "\n"
+            "    return (int64_t)(negative ? 0 - value : value);\n"
+            "}\n";
+
+        std::ostream& line()
+        {
+            return m_output << std::string(m_depth * 4, ' ');
+        }
+
+        /* Expression Generation */
+        std::string gen_expr(const NodeExpr* expr)
+        {
+            struct Visitor
+            {
+                CGenerator& gen;
+
+                std::string operator()(const NodeTerm* term) const { return gen.gen_term(term); }
+
+                std::string operator()(const NodeBinExpr* bin_expr) const
+                {
+                    static constexpr const char* helpers[] = { "denk_add", "denk_sub", "denk_mul", "denk_div" };
+
+                    return gen.gen_sequenced({ bin_expr->lhs, bin_expr->rhs }, std::string(helpers[static_cast<int>(bin_expr->op)]).append("("),
+                                             ", ", ")");
+                }
+
+                std::string operator()(const NodeLogicExpr* logic_expr) const
+                {
+                    static constexpr const char* operators[] = { " != ", " == ", " < ", " <= ", " > ", " >= " };
+
+                    return gen.gen_sequenced({ logic_expr->lhs, logic_expr->rhs }, "(int64_t)(", operators[static_cast<int>(logic_expr->op)], ")");
+                }
+            };
+
+            return std::visit(Visitor{ *this }, expr->var);
+        }
+
+        // C leaves the order of operands and arguments unspecified; once a call is among them they are bound to
+        // temporaries of a statement expression, so side effects happen left to right as in the native back end
+        std::string gen_sequenced(const std::vector<const NodeExpr*>& operands, std::string head, const char* separator, const char* tail)
+        {
+            const bool sequenced = operands.size() > 1 && std::ranges::any_of(operands, contains_call);
+
+            std::string temps;
+
+            for (size_t i = 0; i < operands.size(); i++)
+            {
+                std::string value = gen_expr(operands[i]);
+
+                if (sequenced)
+                {
+                    const std::string temp = "t" + std::to_string(m_temp_count++);
+
+                    temps.append("const int64_t ").append(temp).append(" = ").append(value).append("; ");
+
+                    value = temp;
+                }
+
+                head.append(i > 0 ? separator : "").append(value);
+            }
+
+            head.append(tail);
+
+            if (!sequenced)
+                return head;
+
+            return std::string("({ ").append(temps).append(head).append("; })");
+        }
+
+        static bool contains_call(const NodeExpr* expr)
+        {
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+                return contains_call((*bin_expr)->lhs) || contains_call((*bin_expr)->rhs);
+
+            if (const auto logic_expr = std::get_if<NodeLogicExpr*>(&expr->var))
+                return contains_call((*logic_expr)->lhs) || contains_call((*logic_expr)->rhs);
+
+            const NodeTerm* term = std::get<NodeTerm*>(expr->var);
+
+            if (const auto index = std::get_if<NodeTermIndex*>(&term->var))
+                return contains_call((*index)->index);
+
+            if (const auto paren = std::get_if<NodeTermParen*>(&term->var))
+                return contains_call((*paren)->expr);
+
+            return std::holds_alternative<NodeTermCall*>(term->var);
+        }
+
+        std::string gen_term(const NodeTerm* term)
+        {
+            struct Visitor
+            {
+                CGenerator& gen;
+
+                std::string operator()(const NodeTermIntLit* t) const { return literal(t->int_lit.value.value()); }
+
+                std::string operator()(const NodeTermIdent* t) const
+                {
+                    const Var* var = gen.find_var(t->ident.value.value());
+
+                    if (var == nullptr)
+                    {
+                        compile_error_at(t->ident.offset, "Fehler: Bezeichner '", t->ident.value.value(), "' ist nicht deklariert");
+                    }
+
+                    if (var->length > 0)
+                    {
+                        compile_error_at(t->ident.offset, "Fehler: Feld '", t->ident.value.value(), "' kann hier nur mit Index verwendet werden");
+                    }
+
+                    return mangle(var->name);
+                }
+
+                std::string operator()(const NodeTermIndex* t) const
+                {
+                    const Var& var = gen.find_array(t->ident);
+
+                    return mangle(var.name).append("[").append(gen.gen_index(var, t->index, t->ident)).append("]");
+                }
+
+                std::string operator()(const NodeTermParen* t) const
+                {
+                    return gen.gen_expr(t->expr);
+                }
+
+                std::string operator()(const NodeTermCall* t) const
+                {
+                    const NodeStmtFunktion* funktion = gen.find_function(t->ident, t->args.size());
+
+                    return gen.gen_sequenced({ t->args.begin(), t->args.end() }, mangle(funktion->ident.value.value(), "f_").append("("), ", ", ")");
+                }
+            };
+
+            return std::visit(Visitor{ *this }, term->var);
+        }
+
+        const NodeStmtFunktion* find_function(const Token& ident, const size_t args) const
+        {
+            const auto it = m_functions.find(ident.value.value());
+
+            if (it == m_functions.end())
+            {
+                compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' ist nicht definiert");
+            }
+
+            if (it->second->params.size() != args)
+            {
+                compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' erwartet ", it->second->params.size(),
+                                 " Argumente, nicht ", args);
+            }
+
+            return it->second;
+        }
+
+        // Literal indices are checked here like in the native back end, any other index at runtime
+        std::string gen_index(const Var& var, const NodeExpr* index_expr, const Token& ident)
+        {
+            if (const auto index = literal_value(index_expr))
+            {
+                if (index.value() < 0 || static_cast<size_t>(index.value()) >= var.length)
+                {
+                    compile_error_at(ident.offset, "Fehler: Index ", index.value(), " liegt außerhalb von Feld '", var.name,
+                                     "' (Länge ", var.length, ")");
+                }
+
+                return std::to_string(index.value());
+            }
+
+            return std::string("denk_index(").append(gen_expr(index_expr)).append(", ").append(std::to_string(var.length)).append(")");
+        }
+
+        // Literals wrap around like an immediate of the assembler; INT64_MIN has no literal of its own in C
+        static std::string literal(const std::string& text)
+        {
+            uint64_t value = 0;
+
+            for (const char c : text)
+                value = value * 10 + static_cast<uint64_t>(c - '0');
+
+            if (value == static_cast<uint64_t>(INT64_MIN))
+                return "INT64_MIN";
+
+            return std::string("INT64_C(").append(std::to_string(static_cast<int64_t>(value))).append(")");
+        }
+
+        // Value of an expression made of literals only; variables are left to the C compiler
+        static std::optional<int64_t> literal_value(const NodeExpr* expr)
+        {
+            const auto term = std::get_if<NodeTerm*>(&expr->var);
+
+            if (term != nullptr)
+            {
+                if (const auto int_lit = std::get_if<NodeTermIntLit*>(&(*term)->var))
+                {
+                    const std::string& text = (*int_lit)->int_lit.value.value();
+
+                    int64_t value = 0;
+
+                    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{})
+                        return std::nullopt;
+
+                    return value;
+                }
+
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    return literal_value((*paren)->expr);
+
+                return std::nullopt;
+            }
+
+            const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var);
+
+            if (bin_expr == nullptr || (*bin_expr)->op == BinOp::Div)
+                return std::nullopt;
+
+            const auto lhs = literal_value((*bin_expr)->lhs);
+            const auto rhs = literal_value((*bin_expr)->rhs);
+
+            if (!lhs.has_value() || !rhs.has_value())
+                return std::nullopt;
+
+            const uint64_t a = static_cast<uint64_t>(lhs.value());
+            const uint64_t b = static_cast<uint64_t>(rhs.value());
+
+            switch ((*bin_expr)->op)
+            {
+                case BinOp::Add: return static_cast<int64_t>(a + b);
+                case BinOp::Sub: return static_cast<int64_t>(a - b);
+                default:         return static_cast<int64_t>(a * b);
+            }
+        }
+
+        // DEnk names may hold umlauts; every byte outside of ASCII letters and digits becomes '_xx', and DEnk names
+        // have no '_' of their own, so the result is unique and never a C keyword. Functions get their own prefix.
+        static std::string mangle(const std::string& name, const char* prefix = "v_")
+        {
+            static constexpr char hex[] = "0123456789abcdef";
+
+            std::string result = prefix;
+
+            for (const char c : name)
+            {
+                const unsigned char byte = static_cast<unsigned char>(c);
+
+                if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9'))
+                    result += c;
+                else
+                    result.append("_").append(1, hex[byte >> 4]).append(1, hex[byte & 0x0F]);
+            }
+
+            return result;
+        }
+
+        /* Statement Generation */
+        void gen_stmt(const NodeStmt* stmt)
+        {
+            struct Visitor
+            {
+                CGenerator& gen;
+
+                void operator()(const NodeScope* scope) const
+                {
+                    gen.gen_scope(scope);
+                }
+
+                void operator()(const NodeStmtBestimme* s) const
+                {
+                    if (gen.find_var(s->ident.value.value()))
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' wird bereits verwendet");
+                    }
+
+                    gen.m_vars.push_back({ s->ident.value.value(), s->length });
+
+                    if (s->length > 0)
+                    {
+                        gen.line() << "int64_t " << mangle(s->ident.value.value()) << "[" << s->length << "] = { 0 };\n";
+
+                        return;
+                    }
+
+                    gen.line() << "int64_t " << mangle(s->ident.value.value()) << " = " << gen.gen_expr(s->expr) << ";\n";
+                }
+
+                void operator()(const NodeStmtÄndere* s) const
+                {
+                    const Var* var = gen.find_var(s->ident.value.value());
+
+                    if (var == nullptr)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' ist nicht deklariert");
+                    }
+
+                    if (s->index.has_value() || var->length > 0)
+                    {
+                        const Var& array = gen.find_array(s->ident);
+
+                        if (s->index.has_value())
+                        {
+                            // The index is evaluated before the value and checked after it, like in the native back end
+                            if (!literal_value(s->index.value()).has_value() && (contains_call(s->index.value()) || contains_call(s->expr)))
+                            {
+                                const std::string index = "t" + std::to_string(gen.m_temp_count++);
+                                const std::string value = "t" + std::to_string(gen.m_temp_count++);
+
+                                gen.line() << "{\n";
+                                gen.m_depth++;
+                                gen.line() << "const int64_t " << index << " = " << gen.gen_expr(s->index.value()) << ";\n";
+                                gen.line() << "const int64_t " << value << " = " << gen.gen_expr(s->expr) << ";\n";
+                                gen.line() << mangle(array.name) << "[denk_index(" << index << ", " << array.length << ")] = " << value << ";\n";
+                                gen.m_depth--;
+                                gen.line() << "}\n";
+
+                                return;
+                            }
+
+                            const std::string index = gen.gen_index(array, s->index.value(), s->ident);
+
+                            gen.line() << mangle(array.name) << "[" << index << "] = " << gen.gen_expr(s->expr) << ";\n";
+                        }
+                        else
+                            gen.gen_array_assign(array, s->expr, s->ident);
+
+                        return;
+                    }
+
+                    gen.line() << mangle(var->name) << " = " << gen.gen_expr(s->expr) << ";\n";
+                }
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    // gcc lays out the blocks from the hint; a path into 'exit' it already treats as cold
+                    if (s->hint != BranchHint::None)
+                        gen.line() << "if (__builtin_expect((" << gen.gen_expr(s->expr) << ") != 0, " << (s->hint == BranchHint::Likely) << "))\n";
+                    else
+                        gen.line() << "if (" << gen.gen_expr(s->expr) << ")\n";
+
+                    gen.gen_scope(s->scope);
+
+                    if (s->sonst.has_value())
+                    {
+                        gen.line() << "else\n";
+
+                        // An 'else if' chain would nest one level per 'Sonst Falls', so every branch gets braces
+                        if (std::holds_alternative<NodeScope*>(s->sonst.value()->var))
+                            gen.gen_stmt(s->sonst.value());
+                        else
+                        {
+                            gen.line() << "{\n";
+                            gen.m_depth++;
+                            gen.gen_stmt(s->sonst.value());
+                            gen.m_depth--;
+                            gen.line() << "}\n";
+                        }
+                    }
+                }
+
+                void operator()(const NodeStmtSolange* s) const
+                {
+                    gen.line() << "while (" << gen.gen_expr(s->expr) << ")\n";
+
+                    gen.gen_scope(s->scope);
+                }
+
+                void operator()(const NodeStmtBeende* s) const
+                {
+                    // Inside a function 'return' would only leave the function; 'exit' flushes stdout as well
+                    if (gen.m_in_function)
+                        gen.line() << "exit((int)" << gen.gen_expr(s->expr) << ");\n";
+                    else
+                        gen.line() << "return (int)" << gen.gen_expr(s->expr) << ";\n";
+                }
+
+                void operator()(const NodeStmtSchreibe* s) const
+                {
+                    gen.line() << "denk_write_int(" << gen.gen_expr(s->expr) << ");\n";
+                }
+
+                void operator()(const NodeStmtLies* s) const
+                {
+                    const Var* var = gen.find_var(s->ident.value.value());
+
+                    if (var == nullptr)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' ist nicht deklariert");
+                    }
+
+                    if (var->length > 0)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Feld '", s->ident.value.value(), "' kann nicht eingelesen werden");
+                    }
+
+                    gen.line() << mangle(var->name) << " = denk_read_int();\n";
+                }
+
+                // Generated after 'main'
+                void operator()(const NodeStmtFunktion*) const {}
+
+                void operator()(const NodeStmtGib* s) const
+                {
+                    if (!gen.m_in_function)
+                    {
+                        compile_error_at(s->offset, "Fehler: 'Gib ... zurück' ist nur in Funktionen erlaubt");
+                    }
+
+                    gen.line() << "return " << gen.gen_expr(s->expr) << ";\n";
+                }
+            };
+
+            std::visit(Visitor{ *this }, stmt->var);
+        }
+
+        void gen_scope(const NodeScope* scope)
+        {
+            line() << "{\n";
+
+            m_depth++;
+            m_scopes.push_back(m_vars.size());
+
+            for (const NodeStmt* stmt : scope->stmts)
+                gen_stmt(stmt);
+
+            m_vars.resize(m_scopes.back());
+            m_scopes.pop_back();
+            m_depth--;
+
+            line() << "}\n";
+        }
+
+        /* Function Generation */
+        static std::string signature(const NodeStmtFunktion* funktion)
+        {
+            std::string text = std::string("static int64_t ").append(mangle(funktion->ident.value.value(), "f_")).append("(");
+
+            for (size_t i = 0; i < funktion->params.size(); i++)
+                text.append(i > 0 ? ", " : "").append("int64_t ").append(mangle(funktion->params[i].value.value()));
+
+            return text.append(funktion->params.empty() ? "void)" : ")");
+        }
+
+        // A function sees its parameters and its own variables only; without 'Gib' at the end it returns 0
+        void gen_function(const NodeStmtFunktion* funktion)
+        {
+            m_output << "\n" << signature(funktion) << "\n{\n";
+
+            m_depth = 1;
+            m_in_function = true;
+            m_vars.clear();
+
+            for (const Token& param : funktion->params)
+                m_vars.push_back({ param.value.value() });
+
+            for (const NodeStmt* stmt : funktion->scope->stmts)
+                gen_stmt(stmt);
+
+            line() << "return 0;\n";
+
+            m_output << "}\n";
+
+            m_in_function = false;
+        }
+
+        /* Array Generation */
+        const Var& find_array(const Token& ident)
+        {
+            const Var* var = find_var(ident.value.value());
+
+            if (var == nullptr)
+            {
+                compile_error_at(ident.offset, "Fehler: Bezeichner '", ident.value.value(), "' ist nicht deklariert");
+            }
+
+            if (var->length == 0)
+            {
+                compile_error_at(ident.offset, "Fehler: Bezeichner '", ident.value.value(), "' ist kein Feld");
+            }
+
+            return *var;
+        }
+
+        const Var* array_operand(const NodeExpr* expr)
+        {
+            const NodeExpr* inner = expr;
+
+            while (const auto term = std::get_if<NodeTerm*>(&inner->var))
+            {
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+                {
+                    const Var* var = find_var((*ident)->ident.value.value());
+
+                    return var != nullptr && var->length > 0 ? var : nullptr;
+                }
+
+                const auto paren = std::get_if<NodeTermParen*>(&(*term)->var);
+
+                if (paren == nullptr)
+                    break;
+
+                inner = (*paren)->expr;
+            }
+
+            return nullptr;
+        }
+
+        // Same rules as the native back end: a whole array, a scalar, or one operator between arrays and scalars;
+        // scalars are evaluated once before the loop
+        void gen_array_assign(const Var& dst, const NodeExpr* expr, const Token& ident)
+        {
+            std::optional<BinOp> op;
+            std::vector<std::pair<const Var*, const NodeExpr*>> operands = { { array_operand(expr), expr } };
+
+            const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var);
+
+            if (operands[0].first == nullptr && bin_expr != nullptr &&
+                (array_operand((*bin_expr)->lhs) != nullptr || array_operand((*bin_expr)->rhs) != nullptr))
+            {
+                if ((*bin_expr)->op == BinOp::Div)
+                {
+                    compile_error_at(ident.offset, "Fehler: Felder unterstützen nur '+', '-' und '*'");
+                }
+
+                op = (*bin_expr)->op;
+                operands = { { array_operand((*bin_expr)->lhs), (*bin_expr)->lhs }, { array_operand((*bin_expr)->rhs), (*bin_expr)->rhs } };
+            }
+
+            for (const auto& [array, operand] : operands)
+            {
+                if (array != nullptr && array->length != dst.length)
+                {
+                    compile_error_at(ident.offset, "Fehler: Feld '", array->name, "' hat nicht die Länge von Feld '", dst.name, "'");
+                }
+            }
+
+            line() << "{\n";
+            m_depth++;
+
+            std::vector<std::string> elements;
+
+            for (const auto& [array, operand] : operands)
+            {
+                if (array != nullptr)
+                {
+                    elements.push_back(mangle(array->name) + "[i]");
+
+                    continue;
+                }
+
+                const std::string temp = "t" + std::to_string(m_temp_count++);
+
+                line() << "const int64_t " << temp << " = " << gen_expr(operand) << ";\n";
+
+                elements.push_back(temp);
+            }
+
+            static constexpr const char* helpers[] = { "denk_add", "denk_sub", "denk_mul", "denk_div" };
+
+            const std::string value = op.has_value()
+                ? std::string(helpers[static_cast<int>(op.value())]).append("(").append(elements[0]).append(", ").append(elements[1]).append(")")
+                : elements[0];
+
+            line() << "for (int64_t i = 0; i < " << dst.length << "; i++)\n";
+            line() << "    " << mangle(dst.name) << "[i] = " << value << ";\n";
+
+            m_depth--;
+            line() << "}\n";
+        }
+
+        /* Scope Helpers */
+        const Var* find_var(const std::string& name) const
+        {
+            for (const Var& var : m_vars)
+                if (var.name == name)
+                    return &var;
+
+            return nullptr;
+        }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "unique_id.hpp"
+
+/* Content-addressed store for build artifacts, keyed by everything that influences them */
+class BuildCache
+{
+    public:
+        BuildCache(std::filesystem::path dir, const uintmax_t max_bytes)
+            : m_dir(std::move(dir))
+            , m_max_bytes(max_bytes)
+        {
+        }
+
+        // Returns a 128-bit hex key over the source bytes and the fingerprint of compiler, target and options
+        static std::string key(std::string_view source, std::string_view fingerprint)
+        {
+            const uint64_t seed = hash(fingerprint, 0x9E3779B97F4A7C15ull);
+
+            const uint64_t lo = hash(source, seed);
+            const uint64_t hi = hash(source, seed ^ 0xC2B2AE3D27D4EB4Full);
+
+            return to_hex(hi) + to_hex(lo);
+        }
+
+        bool create_directory() const
+        {
+            std::error_code ec;
+
+            return std::filesystem::create_directories(m_dir, ec) || std::filesystem::is_directory(m_dir, ec);
+        }
+
+        // Copies every artifact of an entry to its destination; a missing artifact makes the whole entry a miss
+        bool fetch(const std::string& key, const std::vector<std::pair<std::string, std::filesystem::path>>& artifacts) const
+        {
+            std::error_code ec;
+
+            for (const auto& [ext, dst] : artifacts)
+            {
+                const std::filesystem::path src = entry_path(key, ext);
+
+                if (!std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing, ec))
+                    return false;
+
+                // Reading an entry marks it as recently used
+                std::filesystem::last_write_time(src, std::filesystem::file_time_type::clock::now(), ec);
+            }
+
+            return true;
+        }
+
+        // Copies to a unique temporary name first and renames it into place, so readers never see a partial file
+        bool store(const std::string& key, const std::string& ext, const std::filesystem::path& src) const
+        {
+            std::error_code ec;
+
+            const std::filesystem::path tmp = entry_path(key, ext) += "." + to_hex(unique_id()) + std::string(TMP_SUFFIX);
+
+            if (!std::filesystem::copy_file(src, tmp, std::filesystem::copy_options::overwrite_existing, ec))
+                return false;
+
+            std::filesystem::rename(tmp, entry_path(key, ext), ec);
+
+            if (ec)
+            {
+                std::filesystem::remove(tmp, ec);
+
+                return false;
+            }
+
+            return true;
+        }
+
+        // Removes the least recently used files until the cache fits into its size limit
+        void evict() const
+        {
+            struct Entry
+            {
+                std::filesystem::path path;
+                std::filesystem::file_time_type time;
+                uintmax_t size;
+            };
+
+            std::vector<Entry> entries;
+            uintmax_t total = 0;
+
+            std::error_code ec;
+
+            for (const auto& file : std::filesystem::directory_iterator(m_dir, ec))
+            {
+                if (!file.is_regular_file(ec) || file.path().string().ends_with(TMP_SUFFIX))
+                    continue;
+
+                const uintmax_t size = file.file_size(ec);
+
+                if (ec)
+                    continue;
+
+                entries.push_back({ file.path(), file.last_write_time(ec), size });
+                total += size;
+            }
+
+            if (total <= m_max_bytes)
+                return;
+
+            std::ranges::sort(entries, {}, &Entry::time);
+
+            for (const Entry& entry : entries)
+            {
+                if (total <= m_max_bytes)
+                    break;
+
+                // Another process may have evicted it already, which is just as good
+                std::filesystem::remove(entry.path, ec);
+
+                total -= entry.size;
+            }
+        }
+
+    private:
+        static constexpr std::string_view TMP_SUFFIX = ".tmp";
+
+        std::filesystem::path entry_path(const std::string& key, const std::string& ext) const
+        {
+            return m_dir / (key + ext);
+        }
+
+        // 64-bit multiply-rotate hash over 8-byte words (in the spirit of xxHash64)
+        static uint64_t hash(std::string_view data, uint64_t seed)
+        {
+            constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+            constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+
+            uint64_t h = seed ^ (data.size() * P1);
+            size_t i = 0;
+
+            for (; i + 8 <= data.size(); i += 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, data.data() + i, 8);
+
+                h ^= std::rotl(word * P2, 31) * P1;
+                h = std::rotl(h, 27) * P1 + P2;
+            }
+
+            for (; i < data.size(); i++)
+            {
+                h ^= static_cast<unsigned char>(data[i]) * P1;
+                h = std::rotl(h, 11) * P2;
+            }
+
+            h ^= h >> 33;
+            h *= P2;
+            h ^= h >> 29;
+            h *= P1;
+            h ^= h >> 32;
+
+            return h;
+        }
+
+        static std::string to_hex(uint64_t value)
+        {
+            static constexpr char digits[] = "0123456789abcdef";
+
+            std::string hex(16, '0');
+
+            for (size_t i = 0; i < 16; i++)
+                hex[15 - i] = digits[(value >> (i * 4)) & 0xF];
+
+            return hex;
+        }
+
+        std::filesystem::path m_dir;
+        uintmax_t m_max_bytes;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast_file.hpp"
+#include "c_generator.hpp"
+#include "diagnostics.hpp"
+#include "generator.hpp"
+#include "parallel_tokenizer.hpp"
+#include "parser.hpp"
+#include "process.hpp"
+#include "stats.hpp"
+#include "tokenizer.hpp"
+
+/* Options that change the generated artifacts */
+struct CompileOptions
+{
+    std::string format = "win64";   // NASM output format
+    bool assemble = false;          // also produce the object file
+    bool freestanding = false;      // Linux '_start' without libc, needs format "elf64"
+    bool emit_c = false;            // C instead of assembly in 'CompileResult::assembly', see 'c_generator.hpp'
+
+    // Instruments the program for '--profile-gen'; it writes its counters to this path on exit
+    std::optional<std::string> profile_path = std::nullopt;
+
+    // Threads for lexing and generating one large program; the output is the same for any value
+    size_t jobs = 1;
+
+    bool emit_ast = false;          // also serialise the tree, see 'ast_file.hpp'
+};
+
+struct CompileResult
+{
+    bool success = false;
+    std::string assembly;           // C source instead with 'CompileOptions::emit_c'
+    std::string object;             // only filled with 'CompileOptions::assemble'
+    std::string profile_map;        // only filled with 'CompileOptions::profile_path'
+    std::string ast;                // only filled with 'CompileOptions::emit_ast'
+    std::vector<Diagnostic> diagnostics;
+};
+
+/* In-process compiler that reports errors as diagnostics and keeps its arena warm between compilations */
+class Compiler
+{
+    public:
+        explicit Compiler(const size_t arena_size = 1024 * 1024 * 4)  // first chunk of 4 MB, the arena grows with the program
+            : m_allocator(arena_size)
+        {
+        }
+
+        // 'name' only labels statistics, diagnostics carry no file name
+        CompileResult compile(std::string_view source, const CompileOptions& options = {}, [[maybe_unused]] std::string_view name = {})
+        {
+            return run(options, name, [&]
+            {
+                std::vector<Token> tokens;
+
+                {
+                    DENK_PHASE("tokenize", name);
+
+                    tokens = tokenize_parallel(source, options.jobs);
+
+                    DENK_COUNT("source_bytes", source.size());
+                    DENK_COUNT("tokens", tokens.size());
+                }
+
+                std::optional<NodeProg> prog;
+
+                {
+                    DENK_PHASE("parse", name);
+
+                    Parser parser(std::move(tokens), m_allocator);
+                    prog = parser.parse_prog();
+
+                    DENK_COUNT("nodes", prog.has_value() ? count_nodes(prog->stmts) : 0);
+                    DENK_COUNT("arena_bytes", m_allocator.used());
+                    DENK_COUNT("arena_bytes_max", m_allocator.high_water());
+                }
+
+                if (!prog.has_value())
+                    compile_error("Fehler: Ungültiges Programm");
+
+                return std::move(prog.value());
+            });
+        }
+
+        // Starts from a tree written by '--emit-ast' instead of the source
+        CompileResult compile(const AstView& ast, const CompileOptions& options = {}, [[maybe_unused]] std::string_view name = {})
+        {
+            return run(options, name, [&]
+            {
+                DENK_PHASE("load", name);
+
+                NodeProg prog = load_ast(ast, m_allocator);
+
+                DENK_COUNT("nodes", ast.nodes());
+                DENK_COUNT("arena_bytes", m_allocator.used());
+
+                return prog;
+            });
+        }
+
+    private:
+        // Generates from the tree 'front_end' returns and reports errors of both as diagnostics
+        template <typename FrontEnd>
+        CompileResult run(const CompileOptions& options, [[maybe_unused]] std::string_view name, FrontEnd&& front_end)
+        {
+            CompileResult result;
+
+            m_allocator.reset();
+
+            try
+            {
+                NodeProg prog = front_end();
+
+                if (options.emit_ast)
+                {
+                    DENK_PHASE("emit_ast", name);
+
+                    result.ast = write_ast(prog);
+                }
+
+                DENK_PHASE("generate", name);
+
+                if (options.emit_c)
+                    result.assembly = CGenerator(std::move(prog)).gen_prog();
+                else
+                {
+                    Generator generator(std::move(prog), options.profile_path, options.freestanding, options.jobs);
+
+                    result.assembly = generator.gen_prog();
+
+                    if (options.profile_path.has_value())
+                        result.profile_map = generator.profile_map();
+                }
+
+                DENK_COUNT("asm_bytes", result.assembly.size());
+            }
+            catch (const CompileError& error)
+            {
+                result.diagnostics.push_back({ error.what(), error.offset() });
+
+                return result;
+            }
+            catch (const std::bad_alloc&)
+            {
+                result.diagnostics.push_back({ "Fehler: Das Programm ist zu groß für den Arbeitsspeicher des Compilers" });
+
+                return result;
+            }
+
+            if (options.assemble && !assemble(result, options))
+                return result;
+
+            result.success = true;
+
+            return result;
+        }
+
+        // NASM only reads and writes files, which stay in memory where the system allows it
+        static bool assemble(CompileResult& result, const CompileOptions& options)
+        {
+            const ScratchFile asm_file(".asm");
+            const ScratchFile obj_file(".o");
+
+            ProcessResult process;
+
+            if (asm_file.write(result.assembly))
+                process = run_process({ "nasm", "-f", options.format, asm_file.path(), "-o", obj_file.path() });
+
+            add_diagnostics(result, process.errors);
+
+            if (process.exit_code == 0)
+                result.object = obj_file.read().value_or("");
+
+            if (process.exit_code != 0 || result.object.empty())
+            {
+                result.diagnostics.push_back({ "Fehler: NASM-Assembler konnte nicht erfolgreich ausgeführt werden (" + std::to_string(process.exit_code) + ")" });
+
+                return false;
+            }
+
+            return true;
+        }
+
+        // One diagnostic per line of a tool's error output
+        static void add_diagnostics(CompileResult& result, std::string_view errors)
+        {
+            while (!errors.empty())
+            {
+                const size_t end = std::min(errors.find('\n'), errors.size());
+
+                if (end > 0)
+                    result.diagnostics.push_back({ std::string(errors.substr(0, end)) });
+
+                errors.remove_prefix(std::min(end + 1, errors.size()));
+            }
+        }
+
+        ArenaAllocator m_allocator;
+};
@@ -0,0 +1,1289 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "ast.hpp"
+#include "parser.hpp"
+#include "tokenizer.hpp"
+
+/*
+ * Front end that runs in constant evaluation, for DEnk programs embedded in C++ as string literals:
+ *
+ *   constexpr auto rules = const_parse(R"(Bestimme x als 0. Lies x. Beende mit x * 2.)");
+ *
+ *   static_assert(rules.has_value());
+ *
+ *   constexpr auto doubled = rules->tabulate<16>();     // the result for every input from 0 to 15
+ *
+ * Nodes live in a fixed-capacity arena and refer to each other by index, names are resolved to memory cells while
+ * parsing, and errors come back as a 'ConstError' instead of being thrown, so the checked program is a plain value
+ * and nothing is left to parse at run time. The checks and messages are those of the compiler, without the names in
+ * the messages; the offset points at the name instead. 'Funktion' and 'Gib' are left to the compiler and fail to parse.
+ */
+
+/* Error of the constexpr front end, returned in place of a 'CompileError' */
+struct ConstError
+{
+    const char* message = "";
+    uint32_t offset = 0;    // byte offset in the source
+};
+
+template <typename T>
+using ConstResult = std::expected<T, ConstError>;
+
+/* Fixed-capacity arena; slot 0 stays empty so that index 0 can mean no node, as in 'AstRef' */
+template <typename T, size_t Capacity>
+class ConstArena
+{
+    public:
+        constexpr std::optional<uint32_t> emplace(const T& item)
+        {
+            if (m_size == Capacity)
+                return std::nullopt;
+
+            m_items[m_size] = item;
+
+            return m_size++;
+        }
+
+        constexpr T& operator[](const uint32_t index)
+        {
+            return m_items[index];
+        }
+
+        constexpr const T& operator[](const uint32_t index) const
+        {
+            return m_items[index];
+        }
+
+        constexpr uint32_t size() const
+        {
+            return m_size;
+        }
+
+    private:
+        std::array<T, Capacity> m_items {};
+        uint32_t m_size = 1;
+};
+
+/*
+ * One node, with the fields its kind uses; children are arena indices, 0 for none:
+ *
+ *   IntLit              value
+ *   Ident               cell, length of a 'Feld' (only valid as an operand of a whole-'Feld' 'Ändere')
+ *   Index               cell, length, first for the index
+ *   Paren               first
+ *   BinExpr, LogicExpr  op, first, second
+ *   Scope               first statement, the others linked by 'next'
+ *   Bestimme            cell, length of a 'Feld' or first
+ *   Ändere              cell, first, third for an index; for a whole 'Feld' length, op, first and second
+ *   Falls               first, second for the scope, third for 'Sonst'
+ *   Solange             first, second for the scope
+ *   Beende, Schreibe    first
+ *   Lies                cell
+ */
+struct ConstNode
+{
+    AstKind kind = AstKind::IntLit;
+    uint8_t op = 0;         // 'BinOp' or 'LogicOp', 'NO_OP' for a whole 'Feld' taking one operand
+    uint32_t offset = 0;    // of the identifier or literal in the source
+    uint32_t cell = 0;      // first memory cell of the variable
+    uint32_t length = 0;    // elements of a 'Feld', 0 for scalars
+    int64_t value = 0;
+
+    uint32_t first = 0;
+    uint32_t second = 0;
+    uint32_t third = 0;
+    uint32_t next = 0;
+
+    static constexpr uint8_t NO_OP = 0xFF;
+};
+
+/* Result of one run: the value of 'Beende', 0 without one, and what 'Schreibe' wrote, none for 'Outputs' 0 */
+template <size_t Outputs>
+struct ConstRun
+{
+    int64_t result = 0;
+    std::array<int64_t, Outputs> output {};
+    uint32_t output_count = 0;
+};
+
+/*
+ * Executes a parsed program. Arithmetic wraps around like in the compiled program, and an index out of range ends
+ * the program with 255 like its bounds check does. Division by zero, an output overflow and running out of steps
+ * are errors, the last one so that an endless 'Solange' fails cleanly before the compiler's own loop limit.
+ */
+template <size_t Nodes, size_t Cells, size_t Outputs>
+class ConstEvaluator
+{
+    public:
+        constexpr ConstEvaluator(const ConstArena<ConstNode, Nodes>& nodes, const std::span<const int64_t> input, const uint64_t max_steps)
+            : m_nodes(nodes)
+            , m_input(input)
+            , m_steps_left(max_steps)
+        {
+        }
+
+        constexpr ConstResult<ConstRun<Outputs>> run(const uint32_t program)
+        {
+            exec_list(program);
+
+            if (m_error.has_value())
+                return std::unexpected(m_error.value());
+
+            return m_run;
+        }
+
+    private:
+        const ConstArena<ConstNode, Nodes>& m_nodes;
+        const std::span<const int64_t> m_input;
+        size_t m_input_pos = 0;
+        uint64_t m_steps_left;
+
+        std::array<int64_t, Cells> m_cells {};
+        ConstRun<Outputs> m_run {};
+
+        bool m_done = false;    // 'Beende' or an index out of range ended the program
+        std::optional<ConstError> m_error;
+
+        constexpr bool stopped() const
+        {
+            return m_done || m_error.has_value();
+        }
+
+        constexpr void fail(const char* message, const uint32_t offset)
+        {
+            if (!m_error.has_value())
+                m_error = ConstError{ message, offset };
+        }
+
+        constexpr bool step(const ConstNode& node)
+        {
+            if (m_steps_left == 0)
+            {
+                fail("Fehler: Das Programm hat sein Schrittbudget aufgebraucht", node.offset);
+
+                return false;
+            }
+
+            m_steps_left--;
+
+            return true;
+        }
+
+        /* Expressions */
+        static constexpr int64_t wrap(const BinOp op, const uint64_t a, const uint64_t b)
+        {
+            switch (op)
+            {
+                case BinOp::Add: return static_cast<int64_t>(a + b);
+                case BinOp::Sub: return static_cast<int64_t>(a - b);
+                default:         return static_cast<int64_t>(a * b);
+            }
+        }
+
+        constexpr int64_t arith(const BinOp op, const int64_t lhs, const int64_t rhs, const uint32_t offset)
+        {
+            if (op != BinOp::Div)
+                return wrap(op, static_cast<uint64_t>(lhs), static_cast<uint64_t>(rhs));
+
+            // Where 'idiv' traps, so does the evaluation
+            if (rhs == 0 || (lhs == std::numeric_limits<int64_t>::min() && rhs == -1))
+            {
+                fail("Fehler: Division durch null oder Überlauf bei der Division", offset);
+
+                return 0;
+            }
+
+            return lhs / rhs;
+        }
+
+        // Cell of element 'index' of the 'Feld' at 'node', nothing once an out-of-range index ended the program
+        constexpr std::optional<uint32_t> element(const ConstNode& node, const int64_t index)
+        {
+            if (index < 0 || static_cast<uint64_t>(index) >= node.length)
+            {
+                m_run.result = 255;
+                m_done = true;
+
+                return std::nullopt;
+            }
+
+            return node.cell + static_cast<uint32_t>(index);
+        }
+
+        constexpr int64_t eval(const uint32_t index)
+        {
+            const ConstNode& node = m_nodes[index];
+
+            switch (node.kind)
+            {
+                case AstKind::IntLit:
+                    return node.value;
+
+                case AstKind::Ident:
+                    return m_cells[node.cell];
+
+                case AstKind::Index:
+                {
+                    const int64_t i = eval(node.first);
+
+                    if (stopped())
+                        return 0;
+
+                    const std::optional<uint32_t> cell = element(node, i);
+
+                    return cell.has_value() ? m_cells[cell.value()] : 0;
+                }
+
+                case AstKind::Paren:
+                    return eval(node.first);
+
+                case AstKind::BinExpr:
+                {
+                    const int64_t lhs = eval(node.first);
+                    const int64_t rhs = eval(node.second);
+
+                    if (stopped())
+                        return 0;
+
+                    return arith(static_cast<BinOp>(node.op), lhs, rhs, m_nodes[node.second].offset);
+                }
+
+                case AstKind::LogicExpr:
+                {
+                    const int64_t lhs = eval(node.first);
+                    const int64_t rhs = eval(node.second);
+
+                    switch (static_cast<LogicOp>(node.op))
+                    {
+                        case LogicOp::NotEqual:     return lhs != rhs;
+                        case LogicOp::Equal:        return lhs == rhs;
+                        case LogicOp::Less:         return lhs < rhs;
+                        case LogicOp::LessEqual:    return lhs <= rhs;
+                        case LogicOp::Greater:      return lhs > rhs;
+                        default:                    return lhs >= rhs;
+                    }
+                }
+
+                default:
+                    return 0;
+            }
+        }
+
+        /* Statements */
+        constexpr void exec_list(uint32_t index)
+        {
+            for (; index != 0 && !stopped(); index = m_nodes[index].next)
+                exec(index);
+        }
+
+        // Same rules as 'gen_array_assign': the operands that are no 'Feld' are evaluated once, before the loop
+        constexpr void assign_array(const ConstNode& node)
+        {
+            const uint32_t operands[2] = { node.first, node.second };
+            int64_t scalars[2] = { 0, 0 };
+
+            for (size_t i = 0; i < 2; i++)
+            {
+                if (operands[i] != 0 && array_operand(operands[i]) == 0)
+                    scalars[i] = eval(operands[i]);
+            }
+
+            if (stopped())
+                return;
+
+            const uint32_t lhs = array_operand(node.first);
+            const uint32_t rhs = node.second != 0 ? array_operand(node.second) : 0;
+
+            for (uint32_t i = 0; i < node.length; i++)
+            {
+                const int64_t a = lhs != 0 ? m_cells[m_nodes[lhs].cell + i] : scalars[0];
+
+                if (node.op == ConstNode::NO_OP)
+                {
+                    m_cells[node.cell + i] = a;
+
+                    continue;
+                }
+
+                const int64_t b = rhs != 0 ? m_cells[m_nodes[rhs].cell + i] : scalars[1];
+
+                m_cells[node.cell + i] = wrap(static_cast<BinOp>(node.op), static_cast<uint64_t>(a), static_cast<uint64_t>(b));
+            }
+        }
+
+        constexpr uint32_t array_operand(uint32_t index) const
+        {
+            while (m_nodes[index].kind == AstKind::Paren)
+                index = m_nodes[index].first;
+
+            return m_nodes[index].kind == AstKind::Ident && m_nodes[index].length > 0 ? index : 0;
+        }
+
+        constexpr void exec(const uint32_t index)
+        {
+            const ConstNode& node = m_nodes[index];
+
+            if (!step(node))
+                return;
+
+            switch (node.kind)
+            {
+                case AstKind::Scope:
+                    exec_list(node.first);
+                    break;
+
+                case AstKind::Bestimme:
+                    if (node.length > 0)
+                    {
+                        for (uint32_t i = 0; i < node.length; i++)
+                            m_cells[node.cell + i] = 0;
+                    }
+                    else
+                        m_cells[node.cell] = eval(node.first);
+
+                    break;
+
+                case AstKind::Ändere:
+                {
+                    if (node.third == 0 && node.length > 0)
+                    {
+                        assign_array(node);
+
+                        break;
+                    }
+
+                    if (node.third == 0)
+                    {
+                        m_cells[node.cell] = eval(node.first);
+
+                        break;
+                    }
+
+                    const int64_t i = eval(node.third);
+                    const int64_t value = eval(node.first);
+
+                    if (stopped())
+                        break;
+
+                    if (const std::optional<uint32_t> cell = element(node, i))
+                        m_cells[cell.value()] = value;
+
+                    break;
+                }
+
+                case AstKind::Falls:
+                {
+                    const int64_t condition = eval(node.first);
+
+                    if (stopped())
+                        break;
+
+                    if (condition != 0)
+                        exec(node.second);
+                    else if (node.third != 0)
+                        exec(node.third);
+
+                    break;
+                }
+
+                case AstKind::Solange:
+                    while (!stopped() && eval(node.first) != 0 && !stopped() && step(node))
+                        exec(node.second);
+
+                    break;
+
+                case AstKind::Beende:
+                {
+                    const int64_t result = eval(node.first);
+
+                    if (stopped())
+                        break;
+
+                    m_run.result = result;
+                    m_done = true;
+
+                    break;
+                }
+
+                case AstKind::Schreibe:
+                {
+                    const int64_t value = eval(node.first);
+
+                    if (stopped() || Outputs == 0)
+                        break;
+
+                    if (m_run.output_count == Outputs)
+                    {
+                        fail("Fehler: Das Programm schreibt mehr Zahlen, als die Ausgabe fasst", node.offset);
+
+                        break;
+                    }
+
+                    m_run.output[m_run.output_count++] = value;
+
+                    break;
+                }
+
+                case AstKind::Lies:
+                    // Like 'denk_read_int', 0 once the input is used up
+                    m_cells[node.cell] = m_input_pos < m_input.size() ? m_input[m_input_pos++] : 0;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+};
+
+template <size_t Nodes, size_t Cells>
+class ConstParser;
+
+/* Checked program, ready to run in constant evaluation or at run time */
+template <size_t Nodes, size_t Cells>
+class ConstProgram
+{
+    public:
+        static constexpr uint64_t DEFAULT_STEPS = 100000;    // below GCC's '-fconstexpr-loop-limit' of 262144
+
+        template <size_t Outputs = 64>
+        constexpr ConstResult<ConstRun<Outputs>> run(const std::span<const int64_t> input = {}, const uint64_t max_steps = DEFAULT_STEPS) const
+        {
+            return ConstEvaluator<Nodes, Cells, Outputs>(m_nodes, input, max_steps).run(m_program);
+        }
+
+        // Lowers a program of one input to a table: entry 'i' is the result of the run that reads 'i' first
+        template <size_t Count>
+        constexpr ConstResult<std::array<int64_t, Count>> tabulate(const uint64_t max_steps = DEFAULT_STEPS) const
+        {
+            std::array<int64_t, Count> table {};
+
+            for (size_t i = 0; i < Count; i++)
+            {
+                const std::array<int64_t, 1> input = { static_cast<int64_t>(i) };
+
+                const ConstResult<ConstRun<0>> outcome = run<0>(input, max_steps);
+
+                if (!outcome.has_value())
+                    return std::unexpected(outcome.error());
+
+                table[i] = outcome->result;
+            }
+
+            return table;
+        }
+
+        // Arena slots in use, including the empty slot 0
+        constexpr uint32_t nodes() const
+        {
+            return m_nodes.size();
+        }
+
+        constexpr uint32_t cells() const
+        {
+            return m_cells;
+        }
+
+    private:
+        friend class ConstParser<Nodes, Cells>;
+
+        ConstArena<ConstNode, Nodes> m_nodes;
+        uint32_t m_program = 0;     // first top-level statement, the others linked by 'next'
+        uint32_t m_cells = 0;       // memory cells the variables need at most at the same time
+};
+
+/* Token of the constexpr front end; the text stays in the source */
+struct ConstToken
+{
+    TokenType type = TokenType::dot;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+/* Pulls one token at a time, with the rules of 'Tokenizer' */
+class ConstTokenizer
+{
+    public:
+        constexpr explicit ConstTokenizer(std::string_view src) : m_src(src) {}
+
+        // Next token, nothing at the end of the source
+        constexpr ConstResult<std::optional<ConstToken>> next()
+        {
+            while (const std::optional<char32_t> ch = decode_utf8(m_src, m_index))
+            {
+                const uint32_t start = m_index;
+
+                if (is_alpha(ch.value()))
+                {
+                    skip_while([](char32_t c) { return is_alnum(c); });
+
+                    const std::string_view text = m_src.substr(start, m_index - start);
+
+                    for (const auto& [keyword, type] : KEYWORDS)
+                    {
+                        if (keyword == text)
+                            return ConstToken{ type, start, m_index - start };
+                    }
+
+                    return ConstToken{ TokenType::ident, start, m_index - start };
+                }
+
+                if (is_digit(ch.value()))
+                {
+                    skip_while([](char32_t c) { return is_digit(c); });
+
+                    return ConstToken{ TokenType::int_lit, start, m_index - start };
+                }
+
+                m_index += static_cast<uint32_t>(utf8_length(m_src[m_index]));
+
+                switch (ch.value())
+                {
+                    case U' ': case U'\n': case U'\r': case U'\t':
+                        continue;
+
+                    case U'.': return ConstToken{ TokenType::dot, start, 1 };
+                    case U'+': return ConstToken{ TokenType::plus, start, 1 };
+                    case U'-': return ConstToken{ TokenType::minus, start, 1 };
+                    case U'*': return ConstToken{ TokenType::star, start, 1 };
+                    case U'(': return ConstToken{ TokenType::open_paren, start, 1 };
+                    case U')': return ConstToken{ TokenType::close_paren, start, 1 };
+                    case U'{': return ConstToken{ TokenType::open_curly, start, 1 };
+                    case U'}': return ConstToken{ TokenType::close_curly, start, 1 };
+                    case U'[': return ConstToken{ TokenType::open_square, start, 1 };
+                    case U']': return ConstToken{ TokenType::close_square, start, 1 };
+
+                    case U'/':
+                        if (peek() == U'/')
+                        {
+                            skip_while([](char32_t c) { return c != U'\n'; });
+
+                            continue;
+                        }
+
+                        if (peek() != U'*')
+                            return ConstToken{ TokenType::slash, start, 1 };
+
+                        if (!skip_comment())
+                            return std::unexpected(ConstError{ "Fehler: Mehrzeiliger Kommentar wurde nicht korrekt geschlossen (erwartetes '*/')", start });
+
+                        continue;
+
+                    default:
+                        return std::unexpected(ConstError{ "Fehler: Ein Syntaxfehler ist aufgetreten", start });
+                }
+            }
+
+            return std::nullopt;
+        }
+
+    private:
+        constexpr std::optional<char32_t> peek() const
+        {
+            return decode_utf8(m_src, m_index);
+        }
+
+        template <typename Predicate>
+        constexpr void skip_while(Predicate pred)
+        {
+            while (peek().has_value() && pred(peek().value()))
+                m_index += static_cast<uint32_t>(utf8_length(m_src[m_index]));
+        }
+
+        // Skips a block comment from its '*'; false if the source ends first
+        constexpr bool skip_comment()
+        {
+            m_index++;
+
+            while (true)
+            {
+                skip_while([](char32_t c) { return c != U'*'; });
+
+                if (!peek().has_value())
+                    return false;
+
+                m_index++;
+
+                if (peek() == U'/')
+                {
+                    m_index++;
+
+                    return true;
+                }
+            }
+        }
+
+        const std::string_view m_src;
+        uint32_t m_index = 0;
+};
+
+/* Parses and checks in one pass, with the grammar of 'Parser' and the name rules of the generator */
+template <size_t Nodes, size_t Cells>
+class ConstParser
+{
+    public:
+        constexpr explicit ConstParser(std::string_view src)
+            : m_src(src)
+            , m_tokenizer(src)
+        {
+        }
+
+        constexpr ConstResult<ConstProgram<Nodes, Cells>> parse_prog()
+        {
+            if (m_src.size() > std::numeric_limits<uint32_t>::max())
+                return std::unexpected(ConstError{ "Fehler: Quelltexte über 4 GiB werden nicht unterstützt", 0 });
+
+            // The compiler lexes the whole source first, so a lexer error wins over any error of the parser
+            ConstTokenizer lexer(m_src);
+
+            while (true)
+            {
+                const ConstResult<std::optional<ConstToken>> token = lexer.next();
+
+                if (!token.has_value())
+                    return std::unexpected(token.error());
+
+                if (!token->has_value())
+                    break;
+            }
+
+            advance();
+
+            uint32_t* link = &m_program.m_program;
+
+            while (!failed() && m_current.has_value())
+            {
+                const uint32_t stmt = parse_stmt();
+
+                if (stmt == 0)
+                    error("Fehler: Ungültige Anweisung");
+
+                if (failed())
+                    break;
+
+                *link = stmt;
+                link = &m_program.m_nodes[stmt].next;
+            }
+
+            if (failed())
+                return std::unexpected(m_error.value());
+
+            return m_program;
+        }
+
+    private:
+        /* Internal State */
+        struct Var
+        {
+            uint32_t name_offset = 0;
+            uint32_t name_length = 0;
+            uint32_t cell = 0;
+            uint32_t length = 0;    // elements of a 'Feld', 0 for scalars
+        };
+
+        const std::string_view m_src;
+        ConstTokenizer m_tokenizer;
+
+        std::optional<ConstToken> m_current;
+        uint32_t m_last_offset = 0;     // of the last token, where errors at the end of the source point
+
+        ConstProgram<Nodes, Cells> m_program;
+
+        std::array<Var, Nodes> m_vars {};
+        uint32_t m_var_count = 0;
+        uint32_t m_cell_count = 0;
+
+        std::optional<ConstError> m_error;
+
+        /* Errors */
+        constexpr bool failed() const
+        {
+            return m_error.has_value();
+        }
+
+        constexpr uint32_t error_at(const char* message, const uint32_t offset)
+        {
+            if (!m_error.has_value())
+                m_error = ConstError{ message, offset };
+
+            return 0;
+        }
+
+        // Fails at the token the parser stopped at, or at the last one once all are consumed
+        constexpr uint32_t error(const char* message)
+        {
+            return error_at(message, m_current.has_value() ? m_current->offset : m_last_offset);
+        }
+
+        /* Tokens */
+        constexpr void advance()
+        {
+            if (m_current.has_value())
+                m_last_offset = m_current->offset;
+
+            // Lexer errors were reported before parsing started
+            m_current = m_tokenizer.next().value_or(std::nullopt);
+        }
+
+        constexpr std::optional<ConstToken> try_consume(const TokenType type)
+        {
+            if (!m_current.has_value() || m_current->type != type)
+                return std::nullopt;
+
+            const ConstToken token = m_current.value();
+
+            advance();
+
+            return token;
+        }
+
+        constexpr ConstToken try_consume(const TokenType type, const char* err_msg)
+        {
+            if (const std::optional<ConstToken> token = try_consume(type))
+                return token.value();
+
+            error(err_msg);
+
+            return {};
+        }
+
+        constexpr std::string_view text(const ConstToken& token) const
+        {
+            return m_src.substr(token.offset, token.length);
+        }
+
+        constexpr uint32_t emplace(const ConstNode& node)
+        {
+            if (const std::optional<uint32_t> index = m_program.m_nodes.emplace(node))
+                return index.value();
+
+            return error_at("Fehler: Das Programm passt nicht in die Knoten des constexpr-Speichers", node.offset);
+        }
+
+        constexpr ConstNode& node(const uint32_t index)
+        {
+            return m_program.m_nodes[index];
+        }
+
+        /* Names */
+        constexpr const Var* find_var(const ConstToken& ident) const
+        {
+            for (uint32_t i = 0; i < m_var_count; i++)
+            {
+                if (m_src.substr(m_vars[i].name_offset, m_vars[i].name_length) == text(ident))
+                    return &m_vars[i];
+            }
+
+            return nullptr;
+        }
+
+        constexpr const Var* find_declared(const ConstToken& ident)
+        {
+            const Var* var = find_var(ident);
+
+            if (var == nullptr)
+                error_at("Fehler: Bezeichner ist nicht deklariert", ident.offset);
+
+            return var;
+        }
+
+        constexpr const Var* find_array(const ConstToken& ident)
+        {
+            const Var* var = find_declared(ident);
+
+            if (var != nullptr && var->length == 0)
+            {
+                error_at("Fehler: Bezeichner ist kein Feld", ident.offset);
+
+                return nullptr;
+            }
+
+            return var;
+        }
+
+        constexpr std::optional<uint32_t> declare(const ConstToken& ident, const uint32_t length)
+        {
+            if (find_var(ident) != nullptr)
+            {
+                error_at("Fehler: Bezeichner wird bereits verwendet", ident.offset);
+
+                return std::nullopt;
+            }
+
+            const uint32_t cells = std::max<uint32_t>(length, 1);
+
+            if (m_var_count == Nodes || Cells - m_cell_count < cells)
+            {
+                error_at("Fehler: Die Variablen passen nicht in die Zellen des constexpr-Speichers", ident.offset);
+
+                return std::nullopt;
+            }
+
+            m_vars[m_var_count++] = { ident.offset, ident.length, m_cell_count, length };
+
+            const uint32_t cell = m_cell_count;
+
+            m_cell_count += cells;
+            m_program.m_cells = std::max(m_program.m_cells, m_cell_count);
+
+            return cell;
+        }
+
+        // A 'Feld' without index is only valid as an operand of a whole-'Feld' 'Ändere'
+        constexpr void check_scalar(const uint32_t index)
+        {
+            if (index == 0 || failed())
+                return;
+
+            const ConstNode& n = node(index);
+
+            if (n.kind == AstKind::Ident && n.length > 0)
+            {
+                error_at("Fehler: Feld kann hier nur mit Index verwendet werden", n.offset);
+
+                return;
+            }
+
+            if (n.kind != AstKind::IntLit && n.kind != AstKind::Ident)
+            {
+                check_scalar(n.first);
+                check_scalar(n.second);
+            }
+        }
+
+        constexpr uint32_t array_operand(uint32_t index)
+        {
+            while (node(index).kind == AstKind::Paren)
+                index = node(index).first;
+
+            return node(index).kind == AstKind::Ident && node(index).length > 0 ? index : 0;
+        }
+
+        /* Expressions */
+        constexpr uint32_t parse_term()
+        {
+            if (const auto int_lit = try_consume(TokenType::int_lit))
+            {
+                // Literals wrap around like an immediate of the assembler
+                uint64_t value = 0;
+
+                for (const char c : text(int_lit.value()))
+                    value = value * 10 + static_cast<uint64_t>(c - '0');
+
+                return emplace({ .kind = AstKind::IntLit, .offset = int_lit->offset, .value = static_cast<int64_t>(value) });
+            }
+
+            if (const auto ident = try_consume(TokenType::ident))
+            {
+                if (try_consume(TokenType::open_square))
+                {
+                    const uint32_t index = parse_index();
+                    const Var* var = failed() ? nullptr : find_array(ident.value());
+
+                    if (var == nullptr)
+                        return 0;
+
+                    // Literal indices are checked here, any other index when the program runs
+                    if (const ConstNode& i = node(index); i.kind == AstKind::IntLit && (i.value < 0 || static_cast<uint64_t>(i.value) >= var->length))
+                        return error_at("Fehler: Index liegt außerhalb des Feldes", ident->offset);
+
+                    return emplace({ .kind = AstKind::Index, .offset = ident->offset, .cell = var->cell, .length = var->length, .first = index });
+                }
+
+                const Var* var = find_declared(ident.value());
+
+                if (var == nullptr)
+                    return 0;
+
+                return emplace({ .kind = AstKind::Ident, .offset = ident->offset, .cell = var->cell, .length = var->length });
+            }
+
+            if (const auto open_paren = try_consume(TokenType::open_paren))
+            {
+                const uint32_t expr = parse_expr();
+
+                if (expr == 0)
+                    return error("Fehler: Unerwarteter Ausdruck");
+
+                try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+
+                return failed() ? 0 : emplace({ .kind = AstKind::Paren, .offset = open_paren->offset, .first = expr });
+            }
+
+            return 0;
+        }
+
+        // Parses the remainder of 'A[index]' after the opening bracket
+        constexpr uint32_t parse_index()
+        {
+            const uint32_t index = parse_expr();
+
+            if (index == 0)
+                return error("Fehler: Ungültiger Index");
+
+            try_consume(TokenType::close_square, "Fehler: Token ']' wird erwartet");
+
+            check_scalar(index);
+
+            return failed() ? 0 : index;
+        }
+
+        constexpr uint32_t parse_expr(const size_t min_prec = 0)
+        {
+            uint32_t expr_lhs = parse_term();
+
+            while (expr_lhs != 0 && !failed())
+            {
+                const auto prec = m_current.has_value() ? bin_prec(m_current->type) : std::nullopt;
+
+                if (!prec.has_value() || prec.value() < min_prec)
+                    break;
+
+                const ConstToken op = m_current.value();
+
+                advance();
+
+                // 'kleiner gleich' and 'größer gleich' are spelled with two tokens
+                const bool or_equal = (op.type == TokenType::kleiner || op.type == TokenType::größer) &&
+                                      try_consume(TokenType::gleich).has_value();
+
+                const uint32_t expr_rhs = parse_expr(prec.value() + 1);
+
+                if (expr_rhs == 0)
+                    return error("Fehler: Ausdruck kann nicht geparst werden");
+
+                ConstNode expr = { .offset = op.offset, .first = expr_lhs, .second = expr_rhs };
+
+                switch (op.type)
+                {
+                    case TokenType::plus:     expr.kind = AstKind::BinExpr; expr.op = static_cast<uint8_t>(BinOp::Add); break;
+                    case TokenType::minus:    expr.kind = AstKind::BinExpr; expr.op = static_cast<uint8_t>(BinOp::Sub); break;
+                    case TokenType::star:     expr.kind = AstKind::BinExpr; expr.op = static_cast<uint8_t>(BinOp::Mul); break;
+                    case TokenType::slash:    expr.kind = AstKind::BinExpr; expr.op = static_cast<uint8_t>(BinOp::Div); break;
+                    case TokenType::gleich:   expr.kind = AstKind::LogicExpr; expr.op = static_cast<uint8_t>(LogicOp::Equal); break;
+                    case TokenType::ungleich: expr.kind = AstKind::LogicExpr; expr.op = static_cast<uint8_t>(LogicOp::NotEqual); break;
+
+                    case TokenType::kleiner:
+                        expr.kind = AstKind::LogicExpr;
+                        expr.op = static_cast<uint8_t>(or_equal ? LogicOp::LessEqual : LogicOp::Less);
+                        break;
+
+                    default:
+                        expr.kind = AstKind::LogicExpr;
+                        expr.op = static_cast<uint8_t>(or_equal ? LogicOp::GreaterEqual : LogicOp::Greater);
+                        break;
+                }
+
+                expr_lhs = emplace(expr);
+            }
+
+            return failed() ? 0 : expr_lhs;
+        }
+
+        // An expression that has to be there, followed by 'close'
+        constexpr uint32_t expect_expr(const char* err_msg, const TokenType close, const char* close_msg)
+        {
+            const uint32_t expr = parse_expr();
+
+            if (expr == 0)
+                return error(err_msg);
+
+            try_consume(close, close_msg);
+
+            return failed() ? 0 : expr;
+        }
+
+        /* Statements */
+        constexpr uint32_t parse_scope()
+        {
+            const std::optional<ConstToken> open = try_consume(TokenType::open_curly);
+
+            if (!open.has_value())
+                return 0;
+
+            const uint32_t scope = emplace({ .kind = AstKind::Scope, .offset = open->offset });
+            const uint32_t vars = m_var_count;
+            const uint32_t cells = m_cell_count;
+
+            uint32_t last = 0;
+
+            while (!failed())
+            {
+                const uint32_t stmt = parse_stmt();
+
+                if (stmt == 0)
+                    break;
+
+                (last == 0 ? node(scope).first : node(last).next) = stmt;
+                last = stmt;
+            }
+
+            try_consume(TokenType::close_curly, "Fehler: Token '}' wird erwartet");
+
+            // Cells of the scope's variables are free again once it ends
+            m_var_count = vars;
+            m_cell_count = cells;
+
+            return failed() ? 0 : scope;
+        }
+
+        // A 'Falls' may carry a hint, which only matters to the compiled code
+        constexpr uint32_t parse_branch(const char* expr_msg, const bool hint = false)
+        {
+            const uint32_t stmt = emplace({ .offset = m_last_offset });
+
+            try_consume(TokenType::open_paren, "Fehler: Token '(' wird erwartet");
+
+            if (failed())
+                return 0;
+
+            node(stmt).first = expect_expr(expr_msg, TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+
+            if (hint && !try_consume(TokenType::wahrscheinlich).has_value())
+                try_consume(TokenType::unwahrscheinlich);
+
+            try_consume(TokenType::dann, "Fehler: Token 'dann' wird erwartet");
+            check_scalar(node(stmt).first);
+
+            if (failed())
+                return 0;
+
+            node(stmt).second = parse_scope();
+
+            if (node(stmt).second == 0)
+                return error("Fehler: Ungültiger Gültigkeitsbereich");
+
+            return stmt;
+        }
+
+        constexpr uint32_t parse_stmt()
+        {
+            if (failed() || !m_current.has_value())
+                return 0;
+
+            const uint32_t offset = m_current->offset;
+
+            if (m_current->type == TokenType::open_curly)
+                return parse_scope();
+
+            if (try_consume(TokenType::Bestimme))
+            {
+                const ConstToken ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
+
+                try_consume(TokenType::als, "Fehler: Token 'als' wird erwartet");
+
+                if (failed())
+                    return 0;
+
+                ConstNode stmt = { .kind = AstKind::Bestimme, .offset = ident.offset };
+
+                if (try_consume(TokenType::Feld))
+                {
+                    try_consume(TokenType::open_square, "Fehler: Token '[' wird erwartet");
+
+                    const ConstToken length = try_consume(TokenType::int_lit, "Fehler: Feldlänge wird erwartet");
+
+                    try_consume(TokenType::close_square, "Fehler: Token ']' wird erwartet");
+
+                    if (failed())
+                        return 0;
+
+                    uint32_t value = 0;
+
+                    if (length.length <= 6)
+                    {
+                        for (const char c : text(length))
+                            value = value * 10 + static_cast<uint32_t>(c - '0');
+                    }
+
+                    static_assert(Parser::MAX_ARRAY_LENGTH == 65536);
+
+                    if (value == 0 || value > Parser::MAX_ARRAY_LENGTH)
+                        return error_at("Fehler: Feldlänge muss zwischen 1 und 65536 liegen", length.offset);
+
+                    stmt.length = value;
+                }
+                else if ((stmt.first = parse_expr()) == 0)
+                    return error("Fehler: Ungültiger 'Bestimme'-Ausdruck");
+
+                try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
+                check_scalar(stmt.first);
+
+                if (failed())
+                    return 0;
+
+                // Declared after the value, which cannot refer to the name it defines
+                const std::optional<uint32_t> cell = declare(ident, stmt.length);
+
+                if (!cell.has_value())
+                    return 0;
+
+                stmt.cell = cell.value();
+
+                return emplace(stmt);
+            }
+
+            if (try_consume(TokenType::Ändere))
+            {
+                const ConstToken ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
+
+                if (failed())
+                    return 0;
+
+                ConstNode stmt = { .kind = AstKind::Ändere, .offset = ident.offset };
+
+                if (try_consume(TokenType::open_square))
+                    stmt.third = parse_index();
+
+                try_consume(TokenType::zu, "Fehler: Token 'zu' wird erwartet");
+
+                if (failed())
+                    return 0;
+
+                stmt.first = expect_expr("Fehler: Ungültiger 'Ändere'-Ausdruck", TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                const Var* var = failed() ? nullptr : find_declared(ident);
+
+                if (var == nullptr || (stmt.third != 0 && find_array(ident) == nullptr))
+                    return 0;
+
+                stmt.cell = var->cell;
+                stmt.length = var->length;
+
+                if (stmt.third == 0 && var->length > 0)
+                    return assign_array(stmt) ? emplace(stmt) : 0;
+
+                check_scalar(stmt.first);
+
+                return failed() ? 0 : emplace(stmt);
+            }
+
+            if (try_consume(TokenType::Falls))
+            {
+                const uint32_t stmt = parse_branch("Fehler: Ungültige Anweisung", true);
+
+                if (stmt == 0)
+                    return 0;
+
+                node(stmt).kind = AstKind::Falls;
+                node(stmt).offset = offset;
+
+                if (try_consume(TokenType::Sonst))
+                {
+                    node(stmt).third = parse_stmt();
+
+                    if (node(stmt).third == 0)
+                        return error("Fehler: Nach 'Sonst' wird eine Anweisung erwartet");
+                }
+
+                return stmt;
+            }
+
+            if (try_consume(TokenType::Solange))
+            {
+                const uint32_t stmt = parse_branch("Fehler: Ungültige 'Solange'-Bedingung");
+
+                if (stmt == 0)
+                    return 0;
+
+                node(stmt).kind = AstKind::Solange;
+                node(stmt).offset = offset;
+
+                return stmt;
+            }
+
+            if (try_consume(TokenType::Beende))
+            {
+                try_consume(TokenType::mit, "Fehler: Token 'mit' wird erwartet");
+
+                if (failed())
+                    return 0;
+
+                const uint32_t expr = expect_expr("Fehler: Ungültiger 'Beende'-Ausdruck", TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                check_scalar(expr);
+
+                return failed() ? 0 : emplace({ .kind = AstKind::Beende, .offset = offset, .first = expr });
+            }
+
+            if (try_consume(TokenType::Schreibe))
+            {
+                const uint32_t expr = expect_expr("Fehler: Ungültiger 'Schreibe'-Ausdruck", TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                check_scalar(expr);
+
+                return failed() ? 0 : emplace({ .kind = AstKind::Schreibe, .offset = offset, .first = expr });
+            }
+
+            if (try_consume(TokenType::Lies))
+            {
+                const ConstToken ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
+
+                try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                const Var* var = failed() ? nullptr : find_declared(ident);
+
+                if (var == nullptr)
+                    return 0;
+
+                if (var->length > 0)
+                    return error_at("Fehler: Feld kann nicht eingelesen werden", ident.offset);
+
+                return emplace({ .kind = AstKind::Lies, .offset = ident.offset, .cell = var->cell });
+            }
+
+            return 0;
+        }
+
+        // Same rules as 'gen_array_assign': a whole 'Feld', a scalar, or one operator between a 'Feld' and a 'Feld' or scalar
+        constexpr bool assign_array(ConstNode& stmt)
+        {
+            stmt.op = ConstNode::NO_OP;
+
+            const ConstNode& expr = node(stmt.first);
+
+            if (array_operand(stmt.first) == 0 && expr.kind == AstKind::BinExpr &&
+                (array_operand(expr.first) != 0 || array_operand(expr.second) != 0))
+            {
+                if (expr.op == static_cast<uint8_t>(BinOp::Div))
+                {
+                    error_at("Fehler: Felder unterstützen nur '+', '-' und '*'", stmt.offset);
+
+                    return false;
+                }
+
+                stmt.op = expr.op;
+                stmt.second = expr.second;
+                stmt.first = expr.first;
+            }
+
+            for (const uint32_t operand : { stmt.first, stmt.second })
+            {
+                if (operand == 0)
+                    continue;
+
+                if (const uint32_t array = array_operand(operand); array == 0)
+                    check_scalar(operand);
+                else if (node(array).length != stmt.length)
+                    error_at("Fehler: Feld hat nicht die Länge des Zielfeldes", stmt.offset);
+            }
+
+            return !failed();
+        }
+};
+
+// Parses and checks 'src'; the capacities bound the nodes and the memory cells of all variables alive at once
+template <size_t Nodes = 1024, size_t Cells = 1024>
+constexpr ConstResult<ConstProgram<Nodes, Cells>> const_parse(const std::string_view src)
+{
+    return ConstParser<Nodes, Cells>(src).parse_prog();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/* Error raised by any compiler phase instead of terminating the process */
+class CompileError : public std::runtime_error
+{
+    public:
+        explicit CompileError(const std::string& message, const std::optional<uint32_t> offset = std::nullopt)
+            : std::runtime_error(message)
+            , m_offset(offset)
+        {
+        }
+
+        // Byte offset in the source the error points at, if any
+        std::optional<uint32_t> offset() const
+        {
+            return m_offset;
+        }
+
+    private:
+        std::optional<uint32_t> m_offset;
+};
+
+// Formats all arguments into one message and throws it as a 'CompileError'
+template <typename... Args>
+[[noreturn]] void compile_error(const Args&... args)
+{
+    std::ostringstream message;
+
+    (message << ... << args);
+
+    throw CompileError(message.str());
+}
+
+// Like 'compile_error', pointing at byte 'offset' of the source
+template <typename... Args>
+[[noreturn]] void compile_error_at(const uint32_t offset, const Args&... args)
+{
+    std::ostringstream message;
+
+    (message << ... << args);
+
+    throw CompileError(message.str(), offset);
+}
+
+/* Message reported to the caller of the compiler */
+struct Diagnostic
+{
+    std::string message;
+    std::optional<uint32_t> offset = std::nullopt;   // into the source, see 'LineIndex' for line and column
+};
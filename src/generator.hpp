@@ -3,330 +3,4533 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <deque>
 #include <optional>
 #include <fstream>
 #include <ranges>
 #include <cmath>
 #include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <charconv>
+#include <memory>
 
 #include "tokenizer.hpp"
 #include "parser.hpp"
+#include "diagnostics.hpp"
+#include "thread_pool.hpp"
 
 class Generator
 {
     public:
-        inline explicit Generator(NodeProg prog)
+        // With a 'profile_path' the program counts its statements and writes the counters there on exit. A 'freestanding'
+        // program is a Linux ELF without libc: it starts at '_start' and talks to the kernel through raw system calls.
+        // A large program is generated in segments on up to 'jobs' threads; the assembly is the same for any value.
+        inline explicit Generator(NodeProg prog, std::optional<std::string> profile_path = std::nullopt, bool freestanding = false,
+                                  size_t jobs = 1)
             : m_prog(std::move(prog))
+            , m_freestanding(freestanding)
+            , m_jobs(std::max<size_t>(jobs, 1))
+            , m_profile_path(std::move(profile_path))
             {}
 
         std::string gen_prog()
         {
+            const char* entry = m_freestanding ? "_start" : "main";
+
             m_output << "section .text\n";
-            m_output << "    global main\n\n";        
+            m_output << "    global " << entry << "\n\n";        
             
+            // Every exit has to flush the output buffer, so this is known before the first 'Beende'
             for (const NodeStmt* stmt : m_prog.stmts)
-                gen_stmt(stmt);
+                collect_io(stmt, m_uses_output, m_uses_input);
+
+            collect_functions();
+
+            if (const std::vector<Segment> segments = plan_segments(); segments.size() > 1)
+                gen_segments(segments);
+            else
+                gen_stmts(m_prog.stmts);
+
+            gen_functions();
+
+            // Nothing returns from '_start', so a freestanding program always exits explicitly; neither may the program
+            // run into the cold blocks and functions behind it
+            const bool code_behind = !m_calls.empty() || m_cold.tellp() > 0;
+
+            if (m_profile_path.has_value() || m_uses_output || m_freestanding || code_behind)
+            {
+                m_temp << "\n    ; end of program\n";
+                m_temp << "    xor ecx, ecx\n";
+
+                if (m_profile_path.has_value())
+                    m_temp << "    call denk_prof_write\n";
+
+                m_temp << "    call " << exit_routine() << "\n";
+            }
             
-            m_output << "\nmain:\n";
-            m_output << "    push rbp\n";
+            if (m_uses_bounds_check || m_profile_path.has_value() || m_uses_output || code_behind)
+                declare_extern_once("ExitProcess");
+
+            if (m_profile_path.has_value())
+            {
+                declare_extern_once("CreateFileA");
+                declare_extern_once("WriteFile");
+                declare_extern_once("CloseHandle");
+            }
+
+            if (m_uses_output || m_uses_input)
+                declare_extern_once("GetStdHandle");
+
+            if (m_uses_output)
+                declare_extern_once("WriteFile");
+
+            if (m_uses_input)
+                declare_extern_once("ReadFile");
+
+            const size_t frame_size = align_stack(m_max_stack_size + m_max_mem_size);
+
+            m_output << "\n" << entry << ":\n";
+
+            // '_start' is entered with an aligned stack and no caller to return to, so there is no frame pointer to save
+            if (!m_freestanding)
+                m_output << "    push rbp\n";
+
             m_output << "    mov rbp, rsp\n";
-            m_output << "    sub rsp, "
-                     << align_stack(m_max_stack_size + m_max_mem_size)
-                     << "\n";
+
+            if (frame_size > STACK_PAGE_SIZE)
+                gen_stack_probe(m_output, frame_size);
+
+            m_output << "    sub rsp, " << frame_size << "\n";
+
+            if (m_uses_simd)
+                gen_cpu_detect();
             
-            m_output << m_temp.rdbuf();
+            m_output << m_temp.rdbuf() << m_cold.str();
+
+            for (const size_t index : called_functions())
+                m_output << m_functions[index].code;
+
+            if (m_uses_bounds_check)
+            {
+                m_output << "\ndenk_bounds_error:\n";
+                m_output << "    mov rcx, " << BOUNDS_ERROR_EXIT_CODE << "\n";
+
+                if (m_profile_path.has_value())
+                    m_output << "    call denk_prof_write\n";
+
+                m_output << "    call " << exit_routine() << "\n";
+            }
+
+            if (m_freestanding)
+            {
+                m_output << "\ndenk_sys_exit:\n";
+                m_output << "    mov edi, ecx\n";
+                m_output << "    mov eax, 60\n";                    // exit
+                m_output << "    syscall\n";
+            }
+
+            // Code only, the profile runtime below switches to '.data'
+            if (m_uses_output || m_uses_input)
+                gen_io_runtime();
+
+            if (m_profile_path.has_value())
+                gen_profile_runtime();
+
+            if (m_uses_simd || m_profile_path.has_value() || m_uses_output || m_uses_input)
+                m_output << "\nsection .bss\n";
+
+            if (m_uses_simd)
+                m_output << "    denk_avx2: resb 1\n";
+
+            if (m_uses_output)
+                m_output << "    alignb 8\n"
+                         << "    denk_out_len: resq 1\n"
+                         << "    denk_out_buf: resb " << IO_BUFFER_SIZE << "\n";
+
+            if (m_uses_input)
+                m_output << "    alignb 8\n"
+                         << "    denk_in_pos: resq 1\n"
+                         << "    denk_in_len: resq 1\n"
+                         << "    denk_in_buf: resb " << IO_BUFFER_SIZE << "\n";
+
+            if (m_profile_path.has_value())
+                m_output << "    alignb 8\n"
+                         << "    denk_prof: resq " << std::max<size_t>(m_profile.size(), 1) << "\n";
+
+            return m_output.str();
+        }
+
+        /*
+         * Sidecar for '--profile-gen', one counter per line after the header:
+         *
+         *   DEnk-Profil <version> <counters>
+         *   <index> \t <kind> \t <statement path, e.g. 3.1.2> \t <statement>
+         */
+        std::string profile_map() const
+        {
+            std::ostringstream map;
+
+            map << "DEnk-Profil\t" << PROFILE_VERSION << "\t" << m_profile.size() << "\n";
+
+            for (size_t i = 0; i < m_profile.size(); i++)
+                map << i << "\t" << profile_kind_name(m_profile[i].kind) << "\t" << m_profile[i].path << "\t" << m_profile[i].text << "\n";
+
+            return map.str();
+        }
+    
+    private:
+        /* Internal State */
+        // Bounds of a scalar, both inclusive; the default is every value
+        struct Range
+        {
+            int64_t lo = INT64_MIN;
+            int64_t hi = INT64_MAX;
+        };
+
+        struct Var
+        {
+            std::string name;
+            size_t mem_loc;
+            std::optional<int64_t> value {};    // known constant value, if any
+            size_t length = 0;                  // number of elements of a 'Feld', 0 for scalars
+            Range range {};                     // bounds of the value while it is not known exactly
+        };
+
+        const NodeProg m_prog;
+        const bool m_freestanding;
+        const size_t m_jobs;
+        std::stringstream m_temp, m_output;
+        std::stringstream m_cold;               // cold blocks, placed behind the code of the program or function
+        std::vector<std::string> m_extern;
+
+        // A deque, so that a 'Var*' stays valid while the expressions of its statement push hidden slots, e.g. the
+        // arguments of an inlined call
+        std::deque<Var> m_vars;
+        std::vector<size_t> m_scopes;
+
+        // Position of every named variable in m_vars, a name is declared at most once at a time
+        std::unordered_map<std::string, size_t> m_var_index;
+
+        size_t m_mem_size = 0;
+        size_t m_stack_size = 0;
+        size_t m_max_mem_size = 0;
+        size_t m_max_stack_size = 0;
+
+        size_t m_label_count = 0;
+        std::string m_label_prefix = ".L";      // one per segment, so that their labels can not collide
+
+        // Loop-invariant expressions that have been hoisted into a hidden stack slot
+        std::unordered_map<const NodeExpr*, size_t> m_hoisted;
+
+        // Value numbering: a variable gets a fresh number whenever it is assigned, and an operation is numbered by its
+        // operator and the numbers of its operands, so equal numbers mean equal values
+        enum class ValueKind
+        {
+            Const, Index, Bin, Logic
+        };
+
+        struct ValueKey
+        {
+            ValueKind kind;
+            int op;
+            size_t lhs;
+            size_t rhs;
+
+            bool operator==(const ValueKey&) const = default;
+        };
+
+        struct ValueKeyHash
+        {
+            size_t operator()(const ValueKey& key) const
+            {
+                return std::hash<size_t>{}(((key.lhs * 0x9E3779B97F4A7C15ull) ^ key.rhs) * 31 + static_cast<size_t>(key.op) * 4 + static_cast<size_t>(key.kind));
+            }
+        };
+
+        std::unordered_map<ValueKey, size_t, ValueKeyHash> m_value_numbers;
+        std::unordered_map<std::string, size_t> m_var_numbers;
+        std::unordered_map<size_t, int64_t> m_constants;    // value number -> the constant it stands for
+        size_t m_next_value_number = 0;
+
+        // Value numbers of the expressions one statement is planned with, cleared before every statement
+        std::unordered_map<const NodeExpr*, size_t> m_numbered;
+
+        // Value numbers that a dominating statement left in a hidden stack slot
+        std::unordered_map<size_t, size_t> m_available;
+
+        // Where the statements after the current one compute which value, and where they first assign which name; a use
+        // only counts for a value if it comes before the first assignment to anything the value reads
+        struct Lookahead
+        {
+            std::vector<std::pair<size_t, size_t>> uses;                // value number, position
+            std::vector<std::pair<const std::string*, size_t>> kills;   // name, position
+            size_t position = 0;
+            size_t stmts = 0;
+        };
+
+        // Names each loop assigns, looked up again for every statement before it
+        std::unordered_map<const NodeStmt*, std::vector<std::string>> m_loop_assigned;
+
+        static constexpr size_t MAX_CSE_DISTANCE = 32;     // statements, nested ones included, searched for another use of a value
+
+        static constexpr size_t MAX_UNROLL_TRIPS = 8;
+        static constexpr size_t MAX_UNROLL_SIZE = 64;
+
+        /* Segments: parts of a large program that are generated on their own */
+        struct Segment
+        {
+            size_t begin;                       // first top-level statement
+            size_t end;
+        };
+
+        // Slots of the top-level variables when the program is generated in segments, fixed before any code is generated
+        const std::unordered_map<const NodeStmtBestimme*, size_t>* m_global_slots = nullptr;
+
+        // Below this size a segment costs more in lost constants and common values than its thread saves
+        static constexpr size_t MIN_GEN_SEGMENT_SIZE = 16384;  // nodes
+
+        /* Functions ('Funktion', 'Gib ... zurück') */
+        struct Function
+        {
+            const NodeStmtFunktion* node;
+            std::string label;
+            size_t path = 0;                    // profile path of the definition
+            size_t size = 0;                    // nodes in the body
+            size_t call_sites = 0;              // in the whole program
+            bool recursive = false;             // calls itself, directly or through others
+            std::vector<size_t> calls {};       // functions the out-of-line body calls
+            std::string code {};                // the out-of-line body
+        };
+
+        // Where 'Gib' leaves to with the value in rax: the end of an inlined copy or the epilogue. The last statement of
+        // the body falls through instead.
+        struct Return
+        {
+            std::string label;
+            const NodeStmtGib* tail;
+        };
+
+        std::vector<Function> m_functions;
+        std::unordered_map<std::string, size_t> m_function_index;
+        std::vector<Return> m_returns;
+        std::vector<size_t> m_calls;            // functions the code being generated calls out of line
+        size_t m_loop_depth = 0;
+        size_t m_inline_depth = 0;
+
+        // Inlining: always below the first size, within a budget of copied nodes above it, and up to the second size
+        // inside loops, where a call costs on every iteration
+        static constexpr size_t INLINE_ALWAYS_SIZE = 12;
+        static constexpr size_t INLINE_HOT_SIZE = 48;
+        static constexpr size_t INLINE_GROWTH_BUDGET = 200;
+        static constexpr size_t MAX_INLINE_DEPTH = 4;
+
+        static constexpr const char* ARG_REGS[] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
+
+        bool m_uses_simd = false;
+        bool m_uses_bounds_check = false;
+
+        /* Runtime I/O ('Schreibe', 'Lies') */
+        bool m_uses_output = false;
+        bool m_uses_input = false;
+
+        static constexpr size_t IO_BUFFER_SIZE = 65536;
+        static constexpr size_t MAX_INT_TEXT = 24;      // "-9223372036854775808\n" and some slack
+
+        static constexpr size_t STACK_PAGE_SIZE = 4096;
+
+        /* Profiling ('--profile-gen') */
+        enum class ProfileKind
+        {
+            Stmt,       // executions of a statement
+            Then,       // 'Falls' conditions that held
+            Loop,       // iterations of a 'Solange' body
+            Cycles      // rdtsc cycles spent in a top-level statement
+        };
+
+        struct ProfileCounter
+        {
+            ProfileKind kind;
+            std::string path;
+            std::string text;
+        };
+
+        static constexpr int PROFILE_VERSION = 1;
+
+        std::optional<std::string> m_profile_path;
+        std::vector<ProfileCounter> m_profile;
+        std::map<std::pair<const void*, ProfileKind>, size_t> m_profile_index;
+        std::vector<size_t> m_profile_stmt_path = { 0 };
+        std::optional<size_t> m_profile_cycles;     // open cycle counter of the current top-level statement
+        const NodeStmt* m_profile_stmt = nullptr;   // statement that new counters are attributed to
+        static constexpr int BOUNDS_ERROR_EXIT_CODE = 255;
+
+        /* Expression Generation */
+        // Evaluates 'expr' into a new slot on top of the stack
+        void gen_expr(const NodeExpr* expr)
+        {
+            if (auto it = m_hoisted.find(expr); it != m_hoisted.end())
+            {
+                load_var("rax", (it->second + 1) * 8);
+                store_value(mem_loc(), "rax");
+
+                return;
+            }
+
+            // 'mov m64, imm' only takes a sign-extended 32-bit immediate
+            if (const auto value = const_eval(expr); value.has_value() && fits_imm32(value.value()))
+            {
+                store_value(mem_loc(), std::to_string(value.value()));
+
+                return;
+            }
+
+            gen_value(expr);
+            store_value(mem_loc(), "rax");
+        }
+
+        // Evaluates 'expr' into rax; clobbers rcx and rdx
+        void gen_value(const NodeExpr* expr)
+        {
+            m_covers.clear();
+
+            emit_cover(expr);
+        }
+
+        /* Instruction Selection */
+        enum class Tile
+        {
+            Const,      // mov rax, imm
+            Load,       // mov rax, [mem]
+            Term,       // a term that is not an operand: an index checked at runtime, a call, or an error
+            Logic,      // cmp, then setcc
+            AluRhs,     // first in rax, then 'op rax, <second>'
+            AluLhs,     // the same with the operands swapped, for 'Plus' and 'Mal'
+            SubLhs,     // second - first as 'neg rax', 'add rax, <second>'
+            IncDec,     // inc rax / dec rax
+            Neg,        // neg rax
+            Shift,      // shl rax, imm
+            ShiftRight, // shr rax, imm: division of a non-negative value by a power of two
+            SarRound,   // the same for any sign, rounding towards zero with a bias for negative values
+            DivMagic,   // division of a value in [0, 2^31) by a constant as a multiply and a shift
+            LeaScale,   // lea rax, [rax + rax * (imm - 1)] for 3, 5 and 9
+            LeaIndex,   // mov rcx, <second>; lea rax, [rax + rcx * imm]
+            Spill       // second through a slot, then first in rax and 'op rax, [slot]'
+        };
+
+        // Width of an 'op rax, <second>', as far as the ranges of the operands allow to narrow it
+        enum class Width
+        {
+            Full,       // 64-bit, signed
+            Low32,      // 32-bit; the result is in [0, 2^32), which writing eax zero-extends to the full value
+            Unsigned,   // 64-bit 'div': both operands of the division are non-negative
+            Unsigned32, // 32-bit 'div': both operands in [0, 2^32)
+            Signed32    // 32-bit 'idiv': both operands fit in 32 bits and the quotient does too
+        };
+
+        // Cheapest tiling of a subtree that leaves its value in rax
+        struct Cover
+        {
+            int cost = 0;
+            Tile tile = Tile::Term;
+            const NodeExpr* first = nullptr;
+            const NodeExpr* second = nullptr;
+            int64_t imm = 0;
+            Width width = Width::Full;
+        };
+
+        // Value that an instruction takes directly instead of a register: an immediate or a stack slot
+        struct Operand
+        {
+            std::string text;
+            bool imm = false;
+        };
+
+        // Rough cost per instruction: code size, with extra weight on the slow multiply and divide
+        static constexpr int COST_MOV = 3;
+        static constexpr int COST_LOAD = 4;
+        static constexpr int COST_STORE = 4;
+        static constexpr int COST_ALU = 3;
+        static constexpr int COST_ALU_MEM = 4;
+        static constexpr int COST_UNARY = 2;
+        static constexpr int COST_LEA = 3;
+        static constexpr int COST_IMUL = 6;
+        static constexpr int COST_DIV = 40;
+        static constexpr int COST_DIV32 = 24;
+        static constexpr int COST_CALL = 40;
+
+        std::unordered_map<const NodeExpr*, Cover> m_covers;
+
+        static const NodeExpr* strip_parens(const NodeExpr* expr)
+        {
+            while (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                const auto paren = std::get_if<NodeTermParen*>(&(*term)->var);
+
+                if (paren == nullptr)
+                    break;
+
+                expr = (*paren)->expr;
+            }
+
+            return expr;
+        }
+
+        std::optional<Operand> fold_operand(const NodeExpr* expr)
+        {
+            if (auto it = m_hoisted.find(expr); it != m_hoisted.end())
+                return Operand{ slot_text((it->second + 1) * 8) };
+
+            if (const auto value = const_eval(expr); value.has_value() && fits_imm32(value.value()))
+                return Operand{ std::to_string(value.value()), true };
+
+            expr = strip_parens(expr);
+
+            const auto term = std::get_if<NodeTerm*>(&expr->var);
+
+            if (term == nullptr)
+                return std::nullopt;
+
+            if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+            {
+                const Var* var = find_var_ref((*ident)->ident.value.value());
+
+                if (var != nullptr && var->length == 0)
+                    return Operand{ slot_text((var->mem_loc + 1) * 8) };
+            }
+
+            if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+            {
+                const Var* var = find_var_ref((*index)->ident.value.value());
+                const auto at = const_eval((*index)->index);
+
+                // Anything out of range is left to 'Term', which reports it
+                if (var != nullptr && var->length > 0 && at.has_value() && at.value() >= 0 && static_cast<size_t>(at.value()) < var->length)
+                    return Operand{ slot_text(elem_loc(*var, static_cast<size_t>(at.value()))) };
+            }
+
+            return std::nullopt;
+        }
+
+        static std::string slot_text(const size_t mem)
+        {
+            return std::string("QWORD [rbp - ").append(std::to_string(mem)).append("]");
+        }
+
+        static std::optional<int64_t> power_of_two(const int64_t value)
+        {
+            if (value < 2 || (value & (value - 1)) != 0)
+                return std::nullopt;
+
+            return std::countr_zero(static_cast<uint64_t>(value));
+        }
+
+        const Cover& cover(const NodeExpr* expr)
+        {
+            if (auto it = m_covers.find(expr); it != m_covers.end())
+                return it->second;
+
+            Cover best = select(expr);
+
+            return m_covers[expr] = best;
+        }
+
+        Cover select(const NodeExpr* expr)
+        {
+            if (const auto value = const_eval(expr))
+                return { .cost = COST_MOV, .tile = Tile::Const, .imm = value.value() };
+
+            if (const auto operand = fold_operand(expr); operand.has_value() && !operand->imm)
+                return { .cost = COST_LOAD, .tile = Tile::Load, .first = expr };
+
+            expr = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                const auto index = std::get_if<NodeTermIndex*>(&(*term)->var);
+
+                // The index, the bounds check and the load
+                int cost = index != nullptr ? cover((*index)->index).cost + COST_ALU + 2 + COST_LOAD : COST_LOAD;
+
+                if (std::holds_alternative<NodeTermCall*>((*term)->var))
+                    cost = COST_CALL;
+
+                return { .cost = cost, .tile = Tile::Term, .first = expr };
+            }
+
+            if (const auto logic_expr = std::get_if<NodeLogicExpr*>(&expr->var))
+                return { .cost = cmp_cost(*logic_expr) + 2 * COST_UNARY, .tile = Tile::Logic, .first = expr };
+
+            const NodeBinExpr* bin_expr = std::get<NodeBinExpr*>(expr->var);
+            const BinOp op = bin_expr->op;
+            const NodeExpr* lhs = bin_expr->lhs;
+            const NodeExpr* rhs = bin_expr->rhs;
+
+            const auto lhs_operand = fold_operand(lhs);
+            const auto rhs_operand = fold_operand(rhs);
+            const auto lhs_value = const_eval(lhs);
+            const auto rhs_value = const_eval(rhs);
+            const bool commutative = op == BinOp::Add || op == BinOp::Mul;
+            const Range lhs_range = range_of(lhs);
+            const Width width = narrow(op, lhs_range, range_of(rhs));
+
+            const auto op_cost = [&](const Operand& operand)
+            {
+                if (op == BinOp::Div)
+                    return (width == Width::Unsigned32 || width == Width::Signed32 ? COST_DIV32 : COST_DIV) + (operand.imm ? COST_MOV : 0);
+
+                if (op == BinOp::Mul)
+                    return COST_IMUL;
+
+                return operand.imm ? COST_ALU : COST_ALU_MEM;
+            };
+
+            Cover best = { .cost = cover(rhs).cost + COST_STORE + cover(lhs).cost + op_cost({}),
+                           .tile = Tile::Spill, .first = lhs, .second = rhs, .width = width };
+
+            const auto consider = [&](const Cover& candidate)
+            {
+                if (candidate.cost < best.cost)
+                    best = candidate;
+            };
+
+            if (rhs_operand.has_value())
+                consider({ .cost = cover(lhs).cost + op_cost(rhs_operand.value()), .tile = Tile::AluRhs, .first = lhs, .second = rhs,
+                           .width = width });
+
+            if (lhs_operand.has_value() && commutative)
+                consider({ .cost = cover(rhs).cost + op_cost(lhs_operand.value()), .tile = Tile::AluLhs, .first = rhs, .second = lhs,
+                           .width = width });
+
+            if (lhs_operand.has_value() && op == BinOp::Sub)
+                consider({ .cost = cover(rhs).cost + COST_UNARY + op_cost(lhs_operand.value()), .tile = Tile::SubLhs, .first = rhs, .second = lhs });
+
+            // The same patterns with the constant on either side, where the operator allows it
+            for (const auto& [value, other] : { std::pair{ rhs_value, lhs }, std::pair{ lhs_value, rhs } })
+            {
+                if (!value.has_value())
+                    continue;
+
+                const bool left = other == rhs;
+                const int other_cost = cover(other).cost;
+
+                if ((op == BinOp::Add && (value == 1 || value == -1)) || (op == BinOp::Sub && !left && (value == 1 || value == -1)))
+                    consider({ .cost = other_cost + COST_UNARY, .tile = Tile::IncDec, .first = other,
+                               .imm = op == BinOp::Add ? value.value() : -value.value() });
+
+                if ((op == BinOp::Sub && left && value == 0) || (op == BinOp::Mul && value == -1))
+                    consider({ .cost = other_cost + COST_UNARY, .tile = Tile::Neg, .first = other });
+
+                if (op == BinOp::Mul && power_of_two(value.value()).has_value())
+                    consider({ .cost = other_cost + COST_UNARY, .tile = Tile::Shift, .first = other, .imm = power_of_two(value.value()).value() });
+
+                if (op == BinOp::Mul && (value == 3 || value == 5 || value == 9))
+                    consider({ .cost = other_cost + COST_LEA, .tile = Tile::LeaScale, .first = other, .imm = value.value() - 1 });
+            }
+
+            // Division by a constant without 'idiv'
+            if (op == BinOp::Div && rhs_value.has_value())
+            {
+                const int64_t divisor = rhs_value.value();
+                const int lhs_cost = cover(lhs).cost;
+
+                if (const auto shift = power_of_two(divisor))
+                {
+                    if (lhs_range.lo >= 0)
+                        consider({ .cost = lhs_cost + COST_UNARY, .tile = Tile::ShiftRight, .first = lhs, .imm = shift.value() });
+                    else
+                        consider({ .cost = lhs_cost + COST_MOV + 4 * COST_UNARY, .tile = Tile::SarRound, .first = lhs, .imm = shift.value() });
+                }
+                else if (lhs_range.lo >= 0 && lhs_range.hi <= INT32_MAX && divisor >= 3 && divisor <= INT32_MAX)
+                    consider({ .cost = lhs_cost + COST_MOV + COST_IMUL + COST_UNARY, .tile = Tile::DivMagic, .first = lhs, .imm = divisor });
+            }
+
+            // 'x + y * 2, 4 or 8' with y in a slot is one load and one lea
+            if (op == BinOp::Add)
+            {
+                for (const auto& [base, scaled] : { std::pair{ lhs, rhs }, std::pair{ rhs, lhs } })
+                {
+                    const auto mul = std::get_if<NodeBinExpr*>(&strip_parens(scaled)->var);
+
+                    if (mul == nullptr || (*mul)->op != BinOp::Mul)
+                        continue;
+
+                    const auto scale = const_eval((*mul)->rhs);
+                    const auto index = fold_operand((*mul)->lhs);
+
+                    if (!scale.has_value() || (scale != 2 && scale != 4 && scale != 8) || !index.has_value() || index->imm)
+                        continue;
+
+                    consider({ .cost = cover(base).cost + COST_LOAD + COST_LEA, .tile = Tile::LeaIndex, .first = base,
+                               .second = (*mul)->lhs, .imm = scale.value() });
+                }
+            }
+
+            return best;
+        }
+
+        void emit_cover(const NodeExpr* expr)
+        {
+            const Cover c = cover(expr);
+
+            switch (c.tile)
+            {
+                case Tile::Const:
+                    if (c.imm == 0)
+                        m_temp << "    xor eax, eax\n";
+                    else
+                        gen_imm("rax", c.imm);
+
+                    return;
+
+                case Tile::Load:
+                    m_temp << "    mov rax, " << fold_operand(c.first)->text << "\n";
+                    return;
+
+                case Tile::Term:
+                    emit_term(std::get<NodeTerm*>(c.first->var));
+                    return;
+
+                case Tile::Logic:
+                {
+                    const NodeLogicExpr* logic_expr = std::get<NodeLogicExpr*>(c.first->var);
+
+                    gen_cmp(logic_expr);
+
+                    m_temp << "    " << set_cc(logic_expr->op) << " al\n";
+                    m_temp << "    movzx eax, al\n";
+
+                    return;
+                }
+
+                case Tile::AluRhs:
+                case Tile::AluLhs:
+                    emit_cover(c.first);
+                    emit_alu(std::get<NodeBinExpr*>(strip_parens(expr)->var)->op, fold_operand(c.second).value(), c.width);
+                    return;
+
+                case Tile::SubLhs:
+                    emit_cover(c.first);
+
+                    m_temp << "    neg rax\n";
+                    m_temp << "    add rax, " << fold_operand(c.second)->text << "\n";
+
+                    return;
+
+                case Tile::IncDec:
+                    emit_cover(c.first);
+
+                    m_temp << "    " << (c.imm == 1 ? "inc" : "dec") << " rax\n";
+                    return;
+
+                case Tile::Neg:
+                    emit_cover(c.first);
+
+                    m_temp << "    neg rax\n";
+                    return;
+
+                case Tile::Shift:
+                    emit_cover(c.first);
+
+                    m_temp << "    shl rax, " << c.imm << "\n";
+                    return;
+
+                case Tile::ShiftRight:
+                    emit_cover(c.first);
+
+                    m_temp << "    shr rax, " << c.imm << "\n";
+                    return;
+
+                case Tile::SarRound:
+                    emit_cover(c.first);
+
+                    // Adds 2^imm - 1 to a negative dividend, so that the shift rounds towards zero like 'idiv'
+                    m_temp << "    mov rcx, rax\n";
+                    m_temp << "    sar rcx, 63\n";
+                    m_temp << "    shr rcx, " << 64 - c.imm << "\n";
+                    m_temp << "    add rax, rcx\n";
+                    m_temp << "    sar rax, " << c.imm << "\n";
+
+                    return;
+
+                case Tile::DivMagic:
+                {
+                    // floor(x / d) = floor(x * m / 2^s) for x < 2^31 with s = 31 + ceil(log2 d) and m = floor(2^s / d) + 1,
+                    // and x * m stays below 2^63
+                    const int shift = 31 + std::bit_width(static_cast<uint64_t>(c.imm - 1));
+                    const uint64_t magic = (uint64_t{ 1 } << shift) / static_cast<uint64_t>(c.imm) + 1;
+
+                    emit_cover(c.first);
+
+                    m_temp << "    mov rcx, " << magic << "\n";
+                    m_temp << "    imul rax, rcx\n";
+                    m_temp << "    shr rax, " << shift << "\n";
+
+                    return;
+                }
+
+                case Tile::LeaScale:
+                    emit_cover(c.first);
+
+                    m_temp << "    lea rax, [rax + rax * " << c.imm << "]\n";
+                    return;
+
+                case Tile::LeaIndex:
+                    emit_cover(c.first);
+
+                    m_temp << "    mov rcx, " << fold_operand(c.second)->text << "\n";
+                    m_temp << "    lea rax, [rax + rcx * " << c.imm << "]\n";
+
+                    return;
+
+                case Tile::Spill:
+                {
+                    // Calls write output, so with a call on either side the left one goes first
+                    if (contains_call(c.first) || contains_call(c.second))
+                    {
+                        const size_t slot = emit_in_order(c.first, c.second);
+
+                        emit_alu(std::get<NodeBinExpr*>(strip_parens(expr)->var)->op, Operand{ slot_text(slot) }, c.width);
+
+                        m_mem_size -= 2;
+
+                        return;
+                    }
+
+                    emit_cover(c.second);
+                    store_value(mem_loc(), "rax");
+
+                    const size_t slot = mem_loc();
+
+                    emit_cover(c.first);
+                    emit_alu(std::get<NodeBinExpr*>(strip_parens(expr)->var)->op, Operand{ slot_text(slot) }, c.width);
+
+                    m_mem_size--;
+
+                    return;
+                }
+            }
+        }
+
+        // 'op rax, operand'; divides rdx:rax, so rdx is lost. The 32-bit forms read the low half of the operands, which
+        // is all of them where 'narrow' picks these forms.
+        void emit_alu(const BinOp op, const Operand& operand, const Width width = Width::Full)
+        {
+            const bool low = width == Width::Low32 || width == Width::Unsigned32 || width == Width::Signed32;
+            const char* acc = low ? "eax" : "rax";
+            const std::string text = low && !operand.imm ? std::string("DWORD").append(operand.text.substr(5)) : operand.text;
+
+            switch (op)
+            {
+                case BinOp::Add:
+                    m_temp << "    add " << acc << ", " << text << "\n";
+                    break;
+
+                case BinOp::Sub:
+                    m_temp << "    sub " << acc << ", " << text << "\n";
+                    break;
+
+                case BinOp::Mul:
+                    if (operand.imm)
+                        m_temp << "    imul " << acc << ", " << acc << ", " << text << "\n";
+                    else
+                        m_temp << "    imul " << acc << ", " << text << "\n";
+
+                    break;
+
+                case BinOp::Div:
+                {
+                    const char* divisor = low ? "ecx" : "rcx";
+
+                    if (operand.imm)
+                        m_temp << "    mov " << divisor << ", " << text << "\n";
+
+                    const std::string source = operand.imm ? divisor : text;
+
+                    if (width == Width::Unsigned || width == Width::Unsigned32)
+                    {
+                        m_temp << "    xor edx, edx\n";
+                        m_temp << "    div " << source << "\n";
+                    }
+                    else if (width == Width::Signed32)
+                    {
+                        m_temp << "    cdq\n";
+                        m_temp << "    idiv " << source << "\n";
+                        m_temp << "    movsxd rax, eax\n";
+                    }
+                    else
+                    {
+                        m_temp << "    cqo\n";
+                        m_temp << "    idiv " << source << "\n";
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        // The narrowest form of 'a op b' that computes the same 64-bit value
+        static Width narrow(const BinOp op, const Range& a, const Range& b)
+        {
+            if (op != BinOp::Div)
+            {
+                const Range result = range_bin(op, a, b);
+
+                return result.lo >= 0 && result.hi <= UINT32_MAX ? Width::Low32 : Width::Full;
+            }
+
+            // A divisor of 0 traps in every form
+            if (a.lo >= 0 && b.lo >= 0)
+                return a.hi <= UINT32_MAX && b.hi <= UINT32_MAX ? Width::Unsigned32 : Width::Unsigned;
+
+            // INT32_MIN / -1 traps in 32 bits, but not in 64
+            const bool fits = a.lo >= INT32_MIN && a.hi <= INT32_MAX && b.lo >= INT32_MIN && b.hi <= INT32_MAX;
+
+            if (fits && !(a.lo == INT32_MIN && b.lo <= -1 && b.hi >= -1))
+                return Width::Signed32;
+
+            return Width::Full;
+        }
+
+        // Terms that are not a plain operand; undeclared names, arrays without an index and constant indices out of range
+        // are reported here
+        void emit_term(const NodeTerm* term)
+        {
+            if (const auto call = std::get_if<NodeTermCall*>(&term->var))
+            {
+                gen_call(*call);
+
+                return;
+            }
+
+            if (const auto int_lit = std::get_if<NodeTermIntLit*>(&term->var))
+            {
+                m_temp << "    mov rax, " << (*int_lit)->int_lit.value.value() << "\n";
+
+                return;
+            }
+
+            if (const auto ident = std::get_if<NodeTermIdent*>(&term->var))
+            {
+                const Var* var = find_var_ref((*ident)->ident.value.value());
+
+                if (var == nullptr)
+                {
+                    compile_error_at((*ident)->ident.offset, "Fehler: Bezeichner '", (*ident)->ident.value.value(), "' ist nicht deklariert");
+                }
+
+                compile_error_at((*ident)->ident.offset, "Fehler: Feld '", (*ident)->ident.value.value(), "' kann hier nur mit Index verwendet werden");
+            }
+
+            const NodeTermIndex* t = std::get<NodeTermIndex*>(term->var);
+            const Var& var = find_array(t->ident);
+
+            if (const auto index = const_eval(t->index))
+            {
+                if (index_in_bounds(var, index.value(), t->index, t->ident))
+                    load_var("rax", elem_loc(var, static_cast<size_t>(index.value())));
+                else
+                    gen_bounds_fail();
+
+                return;
+            }
+
+            emit_cover(t->index);
+            bounds_check("rax", var, range_of(t->index));
+
+            m_temp << "    mov rax, QWORD [rbp + rax * 8 - " << elem_loc(var, 0) << "]\n";
+        }
+
+        int cmp_cost(const NodeLogicExpr* logic_expr)
+        {
+            const auto rhs_operand = fold_operand(logic_expr->rhs);
+            const auto lhs_operand = fold_operand(logic_expr->lhs);
+
+            if (rhs_operand.has_value())
+                return cover(logic_expr->lhs).cost + (rhs_operand->imm ? COST_ALU : COST_ALU_MEM);
+
+            if (lhs_operand.has_value())
+                return cover(logic_expr->rhs).cost + (lhs_operand->imm ? COST_MOV + COST_ALU : COST_ALU_MEM);
+
+            return cover(logic_expr->rhs).cost + COST_STORE + cover(logic_expr->lhs).cost + COST_ALU_MEM;
+        }
+
+        // Evaluates both operands and leaves the flags of 'lhs cmp rhs' set
+        void gen_cmp(const NodeLogicExpr* logic_expr)
+        {
+            const auto rhs_operand = fold_operand(logic_expr->rhs);
+            const auto lhs_operand = fold_operand(logic_expr->lhs);
+
+            if (rhs_operand.has_value())
+            {
+                emit_cover(logic_expr->lhs);
+
+                // Same flags as 'cmp rax, 0', one byte shorter
+                if (rhs_operand->text == "0")
+                    m_temp << "    test rax, rax\n";
+                else
+                    m_temp << "    cmp rax, " << rhs_operand->text << "\n";
+
+                return;
+            }
+
+            if (lhs_operand.has_value())
+            {
+                emit_cover(logic_expr->rhs);
+
+                if (lhs_operand->imm)
+                {
+                    m_temp << "    mov rcx, " << lhs_operand->text << "\n";
+                    m_temp << "    cmp rcx, rax\n";
+                }
+                else
+                    m_temp << "    cmp " << lhs_operand->text << ", rax\n";
+
+                return;
+            }
+
+            if (contains_call(logic_expr->lhs) || contains_call(logic_expr->rhs))
+            {
+                const size_t slot = emit_in_order(logic_expr->lhs, logic_expr->rhs);
+
+                m_temp << "    cmp rax, " << slot_text(slot) << "\n";
+
+                m_mem_size -= 2;
+
+                return;
+            }
+
+            emit_cover(logic_expr->rhs);
+            store_value(mem_loc(), "rax");
+
+            const size_t slot = mem_loc();
+
+            emit_cover(logic_expr->lhs);
+
+            m_temp << "    cmp rax, " << slot_text(slot) << "\n";
+
+            m_mem_size--;
+        }
+
+        // Leaves lhs in rax and rhs in the returned slot, both spilled in between; the caller frees the two slots
+        size_t emit_in_order(const NodeExpr* lhs, const NodeExpr* rhs)
+        {
+            emit_cover(lhs);
+            store_value(mem_loc(), "rax");
+
+            const size_t left = mem_loc();
+
+            emit_cover(rhs);
+            store_value(mem_loc(), "rax");
+
+            m_temp << "    mov rax, " << slot_text(left) << "\n";
+
+            return mem_loc();
+        }
+
+        // Jumps to 'label' if the condition evaluates to 'when'
+        void gen_cond_jump(const NodeExpr* expr, const std::string& label, bool when)
+        {
+            m_covers.clear();
+
+            if (const auto value = const_eval(expr))
+            {
+                if ((value.value() != 0) == when)
+                    m_temp << "    jmp " << label << "\n";
+
+                return;
+            }
+
+            if (const auto logic_expr = std::get_if<NodeLogicExpr*>(&expr->var))
+            {
+                gen_cmp(*logic_expr);
+
+                const LogicOp op = when ? (*logic_expr)->op : negate((*logic_expr)->op);
+
+                m_temp << "    " << jump_cc(op) << " " << label << "\n";
+
+                return;
+            }
+
+            emit_cover(expr);
+
+            m_temp << "    test rax, rax\n";
+            m_temp << "    " << (when ? "jnz " : "jz ") << label << "\n";
+        }
+        
+        /* Statement Generation */
+        void gen_stmt(const NodeStmt* stmt)
+        {
+            // A definition has no code where it stands; the function is generated at its calls and after the program
+            if (std::holds_alternative<NodeStmtFunktion*>(stmt->var))
+            {
+                if (m_profile_path.has_value())
+                    m_profile_stmt_path.back()++;
+
+                return;
+            }
+
+            const bool top_level = m_profile_stmt_path.size() == 1;
+
+            if (m_profile_path.has_value())
+            {
+                m_profile_stmt_path.back()++;
+                m_profile_stmt = stmt;
+
+                // Cycles are only accumulated around top-level statements, nested timers would distort them
+                if (top_level)
+                {
+                    m_profile_cycles = profile_counter(stmt, ProfileKind::Cycles);
+
+                    gen_cycles(m_profile_cycles.value(), true);
+                }
+
+                gen_profile_count(profile_counter(stmt, ProfileKind::Stmt));
+
+                m_profile_stmt_path.push_back(0);
+            }
+
+            // Whatever a loop assigns has another value in every iteration, so the loop gets fresh numbers for it up front
+            if (std::holds_alternative<NodeStmtSolange*>(stmt->var))
+                renumber_assigned(stmt);
+
+            std::vector<const NodeExpr*> reused;
+
+            m_numbered.clear();
+
+            for (const NodeExpr* expr : own_exprs(stmt))
+                reuse_available(expr, reused);
+
+            struct Visitor
+            {
+                Generator& gen;
+
+                void operator()(const NodeScope* scope) const
+                {
+                    gen.gen_scope(scope);
+                }
+
+                void operator()(const NodeStmtBestimme* s) const
+                {
+                    if (gen.find_var(s->ident.value.value()))
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' wird bereits verwendet");
+                    }
+
+                    gen.m_temp << "\n    ; Bestimme\n";
+
+                    const std::optional<size_t> slot = gen.global_slot(s);
+
+                    if (s->length > 0)
+                    {
+                        gen.push_var({s->ident.value.value(), slot.value_or(gen.m_mem_size), std::nullopt, s->length});
+
+                        if (!slot.has_value())
+                            gen.track_mem(s->length);
+
+                        gen.gen_array_zero(gen.m_vars.back());
+
+                        gen.m_temp << "    ; /Bestimme\n";
+
+                        return;
+                    }
+                    
+                    const std::optional<int64_t> value = gen.const_eval(s->expr);
+
+                    gen.push_var({s->ident.value.value(), slot.value_or(gen.m_mem_size), value, 0, gen.range_of(s->expr)});
+
+                    if (slot.has_value())
+                    {
+                        gen.gen_value(s->expr);
+                        gen.overwrite_value((slot.value() + 1) * 8, "rax");
+                    }
+                    else
+                        gen.gen_expr(s->expr);
+
+                    gen.m_temp << "    ; /Bestimme\n";
+                }
+
+                void operator()(const NodeStmtÄndere* s) const
+                {
+                    Var* var = gen.find_var_ref(s->ident.value.value());
+
+                    if (var == nullptr)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' ist nicht deklariert");
+                    }
+
+                    gen.m_temp << "\n    ; Ändere\n";
+
+                    if (s->index.has_value() || var->length > 0)
+                    {
+                        const Var& array = gen.find_array(s->ident);
+
+                        if (s->index.has_value())
+                            gen.gen_elem_store(array, s->index.value(), s->expr, s->ident);
+                        else
+                            gen.gen_array_assign(array, s->expr, s->ident);
+
+                        gen.m_temp << "    ; /Ändere\n";
+
+                        return;
+                    }
+
+                    const std::optional<int64_t> value = gen.const_eval(s->expr);
+                    const Range range = gen.range_of(s->expr);
+
+                    gen.gen_value(s->expr);
+                    gen.overwrite_value((var->mem_loc + 1) * 8, "rax");
+
+                    var->value = value;
+                    var->range = range;
+
+                    gen.m_temp << "    ; /Ändere\n";
+                }
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    if (gen.gen_falls_chain(s))
+                        return;
+
+                    gen.gen_falls(s);
+                }
+
+                void operator()(const NodeStmtSolange* s) const
+                {
+                    gen.gen_solange(s);
+                }
+
+                void operator()(const NodeStmtBeende* s) const
+                {
+                    gen.declare_extern_once("ExitProcess");
+
+                    gen.m_temp << "\n    ; " << gen.exit_routine() << "\n";
+
+                    gen.gen_value(s->expr);
+
+                    gen.m_temp << "    mov rcx, rax\n";
+
+                    if (gen.m_profile_path.has_value())
+                    {
+                        // A function called out of line has no cycle counter of its own open
+                        if (gen.m_profile_cycles.has_value())
+                            gen.gen_cycles(gen.m_profile_cycles.value(), false);
+
+                        gen.m_temp << "    call denk_prof_write\n";
+                    }
+
+                    gen.m_temp << "    call " << gen.exit_routine() << "\n"
+                               << "    ; /" << gen.exit_routine() << "\n";
+                }
+
+                void operator()(const NodeStmtSchreibe* s) const
+                {
+                    gen.m_temp << "\n    ; Schreibe\n";
+
+                    gen.gen_value(s->expr);
+
+                    gen.m_temp << "    mov rcx, rax\n";
+
+                    gen.m_temp << "    call denk_write_int\n"
+                               << "    ; /Schreibe\n";
+                }
+
+                void operator()(const NodeStmtLies* s) const
+                {
+                    Var* var = gen.find_var_ref(s->ident.value.value());
+
+                    if (var == nullptr)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Bezeichner '", s->ident.value.value(), "' ist nicht deklariert");
+                    }
+
+                    if (var->length > 0)
+                    {
+                        compile_error_at(s->ident.offset, "Fehler: Feld '", s->ident.value.value(), "' kann nicht eingelesen werden");
+                    }
+
+                    gen.m_temp << "\n    ; Lies\n";
+                    gen.m_temp << "    call denk_read_int\n";
+
+                    gen.overwrite_value((var->mem_loc + 1) * 8, "rax");
+
+                    var->value = std::nullopt;
+                    var->range = {};
+
+                    gen.m_temp << "    ; /Lies\n";
+                }
+
+                void operator()(const NodeStmtFunktion*) const {}
+
+                void operator()(const NodeStmtGib* s) const
+                {
+                    if (gen.m_returns.empty())
+                    {
+                        compile_error_at(s->offset, "Fehler: 'Gib ... zurück' ist nur in Funktionen erlaubt");
+                    }
+
+                    gen.m_temp << "\n    ; Gib\n";
+
+                    gen.gen_value(s->expr);
+
+                    if (s != gen.m_returns.back().tail)
+                        gen.m_temp << "    jmp " << gen.m_returns.back().label << "\n";
+
+                    gen.m_temp << "    ; /Gib\n";
+                }
+            };
+            
+            std::visit(Visitor{ *this }, stmt->var);
+
+            for (const NodeExpr* expr : reused)
+                m_hoisted.erase(expr);
+
+            renumber_assigned(stmt);
+
+            if (m_profile_path.has_value())
+            {
+                m_profile_stmt_path.pop_back();
+
+                if (top_level)
+                {
+                    gen_cycles(m_profile_cycles.value(), false);
+
+                    m_profile_cycles = std::nullopt;
+                }
+            }
+        }
+
+        void gen_scope(const NodeScope* scope)
+        {
+            begin_scope();
+
+            gen_stmts(scope->stmts);
+
+            end_scope();
+        }
+
+        // The statements of one block, each after keeping what the following ones compute again
+        void gen_stmts(const std::vector<NodeStmt*>& stmts)
+        {
+            for (size_t i = 0; i < stmts.size(); i++)
+            {
+                std::optional<Lookahead> ahead;
+
+                m_numbered.clear();
+                m_covers.clear();
+
+                for (const NodeExpr* expr : own_exprs(stmts[i]))
+                    keep_common(expr, stmts, i, ahead);
+
+                m_covers.clear();
+
+                gen_stmt(stmts[i]);
+            }
+        }
+
+        /* Segmented Generation */
+        /*
+         * Pre-pass for a large program: cuts the top-level statements into segments of at least MIN_GEN_SEGMENT_SIZE nodes.
+         * The cuts depend on the program alone, so the assembly is the same for any number of threads. A profiled program
+         * numbers its counters in program order and stays in one piece.
+         */
+        std::vector<Segment> plan_segments() const
+        {
+            std::vector<Segment> segments;
+
+            if (m_profile_path.has_value())
+                return segments;
+
+            size_t begin = 0;
+            size_t size = 0;
+
+            for (size_t i = 0; i < m_prog.stmts.size(); i++)
+            {
+                size += count_nodes({ m_prog.stmts[i] });
+
+                if (size >= MIN_GEN_SEGMENT_SIZE || i + 1 == m_prog.stmts.size())
+                {
+                    segments.push_back({ .begin = begin, .end = i + 1 });
+
+                    begin = i + 1;
+                    size = 0;
+                }
+            }
+
+            // Nothing to gain from a single segment, its boundaries would only cost the constants they forget
+            if (segments.size() == 1)
+                segments.clear();
+
+            return segments;
+        }
+
+        /*
+         * Generates every segment into a buffer of its own, on up to 'm_jobs' threads, and stitches the buffers together in
+         * program order. The top-level variables get fixed slots at the bottom of the frame, each segment takes its hidden
+         * slots and temporaries from above them and its labels from a range of its own. A segment starts knowing nothing
+         * about the values of the variables, as after a loop, so it depends on no other segment.
+         */
+        void gen_segments(const std::vector<Segment>& segments)
+        {
+            std::unordered_map<const NodeStmtBestimme*, size_t> slots;
+            std::unordered_set<std::string_view> declared;
+            std::vector<Var> globals;
+            std::vector<size_t> known(segments.size());    // globals declared before each segment
+            size_t base = 0;
+
+            for (size_t i = 0, segment = 0; i < m_prog.stmts.size(); i++)
+            {
+                if (i == segments[segment].end)
+                    segment++;
+
+                if (i == segments[segment].begin)
+                    known[segment] = globals.size();
+
+                const auto bestimme = std::get_if<NodeStmtBestimme*>(&m_prog.stmts[i]->var);
+
+                // A second declaration of the same name is reported by the segment it is in
+                if (bestimme == nullptr || !declared.insert((*bestimme)->ident.value.value()).second)
+                    continue;
+
+                slots.emplace(*bestimme, base);
+                globals.push_back({ (*bestimme)->ident.value.value(), base, std::nullopt, (*bestimme)->length });
+                base += std::max<size_t>((*bestimme)->length, 1);
+            }
+
+            std::vector<std::unique_ptr<Generator>> parts;
+            std::vector<std::optional<CompileError>> errors(segments.size());
+
+            for (size_t i = 0; i < segments.size(); i++)
+            {
+                const Segment& segment = segments[i];
+
+                parts.push_back(std::make_unique<Generator>(NodeProg{ { m_prog.stmts.begin() + segment.begin, m_prog.stmts.begin() + segment.end } },
+                                                            std::nullopt, m_freestanding));
+
+                Generator& part = *parts.back();
+
+                part.m_functions = m_functions;
+                part.m_function_index = m_function_index;
+                part.m_uses_output = m_uses_output;
+                part.m_uses_input = m_uses_input;
+                part.m_global_slots = &slots;
+                part.m_label_prefix = ".L" + std::to_string(i) + "_";
+
+                for (size_t j = 0; j < known[i]; j++)
+                    part.push_var(globals[j]);
+
+                part.m_mem_size = base;
+                part.m_max_mem_size = base;
+            }
+
+            const auto gen_part = [&](const size_t i)
+            {
+                try
+                {
+                    parts[i]->gen_stmts(parts[i]->m_prog.stmts);
+                }
+                catch (const CompileError& e)
+                {
+                    errors[i] = e;
+                }
+            };
+
+            if (m_jobs > 1)
+            {
+                ThreadPool pool(std::min(m_jobs, segments.size()));
+
+                for (size_t i = 0; i < segments.size(); i++)
+                    pool.submit([&, i] { gen_part(i); });
+
+                pool.wait();
+            }
+            else
+            {
+                for (size_t i = 0; i < segments.size(); i++)
+                    gen_part(i);
+            }
+
+            // The first error in program order, as without segments
+            for (const std::optional<CompileError>& error : errors)
+                if (error.has_value())
+                    throw error.value();
+
+            for (const std::unique_ptr<Generator>& part : parts)
+            {
+                m_temp << part->m_temp.str();
+                m_cold << part->m_cold.str();
+
+                for (const std::string& name : part->m_extern)
+                    declare_extern_once(name);
+
+                for (const size_t index : part->m_calls)
+                    if (std::ranges::find(m_calls, index) == m_calls.end())
+                        m_calls.push_back(index);
+
+                m_uses_simd |= part->m_uses_simd;
+                m_uses_bounds_check |= part->m_uses_bounds_check;
+                m_max_mem_size = std::max(m_max_mem_size, part->m_max_mem_size);
+            }
+        }
+
+        // The slot the pre-pass fixed for a top-level variable, if the program is generated in segments
+        std::optional<size_t> global_slot(const NodeStmtBestimme* s) const
+        {
+            if (m_global_slots == nullptr)
+                return std::nullopt;
+
+            if (const auto it = m_global_slots->find(s); it != m_global_slots->end())
+                return it->second;
+
+            return std::nullopt;
+        }
+
+        /* Profile Generation */
+        static const char* profile_kind_name(const ProfileKind kind)
+        {
+            switch (kind)
+            {
+                case ProfileKind::Stmt:   return "Anweisung";
+                case ProfileKind::Then:   return "dann";
+                case ProfileKind::Loop:   return "Durchlauf";
+                case ProfileKind::Cycles: return "Zyklen";
+            }
+
+            return "";
+        }
+
+        // A node keeps its counter when it is generated more than once, e.g. in an unrolled loop
+        size_t profile_counter(const void* node, const ProfileKind kind)
+        {
+            const auto [it, inserted] = m_profile_index.try_emplace({ node, kind }, m_profile.size());
+
+            if (inserted)
+            {
+                std::string path;
+
+                // The last entry counts the children of the current statement
+                for (size_t i = 0; i < m_profile_stmt_path.size(); i++)
+                {
+                    if (i + 1 == m_profile_stmt_path.size() && kind != ProfileKind::Stmt && kind != ProfileKind::Cycles)
+                        break;
+
+                    if (!path.empty())
+                        path += '.';
+
+                    path += std::to_string(m_profile_stmt_path[i]);
+                }
+
+                m_profile.push_back({ kind, path, describe_stmt(m_profile_stmt) });
+            }
+
+            return it->second;
+        }
+
+        void gen_profile_count(const size_t counter)
+        {
+            m_temp << "    inc QWORD [rel denk_prof + " << counter * 8 << "]\n";
+        }
+
+        // Subtracts the time stamp at the start and adds it at the end, clobbers rax and rdx
+        void gen_cycles(const size_t counter, const bool start)
+        {
+            m_temp << "    rdtsc\n";
+            m_temp << "    shl rdx, 32\n";
+            m_temp << "    or rax, rdx\n";
+            m_temp << "    " << (start ? "sub" : "add") << " QWORD [rel denk_prof + " << counter * 8 << "], rax\n";
+        }
+
+        // Writes "DENKPROF", the counter count and the counters to the profile file; keeps the exit code in rcx
+        void gen_profile_runtime()
+        {
+            const size_t count = std::max<size_t>(m_profile.size(), 1);
+
+            m_output << "\ndenk_prof_write:\n";
+
+            if (m_freestanding)
+                gen_profile_write_syscalls(count);
+            else
+                gen_profile_write_winapi(count);
+
+            // Bytes instead of string literals, so no path needs escaping
+            const auto bytes = [&](std::string_view text)
+            {
+                for (size_t i = 0; i < text.size(); i++)
+                    m_output << (i == 0 ? "" : ", ") << static_cast<int>(static_cast<unsigned char>(text[i]));
+            };
+
+            m_output << "\nsection .data\n";
+            m_output << "    denk_prof_header: db ";
+            bytes("DENKPROF");
+            m_output << "\n";
+            m_output << "    dq " << count << "\n";
+            m_output << "    denk_prof_path: db ";
+            bytes(m_profile_path.value());
+            m_output << (m_profile_path->empty() ? "" : ", ") << "0\n";
+        }
+
+        void gen_profile_write_syscalls(const size_t count)
+        {
+            m_output << "    push rbx\n";
+            m_output << "    push rcx\n";
+            m_output << "    push rsi\n";
+            m_output << "    push rdi\n";
+            m_output << "    mov eax, 2\n";                     // open
+            m_output << "    lea rdi, [rel denk_prof_path]\n";
+            m_output << "    mov esi, 0x241\n";                 // O_WRONLY | O_CREAT | O_TRUNC
+            m_output << "    mov edx, 0x1A4\n";                 // 0644
+            m_output << "    syscall\n";
+            m_output << "    test rax, rax\n";
+            m_output << "    js .done\n";
+            m_output << "    mov rbx, rax\n";
+
+            const std::pair<const char*, size_t> chunks[] = { { "denk_prof_header", 16 }, { "denk_prof", count * 8 } };
+
+            for (const auto& [label, size] : chunks)
+            {
+                m_output << "    mov eax, 1\n";                 // write
+                m_output << "    mov rdi, rbx\n";
+                m_output << "    lea rsi, [rel " << label << "]\n";
+                m_output << "    mov edx, " << size << "\n";
+                m_output << "    syscall\n";
+            }
+
+            m_output << "    mov eax, 3\n";                     // close
+            m_output << "    mov rdi, rbx\n";
+            m_output << "    syscall\n";
+            m_output << ".done:\n";
+            m_output << "    pop rdi\n";
+            m_output << "    pop rsi\n";
+            m_output << "    pop rcx\n";
+            m_output << "    pop rbx\n";
+            m_output << "    ret\n";
+        }
+
+        void gen_profile_write_winapi(const size_t count)
+        {
+            m_output << "    push rbx\n";
+            m_output << "    push rcx\n";
+            m_output << "    sub rsp, 72\n";
+            m_output << "    lea rcx, [rel denk_prof_path]\n";
+            m_output << "    mov edx, 0x40000000\n";             // GENERIC_WRITE
+            m_output << "    xor r8d, r8d\n";
+            m_output << "    xor r9d, r9d\n";
+            m_output << "    mov QWORD [rsp + 32], 2\n";         // CREATE_ALWAYS
+            m_output << "    mov QWORD [rsp + 40], 0x80\n";      // FILE_ATTRIBUTE_NORMAL
+            m_output << "    mov QWORD [rsp + 48], 0\n";
+            m_output << "    call CreateFileA\n";
+            m_output << "    cmp rax, -1\n";
+            m_output << "    je .done\n";
+            m_output << "    mov rbx, rax\n";
+
+            const std::pair<const char*, size_t> chunks[] = { { "denk_prof_header", 16 }, { "denk_prof", count * 8 } };
+
+            for (const auto& [label, size] : chunks)
+            {
+                m_output << "    mov rcx, rbx\n";
+                m_output << "    lea rdx, [rel " << label << "]\n";
+                m_output << "    mov r8d, " << size << "\n";
+                m_output << "    lea r9, [rsp + 56]\n";
+                m_output << "    mov QWORD [rsp + 32], 0\n";
+                m_output << "    call WriteFile\n";
+            }
+
+            m_output << "    mov rcx, rbx\n";
+            m_output << "    call CloseHandle\n";
+            m_output << ".done:\n";
+            m_output << "    add rsp, 72\n";
+            m_output << "    pop rcx\n";
+            m_output << "    pop rbx\n";
+            m_output << "    ret\n";
+        }
+
+        /* Runtime I/O */
+        // With buffered output every exit has to go through 'denk_exit', which flushes first; the exit code stays in rcx
+        const char* exit_routine() const
+        {
+            return m_uses_output ? "denk_exit" : process_exit();
+        }
+
+        const char* process_exit() const
+        {
+            return m_freestanding ? "denk_sys_exit" : "ExitProcess";
+        }
+
+        // 'denk_write_int' (rcx) appends a number and a newline to one large buffer, written by 'denk_flush' when it
+        // fills up or the program exits. 'denk_read_int' returns the next number on stdin in rax, 0 at its end;
+        // stdin is read in blocks of the same size and anything but digits and '-' separates the numbers.
+        void gen_io_runtime()
+        {
+            if (m_uses_output)
+            {
+                m_output << "\ndenk_flush:\n";
+
+                if (m_freestanding)
+                {
+                    m_output << "    push rsi\n";
+                    m_output << "    push rdi\n";
+                    m_output << "    mov eax, 1\n";                 // write
+                    m_output << "    mov edi, 1\n";                 // stdout
+                    m_output << "    lea rsi, [rel denk_out_buf]\n";
+                    m_output << "    mov rdx, [rel denk_out_len]\n";
+                    m_output << "    syscall\n";
+                    m_output << "    pop rdi\n";
+                    m_output << "    pop rsi\n";
+                }
+                else
+                {
+                    m_output << "    sub rsp, 56\n";
+                    m_output << "    mov rcx, -11\n";               // STD_OUTPUT_HANDLE
+                    m_output << "    call GetStdHandle\n";
+                    m_output << "    mov rcx, rax\n";
+                    m_output << "    lea rdx, [rel denk_out_buf]\n";
+                    m_output << "    mov r8, [rel denk_out_len]\n";
+                    m_output << "    lea r9, [rsp + 40]\n";
+                    m_output << "    mov QWORD [rsp + 32], 0\n";
+                    m_output << "    call WriteFile\n";
+                    m_output << "    add rsp, 56\n";
+                }
+
+                m_output << "    mov QWORD [rel denk_out_len], 0\n";
+                m_output << "    ret\n";
+
+                m_output << "\ndenk_exit:\n";
+                m_output << "    push rcx\n";
+                m_output << "    sub rsp, 32\n";
+                m_output << "    call denk_flush\n";
+                m_output << "    mov rcx, [rsp + 32]\n";
+                m_output << "    call " << process_exit() << "\n";
+
+                // Digits are produced two at a time from the back; n / 100 is a multiply by its reciprocal
+                m_output << "\ndenk_write_int:\n";
+                m_output << "    push rdi\n";
+                m_output << "    push rsi\n";
+                m_output << "    sub rsp, 40\n";
+                m_output << "    mov rsi, rcx\n";
+                m_output << "    cmp QWORD [rel denk_out_len], " << IO_BUFFER_SIZE - MAX_INT_TEXT << "\n";
+                m_output << "    jbe .room\n";
+                m_output << "    call denk_flush\n";
+                m_output << ".room:\n";
+                m_output << "    lea r9, [rel denk_digit_pairs]\n";
+                m_output << "    lea rdi, [rsp + 39]\n";
+                m_output << "    mov BYTE [rdi], 10\n";
+                m_output << "    mov rax, rsi\n";
+                m_output << "    test rax, rax\n";
+                m_output << "    jns .digits\n";
+                m_output << "    neg rax\n";                        // unsigned from here on, which also covers the minimum
+                m_output << ".digits:\n";
+                m_output << "    cmp rax, 100\n";
+                m_output << "    jb .last\n";
+                m_output << "    mov rcx, rax\n";
+                m_output << "    shr rax, 2\n";
+                m_output << "    mov rdx, 0x28F5C28F5C28F5C3\n";
+                m_output << "    mul rdx\n";
+                m_output << "    shr rdx, 2\n";
+                m_output << "    imul r8, rdx, 100\n";
+                m_output << "    sub rcx, r8\n";
+                m_output << "    movzx r8d, WORD [r9 + rcx * 2]\n";
+                m_output << "    sub rdi, 2\n";
+                m_output << "    mov [rdi], r8w\n";
+                m_output << "    mov rax, rdx\n";
+                m_output << "    jmp .digits\n";
+                m_output << ".last:\n";
+                m_output << "    cmp rax, 10\n";
+                m_output << "    jb .one\n";
+                m_output << "    movzx r8d, WORD [r9 + rax * 2]\n";
+                m_output << "    sub rdi, 2\n";
+                m_output << "    mov [rdi], r8w\n";
+                m_output << "    jmp .sign\n";
+                m_output << ".one:\n";
+                m_output << "    add eax, 48\n";
+                m_output << "    dec rdi\n";
+                m_output << "    mov [rdi], al\n";
+                m_output << ".sign:\n";
+                m_output << "    test rsi, rsi\n";
+                m_output << "    jns .copy\n";
+                m_output << "    dec rdi\n";
+                m_output << "    mov BYTE [rdi], 45\n";             // '-'
+                m_output << ".copy:\n";
+                m_output << "    lea rcx, [rsp + 40]\n";
+                m_output << "    sub rcx, rdi\n";
+                m_output << "    mov rsi, rdi\n";
+                m_output << "    lea rdi, [rel denk_out_buf]\n";
+                m_output << "    add rdi, [rel denk_out_len]\n";
+                m_output << "    add [rel denk_out_len], rcx\n";
+                m_output << "    rep movsb\n";
+                m_output << "    add rsp, 40\n";
+                m_output << "    pop rsi\n";
+                m_output << "    pop rdi\n";
+                m_output << "    ret\n";
+
+                m_output << "\n    align 2\n";
+                m_output << "denk_digit_pairs:\n";
+
+                for (int row = 0; row < 10; row++)
+                {
+                    m_output << "    db ";
+
+                    for (int i = row * 10; i < row * 10 + 10; i++)
+                        m_output << (i == row * 10 ? "" : ", ") << 48 + i / 10 << ", " << 48 + i % 10;
+
+                    m_output << "\n";
+                }
+            }
+
+            if (m_uses_input)
+            {
+                // Next byte of stdin in rax without consuming it, -1 at the end
+                m_output << "\ndenk_in_peek:\n";
+                m_output << "    mov rax, [rel denk_in_pos]\n";
+                m_output << "    cmp rax, [rel denk_in_len]\n";
+                m_output << "    jb .byte\n";
+
+                if (m_freestanding)
+                {
+                    m_output << "    push rsi\n";
+                    m_output << "    push rdi\n";
+                    m_output << "    xor eax, eax\n";               // read
+                    m_output << "    xor edi, edi\n";               // stdin
+                    m_output << "    lea rsi, [rel denk_in_buf]\n";
+                    m_output << "    mov edx, " << IO_BUFFER_SIZE << "\n";
+                    m_output << "    syscall\n";
+                    m_output << "    pop rdi\n";
+                    m_output << "    pop rsi\n";
+                    m_output << "    test rax, rax\n";              // errors count as the end of the input
+                    m_output << "    jg .filled\n";
+                    m_output << "    xor eax, eax\n";
+                    m_output << ".filled:\n";
+                }
+                else
+                {
+                    m_output << "    sub rsp, 56\n";
+                    m_output << "    mov rcx, -10\n";               // STD_INPUT_HANDLE
+                    m_output << "    call GetStdHandle\n";
+                    m_output << "    mov rcx, rax\n";
+                    m_output << "    lea rdx, [rel denk_in_buf]\n";
+                    m_output << "    mov r8d, " << IO_BUFFER_SIZE << "\n";
+                    m_output << "    lea r9, [rsp + 40]\n";
+                    m_output << "    mov QWORD [r9], 0\n";
+                    m_output << "    mov QWORD [rsp + 32], 0\n";
+                    m_output << "    call ReadFile\n";
+                    m_output << "    mov rax, [rsp + 40]\n";
+                    m_output << "    add rsp, 56\n";
+                }
+
+                m_output << "    mov QWORD [rel denk_in_pos], 0\n";
+                m_output << "    mov [rel denk_in_len], rax\n";
+                m_output << "    test rax, rax\n";
+                m_output << "    jnz .byte\n";
+                m_output << "    mov rax, -1\n";
+                m_output << "    ret\n";
+                m_output << ".byte:\n";
+                m_output << "    mov rax, [rel denk_in_pos]\n";
+                m_output << "    lea rcx, [rel denk_in_buf]\n";
+                m_output << "    movzx eax, BYTE [rcx + rax]\n";
+                m_output << "    ret\n";
+
+                // Overflow wraps around like the arithmetic of the language
+                m_output << "\ndenk_read_int:\n";
+                m_output << "    push rdi\n";
+                m_output << "    push rsi\n";
+                m_output << "    sub rsp, 40\n";
+                m_output << ".skip:\n";
+                m_output << "    call denk_in_peek\n";
+                m_output << "    cmp rax, -1\n";
+                m_output << "    je .eof\n";
+                m_output << "    inc QWORD [rel denk_in_pos]\n";
+                m_output << "    xor edi, edi\n";
+                m_output << "    cmp eax, 45\n";                    // '-'
+                m_output << "    je .minus\n";
+                m_output << "    sub eax, 48\n";
+                m_output << "    cmp eax, 9\n";
+                m_output << "    ja .skip\n";
+                m_output << "    jmp .first\n";
+                m_output << ".minus:\n";
+                m_output << "    call denk_in_peek\n";
+                m_output << "    sub eax, 48\n";
+                m_output << "    cmp eax, 9\n";
+                m_output << "    ja .skip\n";
+                m_output << "    inc QWORD [rel denk_in_pos]\n";
+                m_output << "    mov edi, 1\n";
+                m_output << ".first:\n";
+                m_output << "    mov rsi, rax\n";
+                m_output << ".next:\n";
+                m_output << "    call denk_in_peek\n";
+                m_output << "    sub eax, 48\n";
+                m_output << "    cmp eax, 9\n";
+                m_output << "    ja .done\n";
+                m_output << "    inc QWORD [rel denk_in_pos]\n";
+                m_output << "    imul rsi, rsi, 10\n";
+                m_output << "    add rsi, rax\n";
+                m_output << "    jmp .next\n";
+                m_output << ".done:\n";
+                m_output << "    mov rax, rsi\n";
+                m_output << "    test edi, edi\n";
+                m_output << "    jz .return\n";
+                m_output << "    neg rax\n";
+                m_output << "    jmp .return\n";
+                m_output << ".eof:\n";
+                m_output << "    xor eax, eax\n";
+                m_output << ".return:\n";
+                m_output << "    add rsp, 40\n";
+                m_output << "    pop rsi\n";
+                m_output << "    pop rdi\n";
+                m_output << "    ret\n";
+            }
+        }
+
+        /* Array Generation */
+        const Var& find_array(const Token& ident)
+        {
+            const Var* var = find_var_ref(ident.value.value());
+
+            if (var == nullptr)
+            {
+                compile_error_at(ident.offset, "Fehler: Bezeichner '", ident.value.value(), "' ist nicht deklariert");
+            }
+
+            if (var->length == 0)
+            {
+                compile_error_at(ident.offset, "Fehler: Bezeichner '", ident.value.value(), "' ist kein Feld");
+            }
+
+            return *var;
+        }
+
+        // Elements are laid out upwards in memory, element 0 at the lowest address
+        static size_t elem_loc(const Var& var, size_t index)
+        {
+            return (var.mem_loc + var.length - index) * 8;
+        }
+
+        // Constant indices are checked here, so they never need a runtime check; errors point at 'ident'
+        // Only a literal index out of bounds is an error, like in the C back end. An index that is only known through the
+        // values of variables may sit on a path that is never taken, so it fails at runtime like any other index.
+        static bool index_in_bounds(const Var& var, int64_t index, const NodeExpr* index_expr, const Token& ident)
+        {
+            if (index >= 0 && static_cast<size_t>(index) < var.length)
+                return true;
+
+            if (is_literal(index_expr))
+            {
+                compile_error_at(ident.offset, "Fehler: Index ", index, " liegt außerhalb von Feld '", var.name,
+                                 "' (Länge ", var.length, ")");
+            }
+
+            return false;
+        }
+
+        // Literals and '+', '-', '*' over literals
+        static bool is_literal(const NodeExpr* expr)
+        {
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    return is_literal((*paren)->expr);
+
+                return std::holds_alternative<NodeTermIntLit*>((*term)->var);
+            }
+
+            const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var);
+
+            return bin_expr != nullptr && (*bin_expr)->op != BinOp::Div && is_literal((*bin_expr)->lhs) && is_literal((*bin_expr)->rhs);
+        }
+
+        void gen_bounds_fail()
+        {
+            m_temp << "    jmp denk_bounds_error\n";
+
+            m_uses_bounds_check = true;
+        }
+
+        void bounds_check(const std::string& reg, const Var& var, const Range& index)
+        {
+            if (index.lo >= 0 && static_cast<uint64_t>(index.hi) < var.length)
+                return;
+
+            // A single unsigned compare also rejects negative indices
+            m_temp << "    cmp " << reg << ", " << var.length << "\n";
+            m_temp << "    jae denk_bounds_error\n";
+
+            m_uses_bounds_check = true;
+        }
+
+        void gen_array_zero(const Var& var)
+        {
+            if (var.length <= 8)
+            {
+                for (size_t i = 0; i < var.length; i++)
+                    overwrite_value(elem_loc(var, i), "0");
+
+                return;
+            }
+
+            m_temp << "    lea rdi, [rbp - " << elem_loc(var, 0) << "]\n";
+            m_temp << "    mov ecx, " << var.length << "\n";
+            m_temp << "    xor eax, eax\n";
+            m_temp << "    rep stosq\n";
+        }
+
+        void gen_elem_store(const Var& var, const NodeExpr* index_expr, const NodeExpr* expr, const Token& ident)
+        {
+            if (const auto index = const_eval(index_expr))
+            {
+                const bool in_bounds = index_in_bounds(var, index.value(), index_expr, ident);
+
+                gen_value(expr);
+
+                if (in_bounds)
+                    overwrite_value(elem_loc(var, static_cast<size_t>(index.value())), "rax");
+                else
+                    gen_bounds_fail();
+
+                return;
+            }
+
+            const Range index_range = range_of(index_expr);
+
+            gen_expr(index_expr);
+            gen_value(expr);
+
+            consume_var("rcx", mem_loc());
+            bounds_check("rcx", var, index_range);
+
+            m_temp << "    mov QWORD [rbp + rcx * 8 - " << elem_loc(var, 0) << "], rax\n";
+        }
+
+        const Var* array_operand(const NodeExpr* expr)
+        {
+            if (const auto name = ident_name(expr))
+                if (const Var* var = find_var_ref(name.value()); var != nullptr && var->length > 0)
+                    return var;
+
+            return nullptr;
+        }
+
+        // One side of an element-wise operation: either a whole array or a broadcast scalar
+        struct ArrayOperand
+        {
+            const Var* array;       // nullptr for a scalar
+            const NodeExpr* expr;
+        };
+
+        void gen_array_assign(const Var& dst, const NodeExpr* expr, const Token& ident)
+        {
+            std::optional<BinOp> op;
+            ArrayOperand lhs { array_operand(expr), expr };
+            std::optional<ArrayOperand> rhs;
+
+            const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var);
+
+            if (lhs.array == nullptr && bin_expr != nullptr &&
+                (array_operand((*bin_expr)->lhs) != nullptr || array_operand((*bin_expr)->rhs) != nullptr))
+            {
+                if ((*bin_expr)->op == BinOp::Div)
+                {
+                    compile_error_at(ident.offset, "Fehler: Felder unterstützen nur '+', '-' und '*'");
+                }
+
+                op = (*bin_expr)->op;
+                lhs = { array_operand((*bin_expr)->lhs), (*bin_expr)->lhs };
+                rhs = { array_operand((*bin_expr)->rhs), (*bin_expr)->rhs };
+            }
+
+            for (const ArrayOperand* operand : { &lhs, rhs.has_value() ? &rhs.value() : nullptr })
+            {
+                if (operand != nullptr && operand->array != nullptr && operand->array->length != dst.length)
+                {
+                    compile_error_at(ident.offset, "Fehler: Feld '", operand->array->name, "' hat nicht die Länge von Feld '",
+                                     dst.name, "'");
+                }
+            }
+
+            m_uses_simd = true;
+
+            // Scalars are evaluated once up front and broadcast from r8 (lhs) and r9 (rhs); a call on the right would lose
+            // r8, so the left one waits in a slot then
+            const bool keep_lhs = lhs.array == nullptr && rhs.has_value() && rhs->array == nullptr && contains_call(rhs->expr);
+
+            for (const auto& [operand, reg] : { std::pair{ &lhs, "r8" }, std::pair{ rhs.has_value() ? &rhs.value() : nullptr, "r9" } })
+            {
+                if (operand == nullptr || operand->array != nullptr)
+                    continue;
+
+                gen_value(operand->expr);
+
+                if (keep_lhs && operand == &lhs)
+                    store_value(mem_loc(), "rax");
+                else
+                    m_temp << "    mov " << reg << ", rax\n";
+            }
+
+            if (keep_lhs)
+                consume_var("r8", mem_loc());
+
+            m_temp << "    lea rdi, [rbp - " << elem_loc(dst, 0) << "]\n";
+
+            if (lhs.array != nullptr)
+                m_temp << "    lea rsi, [rbp - " << elem_loc(*lhs.array, 0) << "]\n";
+
+            if (rhs.has_value() && rhs->array != nullptr)
+                m_temp << "    lea rdx, [rbp - " << elem_loc(*rhs->array, 0) << "]\n";
+
+            const std::string label_sse = create_label();
+            const std::string label_tail = create_label();
+
+            const bool lhs_array = lhs.array != nullptr;
+            const bool rhs_array = rhs.has_value() && rhs->array != nullptr;
+
+            m_temp << "    cmp BYTE [rel denk_avx2], 0\n";
+            m_temp << "    je " << label_sse << "\n";
+
+            // AVX2: four elements per iteration, then at most one pair with the VEX-encoded 128-bit forms
+            if (!lhs_array)
+                m_temp << "    vmovq xmm4, r8\n"
+                       << "    vpbroadcastq ymm4, xmm4\n";
+
+            if (rhs.has_value() && !rhs_array)
+                m_temp << "    vmovq xmm5, r9\n"
+                       << "    vpbroadcastq ymm5, xmm5\n";
+
+            const size_t quads = dst.length / 4;
+
+            if (quads > 0)
+                gen_vector_loop(op, lhs_array, rhs_array, true, "ymm", 32, quads);
+
+            if (dst.length % 4 >= 2)
+                gen_vector_body(op, lhs_array, rhs_array, true, "xmm", std::to_string(quads * 32));
+
+            m_temp << "    vzeroupper\n";
+            m_temp << "    jmp " << label_tail << "\n";
+
+            // SSE2: two elements per iteration
+            m_temp << label_sse << ":\n";
+
+            if (!lhs_array)
+                m_temp << "    movq xmm4, r8\n"
+                       << "    punpcklqdq xmm4, xmm4\n";
+
+            if (rhs.has_value() && !rhs_array)
+                m_temp << "    movq xmm5, r9\n"
+                       << "    punpcklqdq xmm5, xmm5\n";
+
+            if (dst.length / 2 > 0)
+                gen_vector_loop(op, lhs_array, rhs_array, false, "xmm", 16, dst.length / 2);
+
+            // Scalar tail for an odd element count, shared by both paths
+            m_temp << label_tail << ":\n";
+
+            if (dst.length % 2 == 1)
+            {
+                const size_t offset = (dst.length - 1) * 8;
+
+                if (lhs_array)
+                    m_temp << "    mov rax, QWORD [rsi + " << offset << "]\n";
+                else
+                    m_temp << "    mov rax, r8\n";
+
+                if (op.has_value())
+                {
+                    const std::string src = rhs_array ? "QWORD [rdx + " + std::to_string(offset) + "]" : "r9";
+
+                    m_temp << "    " << (op == BinOp::Add ? "add" : op == BinOp::Sub ? "sub" : "imul")
+                           << " rax, " << src << "\n";
+                }
+
+                m_temp << "    mov QWORD [rdi + " << offset << "], rax\n";
+            }
+        }
+
+        void gen_vector_loop(std::optional<BinOp> op, bool lhs_array, bool rhs_array, bool avx,
+                             const std::string& reg, size_t step, size_t count)
+        {
+            const std::string label = create_label();
+
+            m_temp << "    xor ecx, ecx\n";
+            m_temp << label << ":\n";
+
+            gen_vector_body(op, lhs_array, rhs_array, avx, reg, "rcx");
+
+            m_temp << "    add rcx, " << step << "\n";
+            m_temp << "    cmp rcx, " << step * count << "\n";
+            m_temp << "    jb " << label << "\n";
+        }
+
+        // Computes one vector of 'dst = lhs op rhs' at byte offset 'offset' (a register or a constant)
+        void gen_vector_body(std::optional<BinOp> op, bool lhs_array, bool rhs_array, bool avx,
+                             const std::string& reg, const std::string& offset)
+        {
+            const std::string v0 = reg + "0", v1 = reg + "1", v2 = reg + "2", v3 = reg + "3";
+            const std::string load = avx ? "vmovdqu" : "movdqu";
+            const std::string move = avx ? "vmovdqa" : "movdqa";
+
+            if (lhs_array)
+                m_temp << "    " << load << " " << v0 << ", [rsi + " << offset << "]\n";
+            else
+                m_temp << "    " << move << " " << v0 << ", " << reg << "4\n";
+
+            if (op.has_value())
+            {
+                std::string src = reg + "5";
+
+                if (rhs_array)
+                {
+                    m_temp << "    " << load << " " << v1 << ", [rdx + " << offset << "]\n";
+
+                    src = v1;
+                }
+
+                // Emits 'dst = a op b' in VEX three-operand form or as the SSE2 two-operand 'dst op= b' with dst == a
+                auto emit = [&](const std::string& instr, const std::string& dst, const std::string& a, const std::string& b)
+                {
+                    if (avx)
+                        m_temp << "    v" << instr << " " << dst << ", " << a << ", " << b << "\n";
+                    else
+                    {
+                        if (dst != a)
+                            m_temp << "    movdqa " << dst << ", " << a << "\n";
+
+                        m_temp << "    " << instr << " " << dst << ", " << b << "\n";
+                    }
+                };
+
+                switch (op.value())
+                {
+                    case BinOp::Add:
+                        emit("paddq", v0, v0, src);
+
+                        break;
+
+                    case BinOp::Sub:
+                        emit("psubq", v0, v0, src);
+
+                        break;
+
+                    case BinOp::Mul:
+                        // No packed 64-bit multiply before AVX-512, so combine three 32x32->64 products:
+                        // lo(a)*lo(b) + ((hi(a)*lo(b) + lo(a)*hi(b)) << 32)
+                        emit("psrlq", v2, v0, "32");
+                        emit("pmuludq", v2, v2, src);
+                        emit("psrlq", v3, src, "32");
+                        emit("pmuludq", v3, v3, v0);
+                        emit("paddq", v2, v2, v3);
+                        emit("psllq", v2, v2, "32");
+                        emit("pmuludq", v0, v0, src);
+                        emit("paddq", v0, v0, v2);
+
+                        break;
+
+                    case BinOp::Div:
+                        break;
+                }
+            }
+
+            m_temp << "    " << load << " [rdi + " << offset << "], " << v0 << "\n";
+        }
+
+        // Sets 'denk_avx2' when both the CPU and the OS support AVX2 (CPUID.1:ECX.OSXSAVE/AVX, XCR0 YMM state, CPUID.7:EBX.AVX2)
+        void gen_cpu_detect()
+        {
+            const std::string label_done = create_label();
+
+            m_output << "    push rbx\n";
+            m_output << "    mov eax, 1\n";
+            m_output << "    cpuid\n";
+            m_output << "    and ecx, 0x18000000\n";
+            m_output << "    cmp ecx, 0x18000000\n";
+            m_output << "    jne " << label_done << "\n";
+            m_output << "    xor ecx, ecx\n";
+            m_output << "    xgetbv\n";
+            m_output << "    and eax, 6\n";
+            m_output << "    cmp eax, 6\n";
+            m_output << "    jne " << label_done << "\n";
+            m_output << "    mov eax, 7\n";
+            m_output << "    xor ecx, ecx\n";
+            m_output << "    cpuid\n";
+            m_output << "    bt ebx, 5\n";
+            m_output << "    jnc " << label_done << "\n";
+            m_output << "    mov BYTE [rel denk_avx2], 1\n";
+            m_output << label_done << ":\n";
+            m_output << "    pop rbx\n";
+        }
+
+        // Touches every page of a large frame in order so that guard-page based stacks can grow. Leaves the argument
+        // registers alone, since a function probes before it stores its parameters.
+        void gen_stack_probe(std::ostream& out, size_t frame_size)
+        {
+            const std::string label = create_label();
+
+            out << "    mov rax, rsp\n";
+            out << "    mov r11d, " << frame_size / STACK_PAGE_SIZE << "\n";
+            out << label << ":\n";
+            out << "    sub rax, " << STACK_PAGE_SIZE << "\n";
+            out << "    test BYTE [rax], al\n";
+            out << "    dec r11d\n";
+            out << "    jnz " << label << "\n";
+        }
+
+        /* Function Generation */
+        // Numbers the definitions, counts their call sites and finds the recursive ones, before any code is generated
+        void collect_functions()
+        {
+            for (size_t i = 0; i < m_prog.stmts.size(); i++)
+            {
+                const auto funktion = std::get_if<NodeStmtFunktion*>(&m_prog.stmts[i]->var);
+
+                if (funktion == nullptr)
+                    continue;
+
+                const Token& ident = (*funktion)->ident;
+
+                if (!m_function_index.emplace(ident.value.value(), m_functions.size()).second)
+                {
+                    compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' ist bereits definiert");
+                }
+
+                m_functions.push_back({ .node = *funktion, .label = "denk_fn_" + std::to_string(m_functions.size()), .path = i + 1,
+                                        .size = count_nodes((*funktion)->scope->stmts) });
+            }
+
+            if (m_functions.empty())
+                return;
+
+            std::vector<std::vector<size_t>> callees(m_functions.size());
+
+            for (const NodeStmt* stmt : m_prog.stmts)
+            {
+                std::vector<const NodeTermCall*> calls;
+
+                collect_calls(stmt, calls);
+
+                const auto funktion = std::get_if<NodeStmtFunktion*>(&stmt->var);
+
+                for (const NodeTermCall* call : calls)
+                {
+                    // Unknown names are reported where the call is generated
+                    const auto it = m_function_index.find(call->ident.value.value());
+
+                    if (it == m_function_index.end())
+                        continue;
+
+                    m_functions[it->second].call_sites++;
+
+                    if (funktion != nullptr)
+                        callees[m_function_index.at((*funktion)->ident.value.value())].push_back(it->second);
+                }
+            }
+
+            for (size_t i = 0; i < m_functions.size(); i++)
+            {
+                std::vector<bool> seen(m_functions.size());
+                std::vector<size_t> pending = callees[i];
+
+                while (!pending.empty() && !m_functions[i].recursive)
+                {
+                    const size_t callee = pending.back();
+
+                    pending.pop_back();
+
+                    if (callee == i)
+                        m_functions[i].recursive = true;
+                    else if (!seen[callee])
+                    {
+                        seen[callee] = true;
+                        pending.insert(pending.end(), callees[callee].begin(), callees[callee].end());
+                    }
+                }
+            }
+        }
+
+        // The result goes to rax; like any call it clobbers rax, rcx, rdx, rsi, rdi and r8 to r11
+        void gen_call(const NodeTermCall* call)
+        {
+            const Token& ident = call->ident;
+            const auto it = m_function_index.find(ident.value.value());
+
+            if (it == m_function_index.end())
+            {
+                compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' ist nicht definiert");
+            }
+
+            const Function& fn = m_functions[it->second];
+
+            if (fn.node->params.size() != call->args.size())
+            {
+                compile_error_at(ident.offset, "Fehler: Funktion '", ident.value.value(), "' erwartet ", fn.node->params.size(),
+                                 " Argumente, nicht ", call->args.size());
+            }
+
+            if (should_inline(fn))
+                gen_inline(fn, call);
+            else
+                gen_sysv_call(it->second, call);
+        }
+
+        // Small functions are always inlined, larger ones as long as all copies together stay small, and inside a loop,
+        // where the call overhead is paid on every iteration, up to a larger size; recursive ones never
+        bool should_inline(const Function& fn) const
+        {
+            if (fn.recursive || m_inline_depth == MAX_INLINE_DEPTH)
+                return false;
+
+            return fn.size <= INLINE_ALWAYS_SIZE || fn.size * fn.call_sites <= INLINE_GROWTH_BUDGET ||
+                   (m_loop_depth > 0 && fn.size <= INLINE_HOT_SIZE);
+        }
+
+        static const NodeStmtGib* tail_return(const Function& fn)
+        {
+            const std::vector<NodeStmt*>& stmts = fn.node->scope->stmts;
+
+            if (const auto gib = stmts.empty() ? nullptr : std::get_if<NodeStmtGib*>(&stmts.back()->var))
+                return *gib;
+
+            return nullptr;
+        }
+
+        // The arguments go into hidden slots that the copy of the body knows by the parameter names. The body sees
+        // none of the caller's variables, so it starts from a name index and value numbers of its own.
+        void gen_inline(const Function& fn, const NodeTermCall* call)
+        {
+            m_temp << "    ; inline " << fn.node->ident.value.value() << "\n";
+
+            begin_scope();
+
+            const size_t first = m_vars.size();
+
+            for (const NodeExpr* arg : call->args)
+            {
+                m_vars.push_back({"", m_mem_size, const_eval(arg), 0, range_of(arg)});
+                gen_expr(arg);
+            }
+
+            std::unordered_map<std::string, size_t> var_index;
+
+            for (size_t i = 0; i < fn.node->params.size(); i++)
+            {
+                m_vars[first + i].name = fn.node->params[i].value.value();
+                var_index.emplace(m_vars[first + i].name, first + i);
+            }
+
+            std::swap(m_var_index, var_index);
+
+            auto var_numbers = std::exchange(m_var_numbers, {});
+            auto available = std::exchange(m_available, {});
+            auto profile_path = std::exchange(m_profile_stmt_path, { fn.path, 0 });
+
+            const NodeStmtGib* tail = tail_return(fn);
+            const std::string label_end = create_label();
+
+            m_returns.push_back({ label_end, tail });
+            m_inline_depth++;
+
+            gen_stmts(fn.node->scope->stmts);
+
+            m_inline_depth--;
+            m_returns.pop_back();
+
+            if (tail == nullptr)
+                m_temp << "    xor eax, eax\n";
+
+            m_temp << label_end << ":\n";
+
+            end_scope();
+
+            m_var_index = std::move(var_index);
+            m_var_numbers = std::move(var_numbers);
+            m_available = std::move(available);
+            m_profile_stmt_path = std::move(profile_path);
+
+            m_temp << "    ; /inline\n";
+        }
+
+        // System V: the first six arguments in rdi, rsi, rdx, rcx, r8 and r9, the others pushed from right to left, rsp
+        // 16-byte aligned at the call and the result in rax. Between statements rsp is always aligned.
+        void gen_sysv_call(const size_t index, const NodeTermCall* call)
+        {
+            const Function& fn = m_functions[index];
+            const size_t base = m_mem_size;
+
+            m_temp << "    ; call " << fn.node->ident.value.value() << "\n";
+
+            // No argument can change another, so the ones that are not a plain operand are evaluated into slots first
+            std::vector<Operand> operands;
+
+            for (const NodeExpr* arg : call->args)
+            {
+                if (const auto operand = fold_operand(arg))
+                    operands.push_back(operand.value());
+                else
+                {
+                    operands.push_back({ slot_text(mem_loc() + 8) });
+                    gen_expr(arg);
+                }
+            }
+
+            const size_t stack_args = operands.size() > std::size(ARG_REGS) ? operands.size() - std::size(ARG_REGS) : 0;
+            const size_t padding = stack_args % 2 * 8;
+
+            if (padding > 0)
+                m_temp << "    sub rsp, " << padding << "\n";
+
+            for (size_t i = operands.size(); i-- > std::size(ARG_REGS);)
+                m_temp << "    push " << operands[i].text << "\n";
+
+            for (size_t i = 0; i < operands.size() && i < std::size(ARG_REGS); i++)
+                m_temp << "    mov " << ARG_REGS[i] << ", " << operands[i].text << "\n";
+
+            m_temp << "    call " << fn.label << "\n";
+
+            if (stack_args > 0)
+                m_temp << "    add rsp, " << stack_args * 8 + padding << "\n";
+
+            m_mem_size = base;
+
+            if (std::ranges::find(m_calls, index) == m_calls.end())
+                m_calls.push_back(index);
+        }
+
+        // Every body is generated, so that errors in unused functions are reported too, but only the ones the program
+        // calls out of line are emitted
+        void gen_functions()
+        {
+            const size_t max_mem_size = m_max_mem_size;
+            std::vector<size_t> calls = std::exchange(m_calls, {});
+
+            for (Function& fn : m_functions)
+                gen_function(fn);
+
+            m_max_mem_size = max_mem_size;
+            m_calls = std::move(calls);
+        }
+
+        // A frame of its own, with the parameters copied into the first slots
+        void gen_function(Function& fn)
+        {
+            std::stringstream body, cold;
+
+            std::swap(m_temp, body);
+            std::swap(m_cold, cold);
+
+            m_vars.clear();
+            m_scopes.clear();
+            m_var_index.clear();
+            m_hoisted.clear();
+            m_available.clear();
+            m_var_numbers.clear();
+            m_mem_size = 0;
+            m_max_mem_size = 0;
+            m_loop_depth = 0;
+            m_profile_stmt_path = { fn.path, 0 };
+            m_profile_cycles = std::nullopt;
+
+            begin_scope();
+
+            for (size_t i = 0; i < fn.node->params.size(); i++)
+            {
+                push_var({ fn.node->params[i].value.value(), m_mem_size });
+
+                if (i < std::size(ARG_REGS))
+                    store_value(mem_loc(), ARG_REGS[i]);
+                else
+                {
+                    m_temp << "    mov rax, QWORD [rbp + " << 16 + (i - std::size(ARG_REGS)) * 8 << "]\n";
+                    store_value(mem_loc(), "rax");
+                }
+            }
+
+            const NodeStmtGib* tail = tail_return(fn);
+            const std::string label_return = create_label();
+
+            m_returns.push_back({ label_return, tail });
+
+            gen_stmts(fn.node->scope->stmts);
+
+            m_returns.pop_back();
+
+            if (tail == nullptr)
+                m_temp << "    xor eax, eax\n";
+
+            end_scope();
+
+            fn.calls = std::exchange(m_calls, {});
+
+            const size_t frame_size = align_stack(m_max_mem_size);
+
+            std::swap(m_temp, body);
+            std::swap(m_cold, cold);
+
+            std::stringstream code;
+
+            code << "\n    align 16\n";
+            code << fn.label << ":\n";
+            code << "    push rbp\n";
+            code << "    mov rbp, rsp\n";
+
+            if (frame_size > STACK_PAGE_SIZE)
+                gen_stack_probe(code, frame_size);
+
+            if (frame_size > 0)
+                code << "    sub rsp, " << frame_size << "\n";
+
+            code << body.rdbuf();
+            code << label_return << ":\n";
+            code << "    leave\n";
+            code << "    ret\n";
+            code << cold.str();
+
+            fn.code = code.str();
+        }
+
+        // The functions the program calls out of line, directly or through others, in the order of their definitions
+        std::vector<size_t> called_functions() const
+        {
+            std::vector<bool> called(m_functions.size());
+            std::vector<size_t> pending = m_calls;
+
+            while (!pending.empty())
+            {
+                const size_t index = pending.back();
+
+                pending.pop_back();
+
+                if (called[index])
+                    continue;
+
+                called[index] = true;
+                pending.insert(pending.end(), m_functions[index].calls.begin(), m_functions[index].calls.end());
+            }
+
+            std::vector<size_t> indices;
+
+            for (size_t i = 0; i < m_functions.size(); i++)
+                if (called[i])
+                    indices.push_back(i);
+
+            return indices;
+        }
+
+        /* Block Layout */
+        // Where the branches of a 'Falls' go: the first one falls through from the condition, the other one follows
+        // behind a jump or, when cold, is moved behind the code of the program or function (see 'm_cold')
+        enum class Layout
+        {
+            ThenFirst, ElseFirst, ThenCold, ElseCold
+        };
+
+        // Static prediction: a hint decides, a branch that ends the program is cold, and a comparison for equality with a
+        // constant or for a negative value is assumed false
+        Layout predict(const NodeStmtFalls* s)
+        {
+            const bool sonst = s->sonst.has_value();
+
+            if (s->hint == BranchHint::Likely)
+                return sonst ? Layout::ElseCold : Layout::ThenFirst;
+
+            if (s->hint == BranchHint::Unlikely || ends_in_exit(s->scope->stmts))
+                return Layout::ThenCold;
+
+            if (sonst && ends_in_exit({ s->sonst.value() }))
+                return Layout::ElseCold;
+
+            if (sonst && predict_cond(s->expr) == false)
+                return Layout::ElseFirst;
+
+            return Layout::ThenFirst;
+        }
+
+        std::optional<bool> predict_cond(const NodeExpr* expr)
+        {
+            const auto logic_expr = std::get_if<NodeLogicExpr*>(&strip_parens(expr)->var);
+
+            if (logic_expr == nullptr)
+                return std::nullopt;
+
+            LogicOp op = (*logic_expr)->op;
+            std::optional<int64_t> value = const_eval((*logic_expr)->rhs);
+
+            // '0 größer x' is 'x kleiner 0'
+            if (!value.has_value())
+            {
+                value = const_eval((*logic_expr)->lhs);
+                op = swap_operands(op);
+            }
+
+            if (!value.has_value())
+                return std::nullopt;
+
+            switch (op)
+            {
+                case LogicOp::Equal:
+                    return false;
+
+                case LogicOp::NotEqual:
+                    return true;
+
+                case LogicOp::Less:
+                case LogicOp::LessEqual:
+                    return value.value() == 0 ? std::optional<bool>(false) : std::nullopt;
+
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        // Whether the statements never reach their end: they end with 'Beende', or with 'Gib' if 'or_return' is set
+        static bool ends_in_exit(const std::vector<NodeStmt*>& stmts, const bool or_return = false)
+        {
+            if (stmts.empty())
+                return false;
+
+            const NodeStmt* last = stmts.back();
+
+            if (std::holds_alternative<NodeStmtBeende*>(last->var))
+                return true;
+
+            if (std::holds_alternative<NodeStmtGib*>(last->var))
+                return or_return;
+
+            if (const auto scope = std::get_if<NodeScope*>(&last->var))
+                return ends_in_exit((*scope)->stmts, or_return);
+
+            if (const auto falls = std::get_if<NodeStmtFalls*>(&last->var))
+            {
+                return (*falls)->sonst.has_value() && ends_in_exit((*falls)->scope->stmts, or_return)
+                       && ends_in_exit({ (*falls)->sonst.value() }, or_return);
+            }
+
+            return false;
+        }
+
+        void gen_falls(const NodeStmtFalls* s)
+        {
+            const Layout layout = predict(s);
+            const bool then_first = layout == Layout::ThenFirst || layout == Layout::ElseCold;
+
+            m_temp << "\n    ; Falls\n";
+
+            const std::string label_other = create_label();
+            const std::string label_end = create_label();
+
+            gen_cond_jump(s->expr, label_other, !then_first);
+
+            m_temp << "    ; /Falls\n";
+
+            // The branches are generated in source order, each into a text of its own, and only then laid out
+            std::stringstream then_code, else_code;
+
+            std::swap(m_temp, then_code);
+
+            if (m_profile_path.has_value())
+                gen_profile_count(profile_counter(s, ProfileKind::Then));
+
+            const auto numbers = save_numbers(s->scope->stmts);
+
+            gen_scope(s->scope);
+
+            // Constants known after the 'dann' branch are not known on entry to 'Sonst', values computed before the
+            // 'Falls' still are
+            forget_assigned(s->scope->stmts);
+
+            std::swap(m_temp, then_code);
+
+            if (s->sonst.has_value())
+            {
+                restore_numbers(numbers);
+
+                std::swap(m_temp, else_code);
+
+                gen_stmt(s->sonst.value());
+                forget_assigned({ s->sonst.value() });
+
+                std::swap(m_temp, else_code);
+            }
+
+            const std::vector<NodeStmt*> sonst_stmts = s->sonst.has_value() ? std::vector{ s->sonst.value() } : std::vector<NodeStmt*>{};
+
+            const std::string first = then_first ? then_code.str() : else_code.str();
+            const std::string other = then_first ? else_code.str() : then_code.str();
+            const bool first_leaves = ends_in_exit(then_first ? s->scope->stmts : sonst_stmts, true);
+            const bool other_leaves = ends_in_exit(then_first ? sonst_stmts : s->scope->stmts, true);
+
+            m_temp << first;
+
+            if (layout == Layout::ThenCold || layout == Layout::ElseCold)
+            {
+                m_temp << label_end << ":\n";
+
+                m_cold << "\n    ; cold\n" << label_other << ":\n" << other;
+
+                if (!other_leaves)
+                    m_cold << "    jmp " << label_end << "\n";
+            }
+            else if (s->sonst.has_value())
+            {
+                // Both labels are jump targets, and the first branch jumps to the join on the predicted path. Nothing
+                // falls into the second branch, so its padding never runs; only the second branch runs the join's.
+                if (!first_leaves)
+                    m_temp << "    jmp " << label_end << "\n";
+
+                m_temp << "    align 16\n" << label_other << ":\n" << other;
+
+                if (!first_leaves)
+                    m_temp << "    align 16\n";
+
+                m_temp << label_end << ":\n";
+            }
+            else
+                m_temp << label_other << ":\n";
+        }
+
+        /* Loop Generation */
+        void gen_solange(const NodeStmtSolange* s)
+        {
+            if (try_unroll(s))
+                return;
+
+            std::vector<std::string> assigned;
+
+            for (const NodeStmt* stmt : s->scope->stmts)
+                collect_assigned(stmt, assigned);
+
+            const std::optional<Counter> counter = find_counter(s, assigned);
+
+            // Nothing assigned inside the loop is known on entry to its body
+            forget_assigned(s->scope->stmts);
+
+            m_temp << "\n    ; Solange\n";
+
+            const std::string label_body = create_label();
+            const std::string label_end = create_label();
+
+            // Loop inversion: a single guard up front, then a bottom-tested body
+            gen_cond_jump(s->expr, label_end, false);
+
+            // The hoisted values live in hidden slots for the duration of the loop
+            begin_scope();
+
+            std::vector<const NodeExpr*> invariants;
+
+            collect_invariants(s->expr, assigned, invariants);
+
+            for (const NodeStmt* stmt : s->scope->stmts)
+                collect_invariants(stmt, assigned, invariants);
+
+            for (const NodeExpr* expr : invariants)
+            {
+                m_temp << "    ; hoisted\n";
+
+                const size_t slot = m_mem_size;
+
+                m_vars.push_back({"", slot});
+                gen_expr(expr);
+
+                m_hoisted.emplace(expr, slot);
+            }
+
+            m_temp << "    ; /Solange\n";
+            m_temp << "    align 16\n";
+            m_temp << label_body << ":\n";
+
+            if (m_profile_path.has_value())
+                gen_profile_count(profile_counter(s, ProfileKind::Loop));
+
+            m_loop_depth++;
+
+            if (counter.has_value())
+                find_var_ref(counter->name)->range = counter->body;
+
+            gen_scope(s->scope);
+
+            gen_cond_jump(s->expr, label_body, true);
+
+            m_loop_depth--;
+
+            m_temp << label_end << ":\n";
+
+            for (const NodeExpr* expr : invariants)
+                m_hoisted.erase(expr);
+
+            end_scope();
+
+            forget_assigned(s->scope->stmts);
+
+            if (counter.has_value())
+                find_var_ref(counter->name)->range = counter->after;
+        }
+
+        // A scalar that the loop only steps by constants in one direction, towards a bound of its condition that the loop
+        // does not change
+        struct Counter
+        {
+            std::string name;
+            Range body;     // on entry to the body, where the condition holds
+            Range after;    // behind the loop
+        };
+
+        // The counter of 'Solange (I kleiner N) dann { ... Ändere I zu I + C. ... }', with every assignment to I such a
+        // step at the top level of the body. It never passes N by more than the steps of one iteration, so it stays
+        // between its start and that bound as long as adding those steps to the bound cannot wrap around.
+        std::optional<Counter> find_counter(const NodeStmtSolange* s, const std::vector<std::string>& assigned)
+        {
+            const auto cond = std::get_if<NodeLogicExpr*>(&strip_parens(s->expr)->var);
+
+            if (cond == nullptr)
+                return std::nullopt;
+
+            for (const bool left : { true, false })
+            {
+                const auto name = ident_name(left ? (*cond)->lhs : (*cond)->rhs);
+                const NodeExpr* bound = left ? (*cond)->rhs : (*cond)->lhs;
+
+                if (!name.has_value() || !is_invariant(bound, assigned))
+                    continue;
+
+                const Var* var = find_var_ref(name.value());
+
+                if (var == nullptr || var->length > 0)
+                    continue;
+
+                // 'I kleiner N' and 'N größer I' bound I from above
+                const LogicOp op = left ? (*cond)->op : swap_operands((*cond)->op);
+
+                const std::optional<__int128> steps = counter_steps(s->scope->stmts, name.value());
+
+                if (!steps.has_value() || steps == 0)
+                    continue;
+
+                const Range start = range_of(left ? (*cond)->lhs : (*cond)->rhs);
+                const Range limit = range_of(bound);
+
+                if (steps > 0 && (op == LogicOp::Less || op == LogicOp::LessEqual))
+                {
+                    const __int128 last = __int128(limit.hi) - (op == LogicOp::Less ? 1 : 0);
+
+                    if (last < start.lo || last + steps.value() > INT64_MAX)
+                        continue;
+
+                    return Counter{ name.value(), { start.lo, static_cast<int64_t>(last) },
+                                    { start.lo, static_cast<int64_t>(std::max<__int128>(start.hi, last + steps.value())) } };
+                }
+
+                if (steps < 0 && (op == LogicOp::Greater || op == LogicOp::GreaterEqual))
+                {
+                    const __int128 last = __int128(limit.lo) + (op == LogicOp::Greater ? 1 : 0);
+
+                    if (last > start.hi || last + steps.value() < INT64_MIN)
+                        continue;
+
+                    return Counter{ name.value(), { static_cast<int64_t>(last), start.hi },
+                                    { static_cast<int64_t>(std::min<__int128>(start.lo, last + steps.value())), start.hi } };
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // The sum of the steps 'Ändere I zu I +/- literal' of one iteration, if they all have the same sign and nothing
+        // else assigns I
+        static std::optional<__int128> counter_steps(const std::vector<NodeStmt*>& stmts, const std::string& name)
+        {
+            __int128 sum = 0;
+            bool up = false;
+            bool down = false;
+
+            for (const NodeStmt* stmt : stmts)
+            {
+                const auto andere = std::get_if<NodeStmtÄndere*>(&stmt->var);
+
+                if (andere != nullptr && (*andere)->ident.value.value() == name)
+                {
+                    const auto bin_expr = std::get_if<NodeBinExpr*>(&strip_parens((*andere)->expr)->var);
+
+                    if (bin_expr == nullptr || ((*bin_expr)->op != BinOp::Add && (*bin_expr)->op != BinOp::Sub) ||
+                        ident_name((*bin_expr)->lhs) != name)
+                        return std::nullopt;
+
+                    const auto term = std::get_if<NodeTerm*>(&strip_parens((*bin_expr)->rhs)->var);
+                    const auto int_lit = term != nullptr ? std::get_if<NodeTermIntLit*>(&(*term)->var) : nullptr;
+                    const auto step = int_lit != nullptr ? const_eval_lit(*int_lit) : std::nullopt;
+
+                    if (!step.has_value())
+                        return std::nullopt;
+
+                    const __int128 signed_step = (*bin_expr)->op == BinOp::Add ? __int128(step.value()) : -__int128(step.value());
+
+                    up |= signed_step > 0;
+                    down |= signed_step < 0;
+                    sum += signed_step;
+
+                    continue;
+                }
+
+                std::vector<std::string> assigned;
+
+                collect_assigned(stmt, assigned);
+
+                if (std::ranges::find(assigned, name) != assigned.end())
+                    return std::nullopt;
+            }
+
+            if (up && down)
+                return std::nullopt;
+
+            return sum;
+        }
+
+        // Fully unrolls 'Solange (I op N) dann { ... Ändere I zu I +/- C. }' for small constant trip counts
+        bool try_unroll(const NodeStmtSolange* s)
+        {
+            const auto cond = std::get_if<NodeLogicExpr*>(&s->expr->var);
+
+            if (cond == nullptr || s->scope->stmts.empty())
+                return false;
+
+            const auto step_stmt = std::get_if<NodeStmtÄndere*>(&s->scope->stmts.back()->var);
+
+            if (step_stmt == nullptr)
+                return false;
+
+            const std::string& name = (*step_stmt)->ident.value.value();
+            const Var* var = find_var_ref(name);
+
+            if (var == nullptr)
+                return false;
+
+            std::vector<std::string> assigned;
+
+            for (const NodeStmt* stmt : s->scope->stmts)
+                collect_assigned(stmt, assigned);
+
+            if (std::ranges::count(assigned, name) != 1)
+                return false;
+
+            // The step has to be 'I + C' or 'I - C'
+            const auto step = std::get_if<NodeBinExpr*>(&(*step_stmt)->expr->var);
+
+            if (step == nullptr || ((*step)->op != BinOp::Add && (*step)->op != BinOp::Sub) ||
+                ident_name((*step)->lhs) != name || !is_invariant((*step)->rhs, assigned))
+                return false;
+
+            // The condition has to compare I against a loop-invariant bound
+            const NodeLogicExpr* logic_expr = *cond;
+            const bool ident_left = ident_name(logic_expr->lhs) == name;
+
+            if (!ident_left && ident_name(logic_expr->rhs) != name)
+                return false;
+
+            const NodeExpr* bound_expr = ident_left ? logic_expr->rhs : logic_expr->lhs;
+
+            if (!is_invariant(bound_expr, assigned))
+                return false;
+
+            const auto start = var->value;
+            const auto delta = const_eval((*step)->rhs);
+            const auto bound = const_eval(bound_expr);
+
+            if (!start.has_value() || !delta.has_value() || !bound.has_value())
+                return false;
+
+            size_t trips = 0;
+
+            for (int64_t i = start.value(); ident_left ? compare(logic_expr->op, i, bound.value())
+                                                       : compare(logic_expr->op, bound.value(), i); trips++)
+            {
+                if (trips == MAX_UNROLL_TRIPS)
+                    return false;
+
+                i = (*step)->op == BinOp::Add ? wrap_add(i, delta.value()) : wrap_sub(i, delta.value());
+            }
+
+            if (trips * count_nodes(s->scope->stmts) > MAX_UNROLL_SIZE)
+                return false;
+
+            m_temp << "\n    ; Solange (" << trips << "x entrollt)\n";
+
+            for (size_t i = 0; i < trips; i++)
+                gen_scope(s->scope);
+
+            m_temp << "    ; /Solange\n";
+
+            return true;
+        }
+
+        /* Falls Chain Lowering */
+        struct ChainArm
+        {
+            int64_t value;
+            const NodeScope* scope;
+            std::string label;
+        };
+
+        static constexpr size_t MIN_CHAIN_ARMS = 4;
+        static constexpr uint64_t MAX_JUMP_TABLE = 1024;    // entries
+        static constexpr size_t LINEAR_SEARCH_ARMS = 3;
+
+        // 'X gleich c' or 'c gleich X' with a constant 'c', as (X, c)
+        std::optional<std::pair<std::string, int64_t>> match_chain_case(const NodeExpr* expr)
+        {
+            const auto logic_expr = std::get_if<NodeLogicExpr*>(&expr->var);
+
+            if (logic_expr == nullptr || (*logic_expr)->op != LogicOp::Equal)
+                return std::nullopt;
+
+            for (const auto& [ident, constant] : { std::pair{ (*logic_expr)->lhs, (*logic_expr)->rhs }, std::pair{ (*logic_expr)->rhs, (*logic_expr)->lhs } })
+            {
+                const auto name = ident_name(ident);
+                const auto value = const_eval(constant);
+
+                if (name.has_value() && value.has_value())
+                    return std::pair{ name.value(), value.value() };
+            }
+
+            return std::nullopt;
+        }
+
+        // 'Falls (X gleich 1) ... Sonst Falls (X gleich 2) ...' over one scalar and distinct constants dispatches with a
+        // jump table when the constants are dense and with a binary search otherwise, instead of one test per arm
+        bool gen_falls_chain(const NodeStmtFalls* s)
+        {
+            // Instrumented builds keep one counter per 'Falls', so they test the arms one by one
+            if (m_profile_path.has_value())
+                return false;
+
+            const auto first = match_chain_case(s->expr);
+
+            if (!first.has_value())
+                return false;
+
+            const std::string& name = first->first;
+            const Var* var = find_var_ref(name);
+
+            if (var == nullptr || var->length > 0)
+                return false;
+
+            std::vector<ChainArm> arms = { { first->second, s->scope, "" } };
+            std::optional<NodeStmt*> fallback;
+
+            // Conditions have no side effects, so every one of them sees the values on entry to the chain
+            for (const NodeStmtFalls* arm = s; arm->sonst.has_value(); )
+            {
+                NodeStmt* next = arm->sonst.value();
+                const auto falls = std::get_if<NodeStmtFalls*>(&next->var);
+                const auto arm_case = falls != nullptr ? match_chain_case((*falls)->expr) : std::nullopt;
+
+                if (!arm_case.has_value() || arm_case->first != name)
+                {
+                    fallback = next;
+
+                    break;
+                }
+
+                arm = *falls;
+                arms.push_back({ arm_case->second, arm->scope, "" });
+            }
+
+            if (arms.size() < MIN_CHAIN_ARMS)
+                return false;
+
+            std::vector<const ChainArm*> sorted;
+
+            for (ChainArm& arm : arms)
+            {
+                arm.label = create_label();
+                sorted.push_back(&arm);
+            }
+
+            std::ranges::sort(sorted, {}, &ChainArm::value);
+
+            // A repeated constant makes its later arm unreachable, which the plain chain handles
+            if (std::ranges::adjacent_find(sorted, {}, &ChainArm::value) != sorted.end())
+                return false;
+
+            const std::string label_default = create_label();
+            const std::string label_end = create_label();
+
+            const uint64_t span = static_cast<uint64_t>(sorted.back()->value) - static_cast<uint64_t>(sorted.front()->value);
+            const bool table = span < MAX_JUMP_TABLE && span < 3 * arms.size();
+
+            m_temp << "\n    ; Falls (" << arms.size() << " Fälle über " << name << ", " << (table ? "Sprungtabelle" : "Binärsuche") << ")\n";
+
+            load_var("rax", (var->mem_loc + 1) * 8);
+
+            if (table)
+                gen_jump_table(sorted, span, label_default);
+            else
+                gen_binary_search(sorted, 0, sorted.size(), label_default);
+
+            m_temp << "    ; /Falls\n";
+
+            // Each arm may only assume what none of the arms before it changed, as in the chain it replaces
+            for (size_t i = 0; i < arms.size(); i++)
+            {
+                m_temp << arms[i].label << ":\n";
+
+                gen_scope(arms[i].scope);
+                forget_assigned(arms[i].scope->stmts);
+
+                if (i + 1 < arms.size() || fallback.has_value())
+                    m_temp << "    jmp " << label_end << "\n";
+            }
+
+            m_temp << label_default << ":\n";
+
+            if (fallback.has_value())
+            {
+                gen_stmt(fallback.value());
+                forget_assigned({ fallback.value() });
+            }
+
+            m_temp << label_end << ":\n";
+
+            return true;
+        }
+
+        // Offsets relative to the table, so it needs no relocations and works at any address
+        void gen_jump_table(const std::vector<const ChainArm*>& sorted, const uint64_t span, const std::string& label_default)
+        {
+            const std::string label_table = create_label();
+
+            const int64_t min = sorted.front()->value;
+
+            if (min != 0 && fits_imm32(min))
+                m_temp << "    sub rax, " << min << "\n";
+            else if (min != 0)
+            {
+                gen_imm("rcx", min);
+
+                m_temp << "    sub rax, rcx\n";
+            }
+
+            m_temp << "    cmp rax, " << span << "\n";
+            m_temp << "    ja " << label_default << "\n";
+            m_temp << "    lea rcx, [rel " << label_table << "]\n";
+            m_temp << "    movsxd rax, DWORD [rcx + rax * 4]\n";
+            m_temp << "    add rax, rcx\n";
+            m_temp << "    jmp rax\n";
+            m_temp << "    align 4\n";
+            m_temp << label_table << ":\n";
+
+            auto arm = sorted.begin();
+
+            for (uint64_t i = 0; i <= span; i++)
+            {
+                const bool hit = static_cast<uint64_t>((*arm)->value) - static_cast<uint64_t>(min) == i;
+
+                m_temp << "    dd " << (hit ? (*arm)->label : label_default) << " - " << label_table << "\n";
+
+                if (hit)
+                    ++arm;
+            }
+        }
+
+        // Arms [begin, end) of the sorted arms; a few compares in a row beat another level of branches
+        void gen_binary_search(const std::vector<const ChainArm*>& sorted, const size_t begin, const size_t end, const std::string& label_default)
+        {
+            if (end - begin <= LINEAR_SEARCH_ARMS)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    gen_cmp_imm("rax", sorted[i]->value);
+
+                    m_temp << "    je " << sorted[i]->label << "\n";
+                }
+
+                m_temp << "    jmp " << label_default << "\n";
+
+                return;
+            }
+
+            const size_t mid = begin + (end - begin) / 2;
+            const std::string label_lower = create_label();
+
+            gen_cmp_imm("rax", sorted[mid]->value);
+
+            m_temp << "    je " << sorted[mid]->label << "\n";
+            m_temp << "    jl " << label_lower << "\n";
+
+            gen_binary_search(sorted, mid + 1, end, label_default);
+
+            m_temp << label_lower << ":\n";
+
+            gen_binary_search(sorted, begin, mid, label_default);
+        }
+
+        // Instructions only take sign-extended 32-bit immediates, larger constants go through a register
+        static bool fits_imm32(const int64_t value)
+        {
+            return value >= INT32_MIN && value <= INT32_MAX;
+        }
+
+        void gen_imm(const std::string& reg, const int64_t value)
+        {
+            m_temp << "    mov " << reg << ", " << value << "\n";
+        }
+
+        void gen_cmp_imm(const std::string& reg, const int64_t value)
+        {
+            if (fits_imm32(value))
+            {
+                m_temp << "    cmp " << reg << ", " << value << "\n";
+
+                return;
+            }
+
+            gen_imm("rcx", value);
+
+            m_temp << "    cmp " << reg << ", rcx\n";
+        }
+
+        /* Assembly Helpers */
+        void store_value(size_t mem, const std::string& val)
+        {
+            m_temp << "    mov QWORD [rbp - " << mem + 8 << "], " << val << "\n";
+            
+            track_mem();
+        }
+
+        void overwrite_value(size_t mem, const std::string& val)
+        {
+            m_temp << "    mov QWORD [rbp - " << mem << "], " << val << "\n";
+        }
+
+        void load_var(const std::string& reg, size_t mem)
+        {
+            m_temp << "    mov " << reg << ", QWORD [rbp - " << mem << "]\n";
+        }
+
+        void consume_var(const std::string& reg, size_t mem)
+        {
+            load_var(reg, mem);
+
+            m_mem_size--;
+        }
+
+        // Imports from the Windows API; a freestanding program has none
+        void declare_extern_once(const std::string& name)
+        {
+            if (m_freestanding)
+                return;
+
+            if (std::ranges::find(m_extern, name) == m_extern.end())
+            {
+                m_output << "    extern " << name << "\n";
+
+                m_extern.push_back(name);
+            }
+        }
+
+        /* Scope Helpers */
+        void begin_scope()
+        {
+            m_scopes.push_back(m_vars.size());
+        }
+
+        void end_scope()
+        {
+            for (size_t i = m_scopes.back(); i < m_vars.size(); i++)
+            {
+                m_mem_size -= std::max<size_t>(m_vars[i].length, 1);
+                m_var_index.erase(m_vars[i].name);
+            }
+
+            m_vars.resize(m_scopes.back());
+            m_scopes.pop_back();
+
+            // Values kept in the scope's slots neither dominate what follows nor survive the slots
+            std::erase_if(m_available, [&](const auto& entry) { return entry.second >= m_mem_size; });
+        }
+
+        void push_var(Var var)
+        {
+            m_var_index.emplace(var.name, m_vars.size());
+            m_vars.push_back(std::move(var));
+        }
+
+        std::optional<Var> find_var(const std::string& name)
+        {
+            if (const Var* var = find_var_ref(name))
+                return *var;
+
+            return std::nullopt;
+        }
+
+        Var* find_var_ref(const std::string& name)
+        {
+            const auto it = m_var_index.find(name);
+
+            return it != m_var_index.end() ? &m_vars[it->second] : nullptr;
+        }
+
+        /* Value Numbering */
+        size_t value_number(const ValueKind kind, const int op, const size_t lhs, const size_t rhs)
+        {
+            const auto [it, inserted] = m_value_numbers.try_emplace({ kind, op, lhs, rhs }, m_next_value_number);
+
+            if (inserted)
+                m_next_value_number++;
+
+            return it->second;
+        }
+
+        size_t var_number(const std::string& name)
+        {
+            const auto [it, inserted] = m_var_numbers.try_emplace(name, m_next_value_number);
+
+            if (inserted)
+                m_next_value_number++;
+
+            return it->second;
+        }
+
+        size_t value_number(const NodeExpr* expr)
+        {
+            if (const auto it = m_numbered.find(expr); it != m_numbered.end())
+                return it->second;
+
+            const size_t number = number_value(expr);
+
+            m_numbered.emplace(expr, number);
+
+            return number;
+        }
+
+        size_t const_number(const int64_t value)
+        {
+            const size_t number = value_number(ValueKind::Const, 0, static_cast<size_t>(value), 0);
+
+            m_constants.emplace(number, value);
+
+            return number;
+        }
+
+        bool is_const(const NodeExpr* expr)
+        {
+            return m_constants.contains(value_number(expr));
+        }
+
+        // Folds constants on the way up, like const_eval does, so that every node is looked at once
+        size_t number_value(const NodeExpr* expr)
+        {
+            expr = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto int_lit = std::get_if<NodeTermIntLit*>(&(*term)->var))
+                {
+                    if (const auto value = const_eval_lit(*int_lit))
+                        return const_number(value.value());
+
+                    // A literal out of range, never equal to anything
+                    return m_next_value_number++;
+                }
+
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+                {
+                    if (const auto value = const_eval(expr))
+                        return const_number(value.value());
+
+                    return var_number((*ident)->ident.value.value());
+                }
+
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    return value_number(ValueKind::Index, 0, var_number((*index)->ident.value.value()), value_number((*index)->index));
+
+                // A call may read and write, so no two of them are equal
+                return m_next_value_number++;
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                size_t lhs = value_number((*bin_expr)->lhs);
+                size_t rhs = value_number((*bin_expr)->rhs);
+
+                const auto lhs_value = m_constants.find(lhs);
+                const auto rhs_value = m_constants.find(rhs);
+
+                if (lhs_value != m_constants.end() && rhs_value != m_constants.end())
+                    if (const auto value = fold((*bin_expr)->op, lhs_value->second, rhs_value->second))
+                        return const_number(value.value());
+
+                if (((*bin_expr)->op == BinOp::Add || (*bin_expr)->op == BinOp::Mul) && lhs > rhs)
+                    std::swap(lhs, rhs);
+
+                return value_number(ValueKind::Bin, static_cast<int>((*bin_expr)->op), lhs, rhs);
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            const size_t lhs = value_number(logic_expr->lhs);
+            const size_t rhs = value_number(logic_expr->rhs);
+
+            const auto lhs_value = m_constants.find(lhs);
+            const auto rhs_value = m_constants.find(rhs);
+
+            if (lhs_value != m_constants.end() && rhs_value != m_constants.end())
+                return const_number(compare(logic_expr->op, lhs_value->second, rhs_value->second) ? 1 : 0);
+
+            return value_number(ValueKind::Logic, static_cast<int>(logic_expr->op), lhs, rhs);
+        }
+
+        // Names the statement gives a new value, including the one a 'Bestimme' declares
+        void renumber_assigned(const NodeStmt* stmt)
+        {
+            std::vector<std::string> assigned;
+
+            collect_assigned(stmt, assigned);
+
+            if (const auto bestimme = std::get_if<NodeStmtBestimme*>(&stmt->var))
+                assigned.push_back((*bestimme)->ident.value.value());
+
+            for (const std::string& name : assigned)
+                m_var_numbers[name] = m_next_value_number++;
+        }
+
+        // The numbers of what 'stmts' assign, for a branch that does not run after them
+        std::vector<std::pair<std::string, std::optional<size_t>>> save_numbers(const std::vector<NodeStmt*>& stmts)
+        {
+            std::vector<std::string> assigned;
+
+            for (const NodeStmt* stmt : stmts)
+                collect_assigned(stmt, assigned);
+
+            std::vector<std::pair<std::string, std::optional<size_t>>> numbers;
+
+            for (const std::string& name : assigned)
+            {
+                const auto it = m_var_numbers.find(name);
+
+                numbers.emplace_back(name, it != m_var_numbers.end() ? std::optional<size_t>(it->second) : std::nullopt);
+            }
+
+            return numbers;
+        }
+
+        void restore_numbers(const std::vector<std::pair<std::string, std::optional<size_t>>>& numbers)
+        {
+            for (const auto& [name, number] : numbers)
+            {
+                if (number.has_value())
+                    m_var_numbers[name] = number.value();
+                else
+                    m_var_numbers.erase(name);
+            }
+        }
+
+        // Expressions a statement evaluates itself, not those of nested statements; element-wise 'Ändere' has none
+        std::vector<const NodeExpr*> own_exprs(const NodeStmt* stmt)
+        {
+            struct Visitor
+            {
+                Generator& gen;
+
+                std::vector<const NodeExpr*> operator()(const NodeScope*) const { return {}; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtBestimme* s) const
+                {
+                    return s->expr != nullptr ? std::vector<const NodeExpr*>{ s->expr } : std::vector<const NodeExpr*>{};
+                }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtÄndere* s) const
+                {
+                    if (s->index.has_value())
+                        return { s->index.value(), s->expr };
+
+                    const Var* var = gen.find_var_ref(s->ident.value.value());
+
+                    return var != nullptr && var->length > 0 ? std::vector<const NodeExpr*>{} : std::vector<const NodeExpr*>{ s->expr };
+                }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtFalls* s) const { return { s->expr }; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtSolange* s) const { return { s->expr }; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtBeende* s) const { return { s->expr }; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtSchreibe* s) const { return { s->expr }; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtLies*) const { return {}; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtFunktion*) const { return {}; }
+
+                std::vector<const NodeExpr*> operator()(const NodeStmtGib* s) const { return { s->expr }; }
+            };
+
+            return std::visit(Visitor{ *this }, stmt->var);
+        }
+
+        // Reads the maximal subexpressions whose value is available from their slots, for the duration of one statement
+        void reuse_available(const NodeExpr* expr, std::vector<const NodeExpr*>& reused)
+        {
+            if (is_const(expr))
+                return;
+
+            const NodeExpr* inner = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&inner->var))
+            {
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    reuse_available((*index)->index, reused);
+
+                if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+                    for (const NodeExpr* arg : (*call)->args)
+                        reuse_available(arg, reused);
+
+                return;
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&inner->var))
+            {
+                if (const auto it = m_available.find(value_number(inner)); it != m_available.end())
+                {
+                    if (m_hoisted.emplace(expr, it->second).second)
+                        reused.push_back(expr);
+
+                    return;
+                }
+
+                reuse_available((*bin_expr)->lhs, reused);
+                reuse_available((*bin_expr)->rhs, reused);
+
+                return;
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(inner->var);
+
+            reuse_available(logic_expr->lhs, reused);
+            reuse_available(logic_expr->rhs, reused);
+        }
+
+        // Computes the maximal subexpressions of 'stmts[at]' that the statement itself or one of the next statements
+        // computes again into a hidden slot first, as long as nothing they read is assigned in between
+        void keep_common(const NodeExpr* expr, const std::vector<NodeStmt*>& stmts, const size_t at, std::optional<Lookahead>& ahead)
+        {
+            if (std::holds_alternative<NodeStmtSolange*>(stmts[at]->var) || is_const(expr) || m_hoisted.contains(expr))
+                return;
+
+            const NodeExpr* inner = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&inner->var))
+            {
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    keep_common((*index)->index, stmts, at, ahead);
+
+                if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+                    for (const NodeExpr* arg : (*call)->args)
+                        keep_common(arg, stmts, at, ahead);
+
+                return;
+            }
+
+            if (const auto logic_expr = std::get_if<NodeLogicExpr*>(&inner->var))
+            {
+                keep_common((*logic_expr)->lhs, stmts, at, ahead);
+                keep_common((*logic_expr)->rhs, stmts, at, ahead);
+
+                return;
+            }
+
+            const size_t number = value_number(inner);
+
+            if (m_available.contains(number))
+                return;
+
+            std::vector<std::string> reads;
+
+            // Keeping costs a store and a load per use, so it only pays off for more than a load
+            if (cover(inner).cost > COST_LOAD + COST_STORE && collect_reads(inner, reads))
+            {
+                if (!ahead.has_value())
+                    ahead = look_ahead(stmts, at);
+
+                if (count_uses(ahead.value(), number, reads) >= 2)
+                {
+                    m_temp << "    ; common\n";
+
+                    const size_t slot = m_mem_size;
+
+                    m_vars.push_back({"", slot});
+                    gen_expr(expr);
+
+                    m_available.emplace(number, slot);
+
+                    return;
+                }
+            }
+
+            const NodeBinExpr* bin_expr = std::get<NodeBinExpr*>(inner->var);
+
+            keep_common(bin_expr->lhs, stmts, at, ahead);
+            keep_common(bin_expr->rhs, stmts, at, ahead);
+        }
+
+        // Names the expression reads; false if one of them is not a declared variable used the right way, which is left
+        // to the statement to report
+        bool collect_reads(const NodeExpr* expr, std::vector<std::string>& reads)
+        {
+            expr = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+                {
+                    const Var* var = find_var_ref((*ident)->ident.value.value());
+
+                    reads.push_back((*ident)->ident.value.value());
+
+                    return var != nullptr && var->length == 0;
+                }
+
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                {
+                    const Var* var = find_var_ref((*index)->ident.value.value());
+                    const auto at = const_eval((*index)->index);
+
+                    reads.push_back((*index)->ident.value.value());
+
+                    if (var == nullptr || var->length == 0 || (at.has_value() && (at.value() < 0 || static_cast<size_t>(at.value()) >= var->length)))
+                        return false;
+
+                    return collect_reads((*index)->index, reads);
+                }
+
+                return !std::holds_alternative<NodeTermCall*>((*term)->var);
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+                return collect_reads((*bin_expr)->lhs, reads) && collect_reads((*bin_expr)->rhs, reads);
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            return collect_reads(logic_expr->lhs, reads) && collect_reads(logic_expr->rhs, reads);
+        }
+
+        // The values 'stmts[at]' computes itself, then those of the statements after it up to MAX_CSE_DISTANCE
+        Lookahead look_ahead(const std::vector<NodeStmt*>& stmts, const size_t at)
+        {
+            Lookahead ahead;
+
+            for (const NodeExpr* expr : own_exprs(stmts[at]))
+                record_uses(expr, ahead);
+
+            for (size_t i = at + 1; i < stmts.size() && ahead.stmts < MAX_CSE_DISTANCE; i++)
+                scan_ahead(stmts[i], ahead);
+
+            return ahead;
+        }
+
+        void scan_ahead(const NodeStmt* stmt, Lookahead& ahead)
+        {
+            if (ahead.stmts == MAX_CSE_DISTANCE)
+                return;
+
+            ahead.stmts++;
+
+            // A loop evaluates everything in it again after what it assigns
+            if (std::holds_alternative<NodeStmtSolange*>(stmt->var))
+            {
+                auto [it, inserted] = m_loop_assigned.try_emplace(stmt);
+
+                if (inserted)
+                    collect_assigned(stmt, it->second);
+
+                for (const std::string& name : it->second)
+                    record_kill(name, ahead);
+            }
+
+            for (const NodeExpr* expr : own_exprs(stmt))
+                record_uses(expr, ahead);
+
+            if (const auto scope = std::get_if<NodeScope*>(&stmt->var))
+                for (const NodeStmt* nested : (*scope)->stmts)
+                    scan_ahead(nested, ahead);
+
+            if (const auto falls = std::get_if<NodeStmtFalls*>(&stmt->var))
+            {
+                for (const NodeStmt* nested : (*falls)->scope->stmts)
+                    scan_ahead(nested, ahead);
+
+                if ((*falls)->sonst.has_value())
+                    scan_ahead((*falls)->sonst.value(), ahead);
+            }
+
+            if (const auto solange = std::get_if<NodeStmtSolange*>(&stmt->var))
+                for (const NodeStmt* nested : (*solange)->scope->stmts)
+                    scan_ahead(nested, ahead);
+
+            if (const auto bestimme = std::get_if<NodeStmtBestimme*>(&stmt->var))
+                record_kill((*bestimme)->ident.value.value(), ahead);
+
+            if (const auto assign = std::get_if<NodeStmtÄndere*>(&stmt->var))
+                record_kill((*assign)->ident.value.value(), ahead);
+
+            if (const auto lies = std::get_if<NodeStmtLies*>(&stmt->var))
+                record_kill((*lies)->ident.value.value(), ahead);
+        }
+
+        void record_uses(const NodeExpr* expr, Lookahead& ahead)
+        {
+            if (is_const(expr))
+                return;
+
+            expr = strip_parens(expr);
+
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    record_uses((*index)->index, ahead);
+
+                if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+                    for (const NodeExpr* arg : (*call)->args)
+                        record_uses(arg, ahead);
+
+                return;
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                ahead.uses.emplace_back(value_number(expr), ahead.position);
+
+                record_uses((*bin_expr)->lhs, ahead);
+                record_uses((*bin_expr)->rhs, ahead);
+
+                return;
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            record_uses(logic_expr->lhs, ahead);
+            record_uses(logic_expr->rhs, ahead);
+        }
+
+        static void record_kill(const std::string& name, Lookahead& ahead)
+        {
+            ahead.position++;
+            ahead.kills.emplace_back(&name, ahead.position);
+        }
+
+        // Uses of value 'number' before the first assignment to one of 'reads'
+        static size_t count_uses(const Lookahead& ahead, const size_t number, const std::vector<std::string>& reads)
+        {
+            // Kills are recorded in order, so the first one that matches is the first assignment
+            const auto kill = std::ranges::find_if(ahead.kills, [&](const auto& entry) { return std::ranges::find(reads, *entry.first) != reads.end(); });
+            const size_t end = kill != ahead.kills.end() ? kill->second : SIZE_MAX;
+
+            return std::ranges::count_if(ahead.uses, [&](const auto& use) { return use.first == number && use.second < end; });
+        }
+
+        /* Analysis Helpers */
+        static void collect_assigned(const NodeStmt* stmt, std::vector<std::string>& assigned)
+        {
+            struct Visitor
+            {
+                std::vector<std::string>& assigned;
+
+                void operator()(const NodeScope* scope) const
+                {
+                    for (const NodeStmt* stmt : scope->stmts)
+                        collect_assigned(stmt, assigned);
+                }
+
+                void operator()(const NodeStmtBestimme*) const {}
+
+                void operator()(const NodeStmtÄndere* s) const { assigned.push_back(s->ident.value.value()); }
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    (*this)(s->scope);
+
+                    if (s->sonst.has_value())
+                        collect_assigned(s->sonst.value(), assigned);
+                }
+
+                void operator()(const NodeStmtSolange* s) const { (*this)(s->scope); }
+
+                void operator()(const NodeStmtBeende*) const {}
+
+                void operator()(const NodeStmtSchreibe*) const {}
+
+                void operator()(const NodeStmtLies* s) const { assigned.push_back(s->ident.value.value()); }
+
+                // A function only assigns its own variables
+                void operator()(const NodeStmtFunktion*) const {}
+
+                void operator()(const NodeStmtGib*) const {}
+            };
+
+            std::visit(Visitor{ assigned }, stmt->var);
+        }
+
+        static void collect_io(const NodeStmt* stmt, bool& output, bool& input)
+        {
+            struct Visitor
+            {
+                bool& output;
+                bool& input;
+
+                void operator()(const NodeScope* scope) const
+                {
+                    for (const NodeStmt* stmt : scope->stmts)
+                        collect_io(stmt, output, input);
+                }
+
+                void operator()(const NodeStmtBestimme*) const {}
+
+                void operator()(const NodeStmtÄndere*) const {}
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    (*this)(s->scope);
+
+                    if (s->sonst.has_value())
+                        collect_io(s->sonst.value(), output, input);
+                }
+
+                void operator()(const NodeStmtSolange* s) const { (*this)(s->scope); }
+
+                void operator()(const NodeStmtBeende*) const {}
+
+                void operator()(const NodeStmtSchreibe*) const { output = true; }
+
+                void operator()(const NodeStmtLies*) const { input = true; }
+
+                void operator()(const NodeStmtFunktion* s) const { (*this)(s->scope); }
+
+                void operator()(const NodeStmtGib*) const {}
+            };
+
+            std::visit(Visitor{ output, input }, stmt->var);
+        }
+
+        // Every call in the statement, including the ones in the body of a definition
+        static void collect_calls(const NodeExpr* expr, std::vector<const NodeTermCall*>& calls)
+        {
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    collect_calls((*index)->index, calls);
+
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    collect_calls((*paren)->expr, calls);
+
+                if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+                {
+                    calls.push_back(*call);
+
+                    for (const NodeExpr* arg : (*call)->args)
+                        collect_calls(arg, calls);
+                }
+
+                return;
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                collect_calls((*bin_expr)->lhs, calls);
+                collect_calls((*bin_expr)->rhs, calls);
+
+                return;
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            collect_calls(logic_expr->lhs, calls);
+            collect_calls(logic_expr->rhs, calls);
+        }
+
+        static void collect_calls(const NodeStmt* stmt, std::vector<const NodeTermCall*>& calls)
+        {
+            struct Visitor
+            {
+                std::vector<const NodeTermCall*>& calls;
+
+                void operator()(const NodeScope* scope) const
+                {
+                    for (const NodeStmt* stmt : scope->stmts)
+                        collect_calls(stmt, calls);
+                }
+
+                void operator()(const NodeStmtBestimme* s) const
+                {
+                    if (s->expr != nullptr)
+                        collect_calls(s->expr, calls);
+                }
+
+                void operator()(const NodeStmtÄndere* s) const
+                {
+                    if (s->index.has_value())
+                        collect_calls(s->index.value(), calls);
+
+                    collect_calls(s->expr, calls);
+                }
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    collect_calls(s->expr, calls);
+
+                    (*this)(s->scope);
+
+                    if (s->sonst.has_value())
+                        collect_calls(s->sonst.value(), calls);
+                }
+
+                void operator()(const NodeStmtSolange* s) const
+                {
+                    collect_calls(s->expr, calls);
+
+                    (*this)(s->scope);
+                }
+
+                void operator()(const NodeStmtBeende* s) const { collect_calls(s->expr, calls); }
+
+                void operator()(const NodeStmtSchreibe* s) const { collect_calls(s->expr, calls); }
+
+                void operator()(const NodeStmtLies*) const {}
+
+                void operator()(const NodeStmtFunktion* s) const { (*this)(s->scope); }
+
+                void operator()(const NodeStmtGib* s) const { collect_calls(s->expr, calls); }
+            };
+
+            std::visit(Visitor{ calls }, stmt->var);
+        }
+
+        static bool contains_call(const NodeExpr* expr)
+        {
+            std::vector<const NodeTermCall*> calls;
 
-            return m_output.str();
+            collect_calls(expr, calls);
+
+            return !calls.empty();
         }
-    
-    private:
-        /* Internal State */
-        struct Var
+
+        void forget_assigned(const std::vector<NodeStmt*>& stmts)
         {
-            std::string name;
-            size_t mem_loc;
-        };
+            std::vector<std::string> assigned;
 
-        const NodeProg m_prog;
-        std::stringstream m_temp, m_output;
-        std::vector<std::string> m_extern;
+            for (const NodeStmt* stmt : stmts)
+                collect_assigned(stmt, assigned);
 
-        std::vector<Var> m_vars;
-        std::vector<size_t> m_scopes;
+            for (const std::string& name : assigned)
+            {
+                if (Var* var = find_var_ref(name))
+                {
+                    var->value = std::nullopt;
+                    var->range = {};
+                }
+            }
+        }
 
-        size_t m_mem_size = 0;
-        size_t m_stack_size = 0;
-        size_t m_max_mem_size = 0;
-        size_t m_max_stack_size = 0;
+        static std::optional<std::string> ident_name(const NodeExpr* expr)
+        {
+            const auto term = std::get_if<NodeTerm*>(&expr->var);
 
-        size_t m_label_count = 0;
+            if (term == nullptr)
+                return std::nullopt;
 
-        /* Expression Generation */
-        void gen_expr(const NodeExpr* expr)
+            if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+                return (*ident)->ident.value.value();
+
+            if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                return ident_name((*paren)->expr);
+
+            return std::nullopt;
+        }
+
+        // True if every variable the expression reads is declared outside of and not assigned inside the loop
+        bool is_invariant(const NodeExpr* expr, const std::vector<std::string>& assigned)
         {
-            struct Visitor
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
             {
-                Generator& gen;
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
+                {
+                    const std::string& name = (*ident)->ident.value.value();
 
-                void operator()(const NodeTerm* term) const { gen.gen_term(term); }
+                    return find_var_ref(name) != nullptr && std::ranges::find(assigned, name) == assigned.end();
+                }
+
+                // An index that may be out of bounds traps, so like a division it is only hoisted when it is safe:
+                // the access may sit behind a condition that guards it
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                {
+                    const std::string& name = (*index)->ident.value.value();
+                    const Var* var = find_var_ref(name);
 
-                void operator()(const NodeBinExpr* bin_expr) const { gen.gen_bin_expr(bin_expr); }
+                    if (var == nullptr || std::ranges::find(assigned, name) != assigned.end())
+                        return false;
 
-                void operator()(NodeLogicExpr* logic_expr) const { gen.gen_logic_expr(logic_expr); }
-            };
+                    const Range range = range_of((*index)->index);
+
+                    return range.lo >= 0 && static_cast<uint64_t>(range.hi) < var->length && is_invariant((*index)->index, assigned);
+                }
+
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    return is_invariant((*paren)->expr, assigned);
+
+                // A call may write or read input, so it runs as often as the loop says
+                return !std::holds_alternative<NodeTermCall*>((*term)->var);
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                // A division may trap, so only hoist it when the divisor is a safe constant
+                if ((*bin_expr)->op == BinOp::Div)
+                {
+                    const auto divisor = const_eval((*bin_expr)->rhs);
+
+                    if (!divisor.has_value() || divisor.value() == 0 || divisor.value() == -1)
+                        return false;
+                }
+
+                return is_invariant((*bin_expr)->lhs, assigned) && is_invariant((*bin_expr)->rhs, assigned);
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            return is_invariant(logic_expr->lhs, assigned) && is_invariant(logic_expr->rhs, assigned);
+        }
+
+        // Collects the maximal loop-invariant binary expressions that are worth hoisting
+        void collect_invariants(const NodeExpr* expr, const std::vector<std::string>& assigned,
+                                std::vector<const NodeExpr*>& invariants)
+        {
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    collect_invariants((*paren)->expr, assigned, invariants);
+
+                if (const auto index = std::get_if<NodeTermIndex*>(&(*term)->var))
+                    collect_invariants((*index)->index, assigned, invariants);
+
+                if (const auto call = std::get_if<NodeTermCall*>(&(*term)->var))
+                    for (const NodeExpr* arg : (*call)->args)
+                        collect_invariants(arg, assigned, invariants);
+
+                return;
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                if (is_invariant(expr, assigned))
+                {
+                    if (!m_hoisted.contains(expr) && std::ranges::find(invariants, expr) == invariants.end())
+                        invariants.push_back(expr);
+
+                    return;
+                }
+
+                collect_invariants((*bin_expr)->lhs, assigned, invariants);
+                collect_invariants((*bin_expr)->rhs, assigned, invariants);
 
-            std::visit(Visitor{ *this }, expr->var);
+                return;
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            collect_invariants(logic_expr->lhs, assigned, invariants);
+            collect_invariants(logic_expr->rhs, assigned, invariants);
         }
 
-        void gen_term(const NodeTerm* term)
+        void collect_invariants(const NodeStmt* stmt, const std::vector<std::string>& assigned,
+                                std::vector<const NodeExpr*>& invariants)
         {
             struct Visitor
             {
                 Generator& gen;
+                const std::vector<std::string>& assigned;
+                std::vector<const NodeExpr*>& invariants;
 
-                void operator()(const NodeTermIntLit* t) const
+                void operator()(const NodeScope* scope) const
                 {
-                    gen.store_value(gen.mem_loc(), t->int_lit.value.value());
+                    for (const NodeStmt* stmt : scope->stmts)
+                        gen.collect_invariants(stmt, assigned, invariants);
                 }
 
-                void operator()(const NodeTermIdent* t) const
+                void operator()(const NodeStmtBestimme* s) const
                 {
-                    auto it = 
-                        std::ranges::find_if(
-                            gen.m_vars, 
-                            [&](const Var& var)
-                            {
-                                return var.name == t->ident.value.value();
-                            }
-                        );
-                    
-                    if (it == gen.m_vars.cend())
-                    {
-                        std::cerr << "Fehler: Bezeichner '" << t->ident.value.value() << "' ist nicht deklariert" << std::endl;
+                    if (s->expr != nullptr)
+                        gen.collect_invariants(s->expr, assigned, invariants);
+                }
 
-                        exit(EXIT_FAILURE);
-                    }
+                void operator()(const NodeStmtÄndere* s) const
+                {
+                    if (s->index.has_value())
+                        gen.collect_invariants(s->index.value(), assigned, invariants);
+
+                    gen.collect_invariants(s->expr, assigned, invariants);
+                }
+
+                void operator()(const NodeStmtFalls* s) const
+                {
+                    gen.collect_invariants(s->expr, assigned, invariants);
 
-                    gen.load_var("rax", (it->mem_loc + 1) * 8);
-                    gen.store_value(gen.mem_loc(), "rax");
+                    (*this)(s->scope);
+
+                    if (s->sonst.has_value())
+                        gen.collect_invariants(s->sonst.value(), assigned, invariants);
                 }
 
-                void operator()(const NodeTermParen* t) const
+                void operator()(const NodeStmtSolange* s) const
                 {
-                    gen.gen_expr(t->expr);
+                    gen.collect_invariants(s->expr, assigned, invariants);
+
+                    (*this)(s->scope);
                 }
+
+                void operator()(const NodeStmtBeende* s) const { gen.collect_invariants(s->expr, assigned, invariants); }
+
+                void operator()(const NodeStmtSchreibe* s) const { gen.collect_invariants(s->expr, assigned, invariants); }
+
+                void operator()(const NodeStmtLies*) const {}
+
+                void operator()(const NodeStmtFunktion*) const {}
+
+                void operator()(const NodeStmtGib* s) const { gen.collect_invariants(s->expr, assigned, invariants); }
             };
 
-            std::visit(Visitor{ *this }, term->var);
+            std::visit(Visitor{ *this, assigned, invariants }, stmt->var);
         }
 
-        void gen_bin_expr(const NodeBinExpr* bin_expr)
+        /* Constant Evaluation */
+        std::optional<int64_t> const_eval(const NodeExpr* expr)
         {
-            auto& gen = *this;
-        
-            auto binary_op = [&](const NodeExpr* lhs, const NodeExpr* rhs, const std::string& instr)
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
             {
-                gen.m_temp << "\n    ; " << instr << "\n";
-                
-                gen.gen_expr(rhs);
-                gen.gen_expr(lhs);
-            
-                gen.consume_var("rax", gen.mem_loc());
-            
-                if (instr == "div")
-                {
-                    gen.m_temp << "    cqo\n";
-                    gen.m_temp << "    idiv QWORD [rbp - " << gen.mem_loc() << "]\n";
-                }
-                else
+                if (const auto int_lit = std::get_if<NodeTermIntLit*>(&(*term)->var))
+                    return const_eval_lit(*int_lit);
+
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
                 {
-                    gen.m_temp << "    " << instr << " rax, QWORD [rbp - " << gen.mem_loc() << "]\n";
+                    const Var* var = find_var_ref((*ident)->ident.value.value());
+
+                    return var != nullptr ? var->value : std::nullopt;
                 }
-            
-                gen.overwrite_value(gen.mem_loc(), "rax");
 
-                gen.m_temp << "    ; /" << instr << "\n";
-            };
-        
-            switch (bin_expr->op)
+                if (std::holds_alternative<NodeTermIndex*>((*term)->var) || std::holds_alternative<NodeTermCall*>((*term)->var))
+                    return std::nullopt;
+
+                return const_eval(std::get<NodeTermParen*>((*term)->var)->expr);
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
             {
-                case BinOp::Add:
-                    binary_op(bin_expr->lhs, bin_expr->rhs, "add");
+                const auto lhs = const_eval((*bin_expr)->lhs);
+                const auto rhs = const_eval((*bin_expr)->rhs);
 
-                    break;
+                if (!lhs.has_value() || !rhs.has_value())
+                    return std::nullopt;
+
+                return fold((*bin_expr)->op, lhs.value(), rhs.value());
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            const auto lhs = const_eval(logic_expr->lhs);
+            const auto rhs = const_eval(logic_expr->rhs);
+
+            // The ranges of the operands may decide a comparison too, as long as nothing in it has to run
+            if (!lhs.has_value() || !rhs.has_value())
+            {
+                if (may_trap(expr))
+                    return std::nullopt;
+
+                const auto result = compare_ranges(logic_expr->op, range_of(logic_expr->lhs), range_of(logic_expr->rhs));
+
+                return result.has_value() ? std::optional<int64_t>(result.value() ? 1 : 0) : std::nullopt;
+            }
+
+            return compare(logic_expr->op, lhs.value(), rhs.value()) ? 1 : 0;
+        }
+
+        // The value of a binary operation on two constants, if it does not trap
+        static std::optional<int64_t> fold(BinOp op, int64_t lhs, int64_t rhs)
+        {
+            switch (op)
+            {
+                case BinOp::Add:
+                    return wrap_add(lhs, rhs);
 
                 case BinOp::Sub:
-                    binary_op(bin_expr->lhs, bin_expr->rhs, "sub");
-                    
-                    break;
+                    return wrap_sub(lhs, rhs);
 
                 case BinOp::Mul:
-                    binary_op(bin_expr->lhs, bin_expr->rhs, "imul");
-                    
-                    break;
+                    return wrap_mul(lhs, rhs);
 
                 case BinOp::Div:
-                    binary_op(bin_expr->lhs, bin_expr->rhs, "div");
-                    
-                    break;
+                    // Leave anything that traps at runtime to the runtime
+                    if (rhs == 0 || (lhs == INT64_MIN && rhs == -1))
+                        return std::nullopt;
 
-                default:
-                    // Handle error or unsupported operation
-                    break;
+                    return lhs / rhs;
             }
+
+            return std::nullopt;
         }
 
-        void gen_logic_expr(const NodeLogicExpr* logic_expr)
+        static std::optional<int64_t> const_eval_lit(const NodeTermIntLit* int_lit)
         {
-            (void) logic_expr;
+            const std::string& text = int_lit->int_lit.value.value();
+
+            int64_t value = 0;
+
+            if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{})
+                return std::nullopt;
 
-            // TODO
+            return value;
         }
-        
-        /* Statement Generation */
-        void gen_stmt(const NodeStmt* stmt)
+
+        // Two's complement arithmetic, matching what the generated code computes
+        static int64_t wrap_add(int64_t a, int64_t b)
         {
-            struct Visitor
-            {
-                Generator& gen;
+            return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+        }
 
-                void operator()(const NodeScope* scope) const
+        static int64_t wrap_sub(int64_t a, int64_t b)
+        {
+            return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+        }
+
+        static int64_t wrap_mul(int64_t a, int64_t b)
+        {
+            return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+        }
+
+        /* Value Ranges */
+        // Bounds of an expression from its constants and the ranges of its variables; elements of a 'Feld' and the
+        // results of calls are not tracked
+        Range range_of(const NodeExpr* expr)
+        {
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto int_lit = std::get_if<NodeTermIntLit*>(&(*term)->var))
                 {
-                    gen.gen_scope(scope);
+                    if (const auto value = const_eval_lit(*int_lit))
+                        return { value.value(), value.value() };
+
+                    return {};
                 }
 
-                void operator()(const NodeStmtBestimme* s) const
+                if (const auto ident = std::get_if<NodeTermIdent*>(&(*term)->var))
                 {
-                    if (gen.find_var(s->ident.value.value()))
-                    {
-                        std::cerr << "Fehler: Bezeichner '" << s->ident.value.value() << "' wird bereits verwendet" << std::endl;
-                        
-                        exit(EXIT_FAILURE);
-                    }
+                    const Var* var = find_var_ref((*ident)->ident.value.value());
 
-                    gen.m_temp << "\n    ; Bestimme\n";
-                    
-                    gen.m_vars.push_back({s->ident.value.value(), gen.m_mem_size});
-                    gen.gen_expr(s->expr);
+                    if (var == nullptr || var->length > 0)
+                        return {};
 
-                    gen.m_temp << "    ; /Bestimme\n";
+                    return var->value.has_value() ? Range{ var->value.value(), var->value.value() } : var->range;
                 }
 
-                void operator()(const NodeStmtÄndere* s) const
-                {
-                    (void) s;
-                    
-                    // TODO
-                }
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    return range_of((*paren)->expr);
 
-                void operator()(const NodeStmtFalls* s) const
-                {
-                    gen.m_temp << "\n    ; Falls";
+                return {};
+            }
 
-                    gen.gen_expr(s->expr);
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+                return range_bin((*bin_expr)->op, range_of((*bin_expr)->lhs), range_of((*bin_expr)->rhs));
 
-                    gen.m_temp << "\n";
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
 
-                    gen.consume_var("rax", gen.mem_loc());
-                    
-                    const std::string label = gen.create_label();
+            if (const auto result = compare_ranges(logic_expr->op, range_of(logic_expr->lhs), range_of(logic_expr->rhs)))
+                return { result.value(), result.value() };
 
-                    gen.m_temp << "    test rax, rax\n";
-                    gen.m_temp << "    jnz " << label << "\n"
-                               << "    ; /Falls\n";
-                    
-                    gen.gen_scope(s->scope);
+            return { 0, 1 };
+        }
+
+        // An operation that may wrap around gives every value
+        static Range range_bin(const BinOp op, const Range& a, const Range& b)
+        {
+            using Wide = __int128;
+
+            switch (op)
+            {
+                case BinOp::Add:
+                    return fit_range(Wide(a.lo) + b.lo, Wide(a.hi) + b.hi);
+
+                case BinOp::Sub:
+                    return fit_range(Wide(a.lo) - b.hi, Wide(a.hi) - b.lo);
 
-                    gen.m_temp << "\n";
+                case BinOp::Mul:
+                {
+                    const Wide products[] = { Wide(a.lo) * b.lo, Wide(a.lo) * b.hi, Wide(a.hi) * b.lo, Wide(a.hi) * b.hi };
 
-                    gen.m_temp << label << ":";
+                    return fit_range(*std::ranges::min_element(products), *std::ranges::max_element(products));
                 }
 
-                void operator()(const NodeStmtBeende* s) const
+                case BinOp::Div:
                 {
-                    gen.declare_extern_once("ExitProcess");
+                    // While the divisor keeps its sign, a truncating division is monotonic in both operands, so the
+                    // bounds are among the quotients of the corners. A divisor of 0 traps and has no quotient.
+                    Wide lo = INT64_MAX;
+                    Wide hi = INT64_MIN;
+                    bool any = false;
 
-                    gen.m_temp << "\n    ; ExitProcess\n";
+                    for (const auto& [d_lo, d_hi] : { std::pair{ b.lo, std::min<int64_t>(b.hi, -1) }, std::pair{ std::max<int64_t>(b.lo, 1), b.hi } })
+                    {
+                        if (d_lo > d_hi)
+                            continue;
+
+                        for (const Wide n : { Wide(a.lo), Wide(a.hi) })
+                        {
+                            for (const Wide d : { Wide(d_lo), Wide(d_hi) })
+                            {
+                                lo = std::min(lo, n / d);
+                                hi = std::max(hi, n / d);
+                            }
+                        }
 
-                    gen.gen_expr(s->expr);
-                    gen.consume_var("rcx", gen.mem_loc());
+                        any = true;
+                    }
 
-                    gen.m_temp << "    call ExitProcess\n"
-                               << "    ; /ExitProcess\n";
+                    return any ? fit_range(lo, hi) : Range{};
                 }
-            };
-            
-            std::visit(Visitor{ *this }, stmt->var);
+            }
+
+            return {};
         }
 
-        void gen_scope(const NodeScope* scope)
+        static Range fit_range(const __int128 lo, const __int128 hi)
         {
-            begin_scope();
+            if (lo < INT64_MIN || hi > INT64_MAX)
+                return {};
 
-            for (const NodeStmt* stmt : scope->stmts)
-                gen_stmt(stmt);
-
-            end_scope();
+            return { static_cast<int64_t>(lo), static_cast<int64_t>(hi) };
         }
 
-        /* Assembly Helpers */
-        void store_value(size_t mem, const std::string& val)
+        // The result of 'a op b' if it is the same for every pair of values in the ranges
+        static std::optional<bool> compare_ranges(const LogicOp op, const Range& a, const Range& b)
         {
-            m_temp << "    mov QWORD [rbp - " << mem + 8 << "], " << val << "\n";
-            
-            track_mem();
-        }
+            const bool single = a.lo == a.hi && b.lo == b.hi;
 
-        void overwrite_value(size_t mem, const std::string& val)
-        {
-            m_temp << "    mov QWORD [rbp - " << mem << "], " << val << "\n";
+            switch (op)
+            {
+                case LogicOp::Equal:
+                case LogicOp::NotEqual:
+                    if (single || a.hi < b.lo || b.hi < a.lo)
+                        return (single && a.lo == b.lo) == (op == LogicOp::Equal);
+
+                    return std::nullopt;
+
+                case LogicOp::Less:
+                    return a.hi < b.lo ? std::optional(true) : a.lo >= b.hi ? std::optional(false) : std::nullopt;
+
+                case LogicOp::LessEqual:
+                    return a.hi <= b.lo ? std::optional(true) : a.lo > b.hi ? std::optional(false) : std::nullopt;
+
+                case LogicOp::Greater:
+                    return compare_ranges(LogicOp::Less, b, a);
+
+                case LogicOp::GreaterEqual:
+                    return compare_ranges(LogicOp::LessEqual, b, a);
+            }
+
+            return std::nullopt;
         }
 
-        void load_var(const std::string& reg, size_t mem)
+        // Whether evaluating the expression could do more than produce its value: call a function, check an index or
+        // divide by 0 or -1
+        bool may_trap(const NodeExpr* expr)
         {
-            m_temp << "    mov " << reg << ", QWORD [rbp - " << mem << "]\n";
+            if (const auto term = std::get_if<NodeTerm*>(&expr->var))
+            {
+                if (const auto paren = std::get_if<NodeTermParen*>(&(*term)->var))
+                    return may_trap((*paren)->expr);
+
+                return std::holds_alternative<NodeTermIndex*>((*term)->var) || std::holds_alternative<NodeTermCall*>((*term)->var);
+            }
+
+            if (const auto bin_expr = std::get_if<NodeBinExpr*>(&expr->var))
+            {
+                if ((*bin_expr)->op == BinOp::Div)
+                {
+                    const Range divisor = range_of((*bin_expr)->rhs);
+
+                    if (divisor.lo <= 0 && divisor.hi >= -1)
+                        return true;
+                }
+
+                return may_trap((*bin_expr)->lhs) || may_trap((*bin_expr)->rhs);
+            }
+
+            const auto logic_expr = std::get<NodeLogicExpr*>(expr->var);
+
+            return may_trap(logic_expr->lhs) || may_trap(logic_expr->rhs);
         }
 
-        void consume_var(const std::string& reg, size_t mem)
+        static bool compare(LogicOp op, int64_t a, int64_t b)
         {
-            load_var(reg, mem);
+            switch (op)
+            {
+                case LogicOp::NotEqual:     return a != b;
+                case LogicOp::Equal:        return a == b;
+                case LogicOp::Less:         return a < b;
+                case LogicOp::LessEqual:    return a <= b;
+                case LogicOp::Greater:      return a > b;
+                case LogicOp::GreaterEqual: return a >= b;
+            }
 
-            m_mem_size--;
+            return false;
         }
 
-        void declare_extern_once(const std::string& name)
+        // 'b op a' as 'a op' b'
+        static LogicOp swap_operands(LogicOp op)
         {
-            if (std::ranges::find(m_extern, name) == m_extern.end())
+            switch (op)
             {
-                m_output << "    extern " << name << "\n";
-
-                m_extern.push_back(name);
+                case LogicOp::Less:         return LogicOp::Greater;
+                case LogicOp::LessEqual:    return LogicOp::GreaterEqual;
+                case LogicOp::Greater:      return LogicOp::Less;
+                case LogicOp::GreaterEqual: return LogicOp::LessEqual;
+                default:                    return op;
             }
         }
 
-        /* Scope Helpers */
-        void begin_scope()
+        static LogicOp negate(LogicOp op)
         {
-            m_scopes.push_back(m_vars.size());
+            switch (op)
+            {
+                case LogicOp::NotEqual:     return LogicOp::Equal;
+                case LogicOp::Equal:        return LogicOp::NotEqual;
+                case LogicOp::Less:         return LogicOp::GreaterEqual;
+                case LogicOp::LessEqual:    return LogicOp::Greater;
+                case LogicOp::Greater:      return LogicOp::LessEqual;
+                case LogicOp::GreaterEqual: return LogicOp::Less;
+            }
+
+            return op;
         }
 
-        void end_scope()
+        static const char* set_cc(LogicOp op)
         {
-            const size_t pop_count = m_vars.size() - m_scopes.back();
-
-            m_mem_size -= pop_count;
+            switch (op)
+            {
+                case LogicOp::NotEqual:     return "setne";
+                case LogicOp::Equal:        return "sete";
+                case LogicOp::Less:         return "setl";
+                case LogicOp::LessEqual:    return "setle";
+                case LogicOp::Greater:      return "setg";
+                case LogicOp::GreaterEqual: return "setge";
+            }
 
-            m_vars.resize(m_scopes.back());
-            m_scopes.pop_back();
+            return "sete";
         }
 
-        std::optional<Var> find_var(const std::string& name)
+        static const char* jump_cc(LogicOp op)
         {
-            for (const auto& v : m_vars)
-                if (v.name == name)
-                    return v;
+            switch (op)
+            {
+                case LogicOp::NotEqual:     return "jne";
+                case LogicOp::Equal:        return "je";
+                case LogicOp::Less:         return "jl";
+                case LogicOp::LessEqual:    return "jle";
+                case LogicOp::Greater:      return "jg";
+                case LogicOp::GreaterEqual: return "jge";
+            }
 
-            return std::nullopt;
+            return "je";
         }
 
         size_t mem_loc()
@@ -334,9 +4537,9 @@ class Generator
             return m_mem_size * 8;
         }
 
-        void track_mem()
+        void track_mem(size_t count = 1)
         {
-            m_mem_size++;
+            m_mem_size += count;
 
             m_max_mem_size = std::max(m_max_mem_size, m_mem_size);
         }
@@ -348,6 +4551,6 @@ class Generator
 
         std::string create_label()
         {
-            return ".L" + std::to_string(m_label_count++);
+            return m_label_prefix + std::to_string(m_label_count++);
         }
 };
\ No newline at end of file
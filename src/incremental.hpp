@@ -0,0 +1,416 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "ast_file.hpp"
+#include "c_generator.hpp"
+#include "compiler.hpp"
+#include "diagnostics.hpp"
+#include "generator.hpp"
+#include "parallel_tokenizer.hpp"
+#include "parser.hpp"
+#include "stats.hpp"
+#include "tokenizer.hpp"
+
+/*
+ * Compiler for '--watch' that keeps the source, its tokens and the AST of every top-level statement between compilations.
+ *
+ * An edit is the byte range between the common prefix and suffix of the old and the new source. Lexing restarts at the
+ * top-level statement around it and stops at the first unchanged statement it reaches between two tokens, because the
+ * rest lexes as before. Only the statements in between are parsed again, all others keep their AST.
+ */
+class IncrementalCompiler
+{
+    public:
+        explicit IncrementalCompiler(const size_t arena_size = 1024 * 1024 * 4)  // first chunk of 4 MB, the arena grows with the program
+            : m_allocator(arena_size)
+        {
+        }
+
+        // Like 'Compiler::compile', but without 'CompileOptions::assemble'; a failed compilation keeps the last good state
+        CompileResult compile(std::string_view source, const CompileOptions& options = {}, [[maybe_unused]] std::string_view name = {})
+        {
+            CompileResult result;
+
+            m_reparsed = 0;
+
+            try
+            {
+                try
+                {
+                    update(source, options, name);
+                }
+                catch (const std::bad_alloc&)
+                {
+                    // The arena is full of replaced statements, so everything is parsed again into an empty one
+                    m_units.clear();
+
+                    update(source, options, name);
+                }
+
+                DENK_PHASE("generate", name);
+
+                NodeProg prog;
+
+                prog.stmts.reserve(m_units.size());
+
+                for (const Unit& unit : m_units)
+                    prog.stmts.push_back(unit.stmt);
+
+                try
+                {
+                    generate(prog, options, result);
+                }
+                catch (const CompileError& error)
+                {
+                    if (!error.offset().has_value())
+                        throw;
+
+                    throw CompileError(error.what(), rebase(error.offset().value()));
+                }
+
+                DENK_COUNT("asm_bytes", result.assembly.size());
+            }
+            catch (const CompileError& error)
+            {
+                result.diagnostics.push_back({ error.what(), error.offset() });
+
+                return result;
+            }
+            catch (const std::bad_alloc&)
+            {
+                result.diagnostics.push_back({ "Fehler: Das Programm ist zu groß für den Arbeitsspeicher des Compilers" });
+
+                return result;
+            }
+
+            result.success = true;
+
+            return result;
+        }
+
+        // Top-level statements parsed by the last compilation, out of 'statements()'
+        size_t reparsed() const
+        {
+            return m_reparsed;
+        }
+
+        size_t statements() const
+        {
+            return m_units.size();
+        }
+
+    private:
+        /* One top-level statement with the tokens it was parsed from */
+        struct Unit
+        {
+            std::vector<Token> tokens;
+            NodeStmt* stmt;
+            size_t bytes;       // arena bytes of its AST, estimated
+
+            // Bytes the statement moved since it was parsed; applied to 'tokens' and 'stmt' only when they are reused,
+            // so an edit costs the same near the end of a file as near its start
+            int64_t shift = 0;
+        };
+
+        static void generate(const NodeProg& prog, const CompileOptions& options, CompileResult& result)
+        {
+            if (options.emit_ast)
+                result.ast = write_ast(prog);
+
+            if (options.emit_c)
+                result.assembly = CGenerator(prog).gen_prog();
+            else
+            {
+                Generator generator(prog, options.profile_path, options.freestanding, options.jobs);
+
+                result.assembly = generator.gen_prog();
+
+                if (options.profile_path.has_value())
+                    result.profile_map = generator.profile_map();
+            }
+        }
+
+        // An error from a moved statement whose offsets are not shifted yet points at one of its tokens by the stale
+        // offset; the unit holding a token there that still reads the same in the source knows the shift
+        uint32_t rebase(const uint32_t offset) const
+        {
+            for (const Unit& unit : m_units)
+            {
+                const auto it = std::ranges::lower_bound(unit.tokens, offset, {}, &Token::offset);
+
+                if (it == unit.tokens.end() || it->offset != offset)
+                    continue;
+
+                const size_t actual = static_cast<size_t>(static_cast<int64_t>(offset) + unit.shift);
+
+                if (actual < m_source.size() && (!it->value.has_value() || m_source.compare(actual, it->value->size(), it->value.value()) == 0))
+                    return static_cast<uint32_t>(actual);
+            }
+
+            return offset;
+        }
+
+        static size_t start_of(const Unit& unit)
+        {
+            return static_cast<size_t>(static_cast<int64_t>(unit.tokens.front().offset) + unit.shift);
+        }
+
+        // Compared in blocks first, so the unchanged bulk of a large source is skipped at memcmp speed
+        static size_t common_prefix(std::string_view a, std::string_view b)
+        {
+            const size_t size = std::min(a.size(), b.size());
+            size_t length = 0;
+
+            while (length + COMPARE_BLOCK <= size && std::memcmp(a.data() + length, b.data() + length, COMPARE_BLOCK) == 0)
+                length += COMPARE_BLOCK;
+
+            while (length < size && a[length] == b[length])
+                length++;
+
+            return length;
+        }
+
+        static size_t common_suffix(std::string_view a, std::string_view b)
+        {
+            const size_t size = std::min(a.size(), b.size());
+            size_t length = 0;
+
+            while (length + COMPARE_BLOCK <= size
+                   && std::memcmp(a.data() + a.size() - length - COMPARE_BLOCK, b.data() + b.size() - length - COMPARE_BLOCK, COMPARE_BLOCK) == 0)
+                length += COMPARE_BLOCK;
+
+            while (length < size && a[a.size() - length - 1] == b[b.size() - length - 1])
+                length++;
+
+            return length;
+        }
+
+        static void settle(Unit& unit)
+        {
+            if (unit.shift == 0)
+                return;
+
+            for (Token& token : unit.tokens)
+                shift_offset(token, unit.shift);
+
+            shift_offsets(unit.stmt, unit.shift);
+
+            unit.shift = 0;
+        }
+
+        void update(std::string_view source, const CompileOptions& options, [[maybe_unused]] std::string_view name)
+        {
+            // Without statements there is nothing to reuse, which also covers the first compilation
+            if (m_units.empty())
+            {
+                std::vector<Token> tokens;
+
+                {
+                    DENK_PHASE("tokenize", name);
+
+                    tokens = tokenize_parallel(source, options.jobs);
+
+                    DENK_COUNT("tokens", tokens.size());
+                }
+
+                DENK_PHASE("parse", name);
+
+                m_allocator.reset();
+
+                m_units = parse_units(std::move(tokens));
+                m_live_bytes = m_allocator.used();
+                m_reparsed = m_units.size();
+                m_source = source;
+
+                DENK_COUNT("reparsed_stmts", m_reparsed);
+
+                return;
+            }
+
+            const std::string_view old_source = m_source;
+
+            const size_t prefix = common_prefix(old_source, source);
+
+            if (prefix == old_source.size() && prefix == source.size())
+                return;
+
+            const size_t suffix = common_suffix(old_source.substr(prefix), source.substr(prefix));
+
+            const size_t edit_end = old_source.size() - suffix;
+            const int64_t delta = static_cast<int64_t>(source.size()) - static_cast<int64_t>(old_source.size());
+
+            // The last statement starting at or before the edit, or the first one if the edit comes before all of them
+            size_t first = static_cast<size_t>(std::ranges::upper_bound(m_units, prefix, {}, start_of) - m_units.begin());
+
+            first = first > 0 ? first - 1 : 0;
+
+            // A 'Falls' without 'Sonst' ends where the next token is no 'Sonst', so the edit may extend it
+            if (first > 0 && std::holds_alternative<NodeStmtFalls*>(m_units[first - 1].stmt->var))
+                first--;
+
+            const size_t restart = first > 0 || start_of(m_units.front()) <= prefix ? start_of(m_units[first]) : 0;
+
+            std::vector<Token> tokens;
+            size_t last = static_cast<size_t>(std::ranges::lower_bound(m_units, edit_end, {}, start_of) - m_units.begin());
+
+            {
+                DENK_PHASE("tokenize", name);
+
+                // Statements behind the edit only move by 'delta'; once lexing is between two tokens where one of
+                // them starts, every following token is the same as before
+                const auto at_boundary = [&](const size_t position)
+                {
+                    while (last < m_units.size() && static_cast<int64_t>(start_of(m_units[last])) + delta < static_cast<int64_t>(position))
+                        last++;
+
+                    return last < m_units.size() && static_cast<int64_t>(start_of(m_units[last])) + delta == static_cast<int64_t>(position);
+                };
+
+                size_t end = 0;
+
+                tokens = Tokenizer(source).tokenize_from(restart, at_boundary, end);
+
+                if (end == source.size())
+                    last = m_units.size();
+
+                DENK_COUNT("tokens", tokens.size());
+            }
+
+            DENK_PHASE("parse", name);
+
+            std::vector<Unit> units;
+
+            try
+            {
+                units = parse_units(tokens);
+            }
+            catch (const CompileError&)
+            {
+                // The edit may have moved a statement boundary, e.g. with an unbalanced '}'; only the whole program can tell
+                std::vector<Token> all;
+
+                for (size_t i = 0; i < first; i++)
+                {
+                    settle(m_units[i]);
+
+                    all.insert(all.end(), m_units[i].tokens.begin(), m_units[i].tokens.end());
+                }
+
+                all.insert(all.end(), tokens.begin(), tokens.end());
+
+                for (size_t i = last; i < m_units.size(); i++)
+                {
+                    settle(m_units[i]);
+
+                    for (Token token : m_units[i].tokens)
+                    {
+                        shift_offset(token, delta);
+                        all.push_back(std::move(token));
+                    }
+                }
+
+                units = parse_units(std::move(all));
+                first = 0;
+                last = m_units.size();
+            }
+
+            for (size_t i = last; i < m_units.size(); i++)
+                m_units[i].shift += delta;
+
+            for (size_t i = first; i < last; i++)
+                m_live_bytes -= m_units[i].bytes;
+
+            for (const Unit& unit : units)
+                m_live_bytes += unit.bytes;
+
+            m_reparsed = units.size();
+
+            m_units.erase(m_units.begin() + static_cast<ptrdiff_t>(first), m_units.begin() + static_cast<ptrdiff_t>(last));
+            m_units.insert(m_units.begin() + static_cast<ptrdiff_t>(first), std::make_move_iterator(units.begin()), std::make_move_iterator(units.end()));
+
+            m_source = source;
+
+            // Replaced statements stay in the arena, so it is rebuilt once they take up more than the live ones
+            if (m_allocator.used() > 2 * m_live_bytes + MIN_COMPACT_BYTES)
+                compact();
+
+            DENK_COUNT("reparsed_stmts", m_reparsed);
+        }
+
+        // Parses complete top-level statements and splits the tokens between them
+        std::vector<Unit> parse_units(std::vector<Token> tokens)
+        {
+            const size_t used = m_allocator.used();
+
+            std::vector<size_t> ends;
+
+            const std::optional<NodeProg> prog = Parser(tokens, m_allocator).parse_prog(&ends);
+
+            if (!prog.has_value())
+                compile_error("Fehler: Ungültiges Programm");
+
+            const size_t bytes = (m_allocator.used() - used) / std::max<size_t>(ends.size(), 1);
+
+            std::vector<Unit> units;
+            size_t begin = 0;
+
+            units.reserve(ends.size());
+
+            for (size_t i = 0; i < ends.size(); i++)
+            {
+                units.push_back({
+                    .tokens = std::vector<Token>(std::make_move_iterator(tokens.begin() + static_cast<ptrdiff_t>(begin)),
+                                                 std::make_move_iterator(tokens.begin() + static_cast<ptrdiff_t>(ends[i]))),
+                    .stmt = prog->stmts[i],
+                    .bytes = bytes,
+                    .shift = 0,
+                });
+
+                begin = ends[i];
+            }
+
+            return units;
+        }
+
+        // Parses every statement again into the emptied arena
+        void compact()
+        {
+            std::vector<Token> tokens;
+
+            for (Unit& unit : m_units)
+                for (Token& token : unit.tokens)
+                {
+                    shift_offset(token, unit.shift);
+                    tokens.push_back(std::move(token));
+                }
+
+            m_units.clear();
+            m_allocator.reset();
+
+            m_units = parse_units(std::move(tokens));
+            m_live_bytes = m_allocator.used();
+            m_reparsed = m_units.size();
+        }
+
+        static constexpr size_t MIN_COMPACT_BYTES = 1024 * 1024;  // 1 MiB
+        static constexpr size_t COMPARE_BLOCK = 4096;
+
+        ArenaAllocator m_allocator;
+
+        std::string m_source;           // of the last good compilation
+        std::vector<Unit> m_units;
+        size_t m_live_bytes = 0;
+        size_t m_reparsed = 0;
+};
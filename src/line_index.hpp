@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Line and column of a byte offset, both counted from 1; columns count UTF-8 characters, not bytes */
+struct SourceLocation
+{
+    size_t line;
+    size_t column;
+};
+
+/*
+ * Maps byte offsets to lines and columns. Tokens and diagnostics only carry offsets, so the lexer never counts lines;
+ * the line starts are scanned here on the first lookup, which only happens when a diagnostic is printed.
+ */
+class LineIndex
+{
+    public:
+        explicit LineIndex(std::string_view src) : m_src(src) {}
+
+        SourceLocation locate(uint32_t offset)
+        {
+            if (m_line_starts.empty())
+                build();
+
+            offset = std::min<uint32_t>(offset, static_cast<uint32_t>(m_src.size()));
+
+            // The first line starts at 0, so there is always a line start at or before the offset
+            const auto next = std::ranges::upper_bound(m_line_starts, offset);
+            const uint32_t start = *(next - 1);
+
+            size_t column = 1;
+
+            // Continuation bytes (10xxxxxx) belong to the character before them
+            for (uint32_t i = start; i < offset; i++)
+                column += (static_cast<unsigned char>(m_src[i]) & 0xC0) != 0x80;
+
+            return { static_cast<size_t>(next - m_line_starts.begin()), column };
+        }
+
+        // 'line:column', the prefix of a printed diagnostic
+        std::string format(const uint32_t offset)
+        {
+            const SourceLocation location = locate(offset);
+
+            return std::to_string(location.line) + ":" + std::to_string(location.column);
+        }
+
+    private:
+        void build()
+        {
+            m_line_starts.push_back(0);
+
+            size_t i = 0;
+
+#ifdef __SSE2__
+            // Sixteen bytes per compare; each set bit of the mask is a newline
+            const __m128i newline = _mm_set1_epi8('\n');
+
+            for (; i + 16 <= m_src.size(); i += 16)
+            {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_src.data() + i));
+
+                for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline))); mask != 0; mask &= mask - 1)
+                    m_line_starts.push_back(static_cast<uint32_t>(i + static_cast<size_t>(std::countr_zero(mask)) + 1));
+            }
+#endif
+
+            for (; i < m_src.size(); i++)
+                if (m_src[i] == '\n')
+                    m_line_starts.push_back(static_cast<uint32_t>(i + 1));
+        }
+
+        const std::string_view m_src;   // not owned, the caller keeps the source alive
+        std::vector<uint32_t> m_line_starts;
+};
@@ -4,90 +4,804 @@
 #include <optional>
 #include <fstream>
 #include <filesystem>
+#include <atomic>
+#include <set>
+#include <thread>
+#include <charconv>
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include <utility>
 
-#include "tokenizer.hpp"
-#include "parser.hpp"
-#include "generator.hpp"
+#include "ast_file.hpp"
+#include "compiler.hpp"
+#include "incremental.hpp"
+#include "line_index.hpp"
+#include "process.hpp"
+#include "thread_pool.hpp"
+#include "cache.hpp"
+#include "server.hpp"
+#include "stats.hpp"
 
-int main(int argc, char* argv[])
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static constexpr std::string_view DENK_VERSION = "0.2.0";
+
+#ifdef _WIN32
+static constexpr std::string_view EXE_SUFFIX = ".exe";
+#else
+static constexpr std::string_view EXE_SUFFIX = "";
+#endif
+
+struct Options
+{
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path out_dir = "out";
+    size_t jobs = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+    std::string format = "win64";   // NASM output format
+    bool keep_asm = false;          // also write '<stem>.asm' to the output directory
+    bool profile = false;           // instrument the programs, see 'denkprof'
+    bool emit_ast = false;          // also write '<stem>.dast', see 'ast_file.hpp'
+    bool freestanding = false;      // Linux ELF with its own '_start', linked with 'ld' instead of GCC
+    bool emit_c = false;            // write '<stem>.c' instead of assembly and build it with 'gcc -O2'
+
+    std::optional<std::filesystem::path> cache_dir;
+    uintmax_t cache_size = 256;     // MiB
+
+    bool server = false;            // serve compile requests on stdin/stdout
+    std::optional<std::string> socket_path;
+
+    bool watch = false;             // compile again whenever an input is saved (Linux only)
+
+    bool stats = false;             // print per-phase statistics (needs a DENK_STATS build)
+    std::optional<std::string> trace_path;
+};
+
+static void print_usage()
+{
+    std::cerr << "Verwendung: DEnk [-j N] [-o Verzeichnis] [--keep-asm] [--profile-gen] [--emit-ast] [--freestanding] [--emit-c] [--watch] [--cache Verzeichnis] [--cache-size MiB] [--stats] [--trace Datei.json] Datei.DEnk|Datei.dast...\n"
+              << "            DEnk --server [--socket Pfad] [-j N]" << std::endl;
+}
+
+// Relative, so the program writes its profile into the directory it runs in
+static std::string profile_path(const std::filesystem::path& input)
+{
+    return input.stem().string() + ".prof";
+}
+
+// Everything besides the source that changes the artifacts has to be part of the cache key; a profiled program has the
+// name of its profile built in
+static std::string fingerprint(const Options& options, const std::filesystem::path& input)
 {
-    system("chcp 65001 > nul");
+    return std::string(DENK_VERSION) + " (" __DATE__ " " __TIME__ ")|" + options.format + (options.profile ? "|profile=" + profile_path(input) : "")
+         + (options.freestanding ? "|freestanding" : "") + (options.emit_c ? "|c" : "");
+}
+
+// Inputs written by '--emit-ast' skip lexing and parsing
+static bool is_ast_file(const std::filesystem::path& input)
+{
+    return input.extension() == ".dast";
+}
+
+static std::optional<Options> parse_args(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--server")
+            options.server = true;
+
+        else if (arg == "--keep-asm")
+            options.keep_asm = true;
+
+        else if (arg == "--profile-gen")
+            options.profile = true;
+
+        else if (arg == "--stats")
+            options.stats = true;
+
+        else if (arg == "--watch")
+            options.watch = true;
+
+        else if (arg == "--emit-ast")
+            options.emit_ast = true;
+
+        else if (arg == "--emit-c")
+            options.emit_c = true;
+
+        else if (arg == "--freestanding")
+        {
+            options.freestanding = true;
+            options.format = "elf64";
+        }
+
+        else if (arg == "-o" || arg == "-j" || arg == "--cache" || arg == "--cache-size" || arg == "--socket" || arg == "--trace")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Fehler: Option '" << arg << "' benötigt einen Wert" << std::endl;
+
+                return std::nullopt;
+            }
+
+            const std::string_view value = argv[++i];
+
+            if (arg == "-o")
+                options.out_dir = value;
+
+            else if (arg == "--cache")
+                options.cache_dir = value;
+
+            else if (arg == "--socket")
+                options.socket_path = value;
+
+            else if (arg == "--trace")
+                options.trace_path = value;
+
+            else if (arg == "--cache-size")
+            {
+                if (std::from_chars(value.data(), value.data() + value.size(), options.cache_size).ec != std::errc{})
+                {
+                    std::cerr << "Fehler: Ungültige Cache-Größe '" << value << "'" << std::endl;
+
+                    return std::nullopt;
+                }
+            }
+
+            else if (std::from_chars(value.data(), value.data() + value.size(), options.jobs).ec != std::errc{} || options.jobs == 0)
+            {
+                std::cerr << "Fehler: Ungültige Anzahl paralleler Aufträge '" << value << "'" << std::endl;
+
+                return std::nullopt;
+            }
+        }
+        else if (arg.starts_with("-j") && arg.size() > 2)
+        {
+            const std::string_view value = arg.substr(2);
+
+            if (std::from_chars(value.data(), value.data() + value.size(), options.jobs).ec != std::errc{} || options.jobs == 0)
+            {
+                std::cerr << "Fehler: Ungültige Anzahl paralleler Aufträge '" << value << "'" << std::endl;
+
+                return std::nullopt;
+            }
+        }
+        else
+            options.inputs.emplace_back(arg);
+    }
+
+    if (options.socket_path.has_value() && !options.server)
+    {
+        std::cerr << "Fehler: '--socket' ist nur zusammen mit '--server' möglich" << std::endl;
+
+        return std::nullopt;
+    }
+
+    // A watched build never finishes, so it would neither fill the cache nor use it
+    if (options.watch && (options.server || options.cache_dir.has_value()))
+    {
+        std::cerr << "Fehler: '--watch' ist nicht zusammen mit '--server' oder '--cache' möglich" << std::endl;
+
+        return std::nullopt;
+    }
+
+    // The C back end has neither counters nor a runtime of its own
+    if (options.emit_c && (options.profile || options.freestanding))
+    {
+        std::cerr << "Fehler: '--emit-c' ist nicht zusammen mit '--profile-gen' oder '--freestanding' möglich" << std::endl;
+
+        return std::nullopt;
+    }
+
+    if (options.watch && std::ranges::any_of(options.inputs, is_ast_file))
+    {
+        std::cerr << "Fehler: '--watch' benötigt DEnk-Quelltexte" << std::endl;
+
+        return std::nullopt;
+    }
+
+#ifndef DENK_STATS
+    if (options.stats || options.trace_path.has_value())
+    {
+        std::cerr << "Fehler: '--stats' und '--trace' benötigen einen mit DENK_STATS gebauten Compiler (make STATS=1)" << std::endl;
+
+        return std::nullopt;
+    }
+#endif
 
-    if (argc != 2)
+    if (options.inputs.empty() && !options.server)
     {
         std::cerr << "Fehler: Eine DEnk-Datei (*.DEnk) wird benötigt" << std::endl;
 
-        return EXIT_FAILURE;
+        return std::nullopt;
     }
 
-    const std::string filename = argv[1];
+    // Outputs are named after the input, so two inputs with the same name would overwrite each other
+    std::set<std::filesystem::path> stems;
 
-    std::ifstream input(filename, std::ios::binary);
-    
-    if (!input)
+    for (const auto& input : options.inputs)
     {
-        std::cerr << "Fehler: Die Datei konnte nicht geöffnet werden" << std::endl;
-        
-        return EXIT_FAILURE;
+        if (!stems.insert(input.stem()).second)
+        {
+            std::cerr << "Fehler: Mehrere Eingaben ergeben dieselbe Ausgabe '" << input.stem().string() << "'" << std::endl;
+
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+static bool read_file(const std::filesystem::path& input, std::string& contents)
+{
+    std::ifstream file_in(input, std::ios::binary);
+
+    if (!file_in)
+    {
+        std::cerr << "Fehler: Die Datei '" << input.string() << "' konnte nicht geöffnet werden" << std::endl;
+
+        return false;
     }
 
-    std::string contents(
-        (std::istreambuf_iterator<char>(input)),
+    contents.assign(
+        (std::istreambuf_iterator<char>(file_in)),
         std::istreambuf_iterator<char>()
     );
 
-    Tokenizer tokenizer(std::move(contents));
-    std::vector<Token> tokens = tokenizer.tokenize();
+    return true;
+}
+
+// Tokenizes, parses and generates one source with a 'Compiler' or an 'IncrementalCompiler', or loads a '.dast' with a 'Compiler';
+// with '--profile-gen' also writes '<stem>.profmap', with '--emit-ast' '<stem>.dast'
+template <typename AnyCompiler>
+static bool compile_source(AnyCompiler& compiler, const Options& options, const std::filesystem::path& input, std::string_view contents,
+                           const std::filesystem::path& map_path, const std::filesystem::path& ast_path, std::string& assembly)
+{
+    const bool from_ast = is_ast_file(input);
+
+    CompileOptions compile_options;
+
+    compile_options.format = options.format;
+    compile_options.freestanding = options.freestanding;
+    compile_options.emit_c = options.emit_c;
+
+    // A loaded tree is written back unchanged, and maybe over the mapped input
+    compile_options.emit_ast = options.emit_ast && !from_ast;
+
+    if (options.profile)
+        compile_options.profile_path = profile_path(input);
 
-    Parser parser(std::move(tokens));
-    std::optional<NodeProg> prog = parser.parse_prog();
+    // With a single input the other workers would idle, so they help lexing and generating it
+    if (options.inputs.size() == 1)
+        compile_options.jobs = options.jobs;
 
-    if (!prog.has_value())
+    CompileResult result;
+
+    if constexpr (requires { compiler.compile(std::declval<const AstView&>()); })
     {
-        std::cerr << "Fehler: Ungültiges Programm" << std::endl;
+        if (from_ast)
+        {
+            const std::optional<AstView> ast = AstView::open(contents);
 
-        return EXIT_FAILURE;
+            if (!ast.has_value())
+            {
+                std::cerr << "Fehler: '" << input.string() << "' ist keine AST-Datei der Version " << AST_VERSION << std::endl;
+
+                return false;
+            }
+
+            result = compiler.compile(ast.value(), compile_options, input.string());
+        }
+        else
+            result = compiler.compile(contents, compile_options, input.string());
     }
+    else
+        result = compiler.compile(contents, compile_options, input.string());
 
-    std::error_code ec;
+    // Lines are only counted when there is something to report
+    LineIndex lines(contents);
 
-    if (!std::filesystem::exists("out") && !std::filesystem::create_directory("out", ec))
+    for (const Diagnostic& diagnostic : result.diagnostics)
     {
-        std::cerr << "Fehler: Ausgabeverzeichnis konnte nicht erstellt werden: " << ec.message() << std::endl;
-        
+        std::cerr << input.string() << ":";
+
+        // Offsets of a loaded tree point into a source that is not at hand
+        if (diagnostic.offset.has_value() && !from_ast)
+            std::cerr << lines.format(diagnostic.offset.value()) << ":";
+
+        std::cerr << " " << diagnostic.message << std::endl;
+    }
+
+    if (!result.success)
+        return false;
+
+    if (options.profile && !(std::ofstream(map_path, std::ios::binary) << result.profile_map))
+    {
+        std::cerr << "Fehler: Die Ausgabedatei '" << map_path.string() << "' konnte nicht erstellt werden" << std::endl;
+
+        return false;
+    }
+
+    if (compile_options.emit_ast && !(std::ofstream(ast_path, std::ios::binary) << result.ast))
+    {
+        std::cerr << "Fehler: Die Ausgabedatei '" << ast_path.string() << "' konnte nicht erstellt werden" << std::endl;
+
+        return false;
+    }
+
+    assembly = std::move(result.assembly);
+
+    return true;
+}
+
+// Prints a tool's error output, then our own message
+static bool tool_failed(const std::filesystem::path& input, const ProcessResult& process, std::string_view message)
+{
+    std::cerr << process.errors;
+    std::cerr << input.string() << ": " << message << " (" << process.exit_code << ")" << std::endl;
+
+    return false;
+}
+
+// '<stem>.c' for '--emit-c', otherwise the '<stem>.asm' that '--keep-asm' keeps
+static std::string_view generated_extension(const Options& options)
+{
+    return options.emit_c ? ".c" : ".asm";
+}
+
+// Writes the C source of '--emit-c' next to the program and builds it with an optimizing GCC
+static bool compile_c(const std::filesystem::path& input, std::string_view source, const std::filesystem::path& c_path,
+                      const std::filesystem::path& exe_path)
+{
+    {
+        DENK_PHASE("write", input.string());
+
+        if (!(std::ofstream(c_path, std::ios::out | std::ios::binary) << source))
+        {
+            std::cerr << "Fehler: Die Ausgabedatei '" << c_path.string() << "' konnte nicht erstellt werden" << std::endl;
+
+            return false;
+        }
+    }
+
+    ProcessResult process;
+
+    {
+        DENK_PHASE("gcc", input.string());
+
+        process = run_process({ "gcc", "-O2", c_path.string(), "-o", exe_path.string() });
+
+        DENK_COUNT("exe_bytes", process.exit_code == 0 ? std::filesystem::file_size(exe_path) : 0);
+    }
+
+    if (process.exit_code != 0)
+        return tool_failed(input, process, "Fehler: GCC konnte den erzeugten C-Quelltext nicht übersetzen");
+
+    std::cerr << process.errors;
+
+    return true;
+}
+
+// Hands the assembly to NASM, kept in memory unless '--keep-asm' asks for '<stem>.asm', then links with GCC, or with 'ld'
+// alone for '--freestanding' so no C runtime ends up in the program; C from '--emit-c' goes to 'compile_c' instead
+static bool assemble_and_link(const Options& options, const std::filesystem::path& input, std::string_view assembly,
+                              const std::filesystem::path& asm_path, const std::filesystem::path& obj_path, const std::filesystem::path& exe_path)
+{
+    if (options.emit_c)
+        return compile_c(input, assembly, asm_path, exe_path);
+
+    std::optional<ScratchFile> scratch;
+    std::string asm_file;
+
+    {
+        DENK_PHASE("write", input.string());
+
+        bool written;
+
+        if (options.keep_asm)
+        {
+            std::ofstream file_out(asm_path, std::ios::out | std::ios::binary);
+
+            written = static_cast<bool>(file_out << assembly);
+            asm_file = asm_path.string();
+        }
+        else
+        {
+            scratch.emplace(".asm");
+
+            written = scratch->write(assembly);
+            asm_file = scratch->path();
+        }
+
+        if (!written)
+        {
+            std::cerr << "Fehler: Die Ausgabedatei '" << asm_file << "' konnte nicht erstellt werden" << std::endl;
+
+            return false;
+        }
+
+        DENK_COUNT("asm_bytes", assembly.size());
+    }
+
+    ProcessResult process;
+
+    {
+        DENK_PHASE("nasm", input.string());
+
+        process = run_process({ "nasm", "-f", options.format, asm_file, "-o", obj_path.string() });
+
+        DENK_COUNT("obj_bytes", process.exit_code == 0 ? std::filesystem::file_size(obj_path) : 0);
+    }
+
+    if (process.exit_code != 0)
+        return tool_failed(input, process, "Fehler: NASM-Assembler konnte nicht erfolgreich ausgeführt werden");
+
+    if (options.freestanding)
+    {
+        DENK_PHASE("ld", input.string());
+
+        // Code and headers share a page, no symbols and no build ID: a few hundred bytes for small programs
+        process = run_process({ "ld", "-static", "-nostdlib", "-z", "noseparate-code", "-s", "--build-id=none",
+                                obj_path.string(), "-o", exe_path.string() });
+
+        DENK_COUNT("exe_bytes", process.exit_code == 0 ? std::filesystem::file_size(exe_path) : 0);
+    }
+    else
+    {
+        DENK_PHASE("gcc", input.string());
+
+        process = run_process({ "gcc", obj_path.string(), "-o", exe_path.string() });
+
+        DENK_COUNT("exe_bytes", process.exit_code == 0 ? std::filesystem::file_size(exe_path) : 0);
+    }
+
+    if (process.exit_code != 0)
+        return tool_failed(input, process, options.freestanding ? "Fehler: ld-Linker konnte nicht erfolgreich ausgeführt werden"
+                                                                : "Fehler: GCC-Linker konnte nicht erfolgreich ausgeführt werden");
+
+    // Warnings of a successful run still belong to the user
+    std::cerr << process.errors;
+
+    return true;
+}
+
+// Prints the statistics table to stderr and writes the trace file, as requested on the command line
+static bool report_stats([[maybe_unused]] const Options& options)
+{
+#ifdef DENK_STATS
+    if (options.stats)
+        Stats::instance().print_table(std::cerr);
+
+    if (options.trace_path.has_value() && !Stats::instance().write_trace(options.trace_path.value()))
+    {
+        std::cerr << "Fehler: Die Trace-Datei '" << options.trace_path.value() << "' konnte nicht geschrieben werden" << std::endl;
+
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+#ifdef __linux__
+/* An input of '--watch' with everything kept from its last compilation */
+struct WatchedInput
+{
+    std::filesystem::path input;
+    IncrementalCompiler compiler;
+    std::string contents;
+};
+
+// Compiles one watched input again and reports how much of it had to be parsed
+static void rebuild(const Options& options, WatchedInput& watched)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::filesystem::path stem = options.out_dir / watched.input.stem();
+    const std::filesystem::path asm_path = std::filesystem::path(stem) += generated_extension(options);
+    const std::filesystem::path obj_path = std::filesystem::path(stem) += ".o";
+    const std::filesystem::path exe_path = std::filesystem::path(stem) += EXE_SUFFIX;
+    const std::filesystem::path map_path = std::filesystem::path(stem) += ".profmap";
+    const std::filesystem::path ast_path = std::filesystem::path(stem) += ".dast";
+
+    std::string assembly;
+
+    if (!read_file(watched.input, watched.contents)
+        || !compile_source(watched.compiler, options, watched.input, watched.contents, map_path, ast_path, assembly)
+        || !assemble_and_link(options, watched.input, assembly, asm_path, obj_path, exe_path))
+        return;
+
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << watched.input.string() << ": " << watched.compiler.reparsed() << " von " << watched.compiler.statements()
+              << " Anweisungen neu geparst, fertig nach " << milliseconds << " ms" << std::endl;
+}
+
+// Compiles every input, then again whenever it is saved, until the process is stopped
+static int watch(const Options& options)
+{
+    const int fd = inotify_init1(IN_CLOEXEC);
+
+    if (fd < 0)
+    {
+        std::cerr << "Fehler: Die Dateiüberwachung konnte nicht gestartet werden" << std::endl;
+
         return EXIT_FAILURE;
     }
 
-    Generator generator(prog.value());
+    std::vector<WatchedInput> inputs;
+    std::map<std::pair<int, std::string>, size_t> watches;   // (watch descriptor, file name) -> input
+
+    for (const auto& input : options.inputs)
+    {
+        // Many editors save by renaming a new file over the old one, so the directory is watched instead of the file
+        const std::filesystem::path directory = input.has_parent_path() ? input.parent_path() : std::filesystem::path(".");
+
+        const int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+        if (wd < 0)
+        {
+            std::cerr << "Fehler: Das Verzeichnis '" << directory.string() << "' kann nicht überwacht werden" << std::endl;
+
+            close(fd);
+
+            return EXIT_FAILURE;
+        }
+
+        watches[{ wd, input.filename().string() }] = inputs.size();
+
+        inputs.push_back({ .input = input, .compiler = IncrementalCompiler(), .contents = {} });
+    }
+
+    for (WatchedInput& watched : inputs)
+        rebuild(options, watched);
 
-    std::ofstream file("out/out.asm", std::ios::out | std::ios::binary);
-    
-    if (!file)
+    std::cerr << "Warte auf Änderungen..." << std::endl;
+
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    while (true)
     {
-        std::cerr << "Fehler: Die Ausgabedatei konnte nicht erstellt werden" << std::endl;
-        
+        const ssize_t length = read(fd, buffer, sizeof(buffer));
+
+        if (length < 0 && errno == EINTR)
+            continue;
+
+        if (length <= 0)
+        {
+            std::cerr << "Fehler: Die Dateiüberwachung wurde unterbrochen" << std::endl;
+
+            close(fd);
+
+            return EXIT_FAILURE;
+        }
+
+        // One save often raises several events, so each input is compiled once per batch
+        std::set<size_t> changed;
+
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+            if (event->len > 0)
+                if (const auto it = watches.find({ event->wd, event->name }); it != watches.end())
+                    changed.insert(it->second);
+
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+
+        for (const size_t index : changed)
+            rebuild(options, inputs[index]);
+    }
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    // The German messages are UTF-8; other terminals already expect that
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    const std::optional<Options> options = parse_args(argc, argv);
+
+    if (!options.has_value())
+    {
+        print_usage();
+
         return EXIT_FAILURE;
     }
 
-    file << generator.gen_prog();
+    if (options->server)
+    {
+#ifndef _WIN32
+        if (options->socket_path.has_value())
+            return serve_socket(options->socket_path.value(), options->jobs) ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+        if (options->socket_path.has_value())
+        {
+            std::cerr << "Fehler: '--socket' wird unter Windows nicht unterstützt" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+        std::ios::sync_with_stdio(false);
+
+        Compiler compiler;
+
+        serve(std::cin, std::cout, compiler);
+
+        return report_stats(options.value()) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::error_code ec;
 
-    int ret = system("nasm -f win64 out/out.asm -o out/out.o");
-    
-    if (ret != 0)
+    if (!std::filesystem::exists(options->out_dir) && !std::filesystem::create_directories(options->out_dir, ec))
     {
-        std::cerr << "Fehler: NASM-Assembler konnte nicht erfolgreich ausgeführt werden (" << ret << ")" << std::endl;
-        
+        std::cerr << "Fehler: Ausgabeverzeichnis konnte nicht erstellt werden: " << ec.message() << std::endl;
+
         return EXIT_FAILURE;
     }
 
-    ret = system("gcc out/out.o -o out/out");
-    
-    if (ret != 0)
+    if (options->watch)
     {
-        std::cerr << "Fehler: GCC-Linker konnte nicht erfolgreich ausgeführt werden" << std::endl;
-        
+#ifdef __linux__
+        return watch(options.value());
+#else
+        std::cerr << "Fehler: '--watch' wird nur unter Linux unterstützt" << std::endl;
+
         return EXIT_FAILURE;
+#endif
     }
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    std::optional<BuildCache> cache;
+
+    if (options->cache_dir.has_value())
+    {
+        cache.emplace(options->cache_dir.value(), options->cache_size * 1024 * 1024);
+
+        if (!cache->create_directory())
+        {
+            std::cerr << "Fehler: Cache-Verzeichnis konnte nicht erstellt werden" << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::atomic<bool> failed = false;
+
+    {
+        ThreadPool pool(std::min(options->jobs, options->inputs.size()));
+
+        for (const auto& input : options->inputs)
+        {
+            pool.submit([&, input]
+            {
+                const std::filesystem::path stem = options->out_dir / input.stem();
+                const std::filesystem::path asm_path = std::filesystem::path(stem) += generated_extension(options.value());
+                const std::filesystem::path obj_path = std::filesystem::path(stem) += ".o";
+                const std::filesystem::path exe_path = std::filesystem::path(stem) += EXE_SUFFIX;
+                const std::filesystem::path map_path = std::filesystem::path(stem) += ".profmap";
+                const std::filesystem::path ast_path = std::filesystem::path(stem) += ".dast";
+
+                // Each worker reuses its source buffer across files; a '.dast' is mapped and used in place
+                thread_local std::string buffer;
+
+                std::optional<MappedFile> mapped;
+                std::string_view contents;
+
+                if (is_ast_file(input))
+                {
+                    mapped = MappedFile::open(input);
+
+                    if (!mapped.has_value())
+                    {
+                        std::cerr << "Fehler: Die Datei '" << input.string() << "' konnte nicht geöffnet werden" << std::endl;
+
+                        failed = true;
+
+                        return;
+                    }
+
+                    contents = mapped->bytes();
+                }
+                else
+                {
+                    if (!read_file(input, buffer))
+                    {
+                        failed = true;
+
+                        return;
+                    }
+
+                    contents = buffer;
+                }
+
+                std::vector<std::pair<std::string, std::filesystem::path>> artifacts = {
+                    { ".exe", exe_path }
+                };
+
+                // The C source takes the place of the object file, there is none
+                if (options->emit_c)
+                    artifacts.emplace_back(".c", asm_path);
+                else
+                    artifacts.emplace_back(".o", obj_path);
+
+                if (options->keep_asm && !options->emit_c)
+                    artifacts.emplace_back(".asm", asm_path);
+
+                if (options->profile)
+                    artifacts.emplace_back(".profmap", map_path);
+
+                if (options->emit_ast && !is_ast_file(input))
+                    artifacts.emplace_back(".dast", ast_path);
+
+                std::string key;
+
+                if (cache.has_value())
+                {
+                    key = BuildCache::key(contents, fingerprint(options.value(), input));
+
+                    // A hit skips the whole pipeline, including NASM and GCC
+                    if (cache->fetch(key, artifacts))
+                        return;
+                }
+
+                // Each worker reuses its compiler, and with it the arena, across files
+                thread_local Compiler compiler;
+
+                std::string assembly;
+
+                if (!compile_source(compiler, options.value(), input, contents, map_path, ast_path, assembly))
+                {
+                    failed = true;
+
+                    return;
+                }
+
+                // Runs next on this worker, unless an idle worker steals it first
+                pool.submit([&, input, assembly = std::move(assembly), asm_path, obj_path, exe_path, artifacts, key]
+                {
+                    if (!assemble_and_link(options.value(), input, assembly, asm_path, obj_path, exe_path))
+                    {
+                        failed = true;
+
+                        return;
+                    }
+
+                    if (cache.has_value())
+                        for (const auto& [ext, path] : artifacts)
+                            cache->store(key, ext, path);
+                });
+            });
+        }
+
+        pool.wait();
+    }
+
+    if (cache.has_value())
+        cache->evict();
+
+    if (!report_stats(options.value()))
+        return EXIT_FAILURE;
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "diagnostics.hpp"
+#include "thread_pool.hpp"
+#include "tokenizer.hpp"
+
+// Below this size per thread, starting the threads costs more than lexing
+static constexpr size_t MIN_LEX_CHUNK_SIZE = 1024 * 1024;   // 1 MiB
+
+/*
+ * Lexes a large source on several threads with the same result as 'Tokenizer::tokenize'.
+ *
+ * Chunks end after a newline, which never lies inside a token or a line comment. Whether a chunk
+ * starts inside a block comment is only known once the chunks before it are lexed, so every chunk
+ * is lexed as if it did not, and a sequential fix-up pass re-lexes the chunks where that was wrong.
+ */
+inline std::vector<Token> tokenize_parallel(std::string_view src, const size_t jobs)
+{
+    const size_t count = std::min(jobs, src.size() / MIN_LEX_CHUNK_SIZE);
+
+    if (count < 2)
+        return Tokenizer(src).tokenize();
+
+    // Each chunk only sees its own size, but the offsets cover the whole source
+    if (src.size() > std::numeric_limits<uint32_t>::max())
+        compile_error("Fehler: Quelltexte über 4 GiB werden nicht unterstützt");
+
+    struct Chunk
+    {
+        std::string_view text;
+        size_t start;               // of 'text' in the whole source
+        std::vector<Token> tokens;
+        std::optional<uint32_t> open_comment;   // start of the comment the chunk ends in, in the whole source
+        std::optional<CompileError> error;      // only meaningful if the chunk really starts outside a comment
+
+        void lex()
+        {
+            const uint32_t base = static_cast<uint32_t>(start);
+
+            try
+            {
+                tokens = Tokenizer(text).tokenize_chunk(open_comment);
+
+                for (Token& token : tokens)
+                    token.offset += base;
+
+                if (open_comment.has_value())
+                    *open_comment += base;
+            }
+            catch (const CompileError& e)
+            {
+                error = CompileError(e.what(), e.offset().has_value() ? std::optional<uint32_t>(*e.offset() + base) : std::nullopt);
+            }
+        }
+    };
+
+    std::vector<Chunk> chunks;
+
+    for (size_t start = 0; start < src.size(); )
+    {
+        size_t end = std::min(start + src.size() / count, src.size());
+
+        if (end < src.size())
+        {
+            const size_t newline = src.find('\n', end);
+
+            end = newline == std::string_view::npos ? src.size() : newline + 1;
+        }
+
+        chunks.push_back({ .text = src.substr(start, end - start), .start = start, .tokens = {}, .open_comment = std::nullopt, .error = std::nullopt });
+
+        start = end;
+    }
+
+    {
+        ThreadPool pool(chunks.size());
+
+        for (Chunk& chunk : chunks)
+            pool.submit([&chunk] { chunk.lex(); });
+
+        pool.wait();
+    }
+
+    // Fix-up: a chunk after an open block comment continues that comment up to the first '*/'
+    std::optional<uint32_t> in_comment;   // start of the comment the previous chunk ended in
+    size_t total = 0;
+
+    for (Chunk& chunk : chunks)
+    {
+        if (in_comment.has_value())
+        {
+            const size_t close = chunk.text.find("*/");
+
+            if (close == std::string_view::npos)
+            {
+                chunk.tokens.clear();
+
+                continue;
+            }
+
+            chunk.text.remove_prefix(close + 2);
+            chunk.start += close + 2;
+            chunk.tokens.clear();
+            chunk.error = std::nullopt;
+            chunk.lex();
+        }
+
+        if (chunk.error.has_value())
+            throw *chunk.error;
+
+        in_comment = chunk.open_comment;
+        total += chunk.tokens.size();
+    }
+
+    if (in_comment.has_value())
+        compile_error_at(*in_comment, "Fehler: Mehrzeiliger Kommentar wurde nicht korrekt geschlossen (erwartetes '*/')");
+
+    // Tokens are moved, so their strings are not copied again
+    std::vector<Token> tokens = std::move(chunks.front().tokens);
+
+    tokens.reserve(total);
+
+    for (size_t i = 1; i < chunks.size(); i++)
+        tokens.insert(tokens.end(), std::make_move_iterator(chunks[i].tokens.begin()), std::make_move_iterator(chunks[i].tokens.end()));
+
+    return tokens;
+}
@@ -13,13 +13,14 @@
 #include "ast.hpp"
 #include "arena.hpp"
 #include "tokenizer.hpp"
+#include "diagnostics.hpp"
 
 class Parser
 {
     public:
-        explicit Parser(std::vector<Token> tokens)
+        Parser(std::vector<Token> tokens, ArenaAllocator& allocator)
             : m_tokens(std::move(tokens))
-            , m_allocator(1024 * 1024 * 4)  // 4 MB
+            , m_allocator(allocator)
         {
         }
 
@@ -27,10 +28,10 @@ class Parser
         {
             if (auto int_lit = try_consume(TokenType::int_lit))
             {
-                auto term_int_lit = m_allocator.alloc<NodeTermIntLit>();
+                auto term_int_lit = m_allocator.emplace<NodeTermIntLit>();
                 term_int_lit->int_lit = int_lit.value();
 
-                auto term = m_allocator.alloc<NodeTerm>();
+                auto term = m_allocator.emplace<NodeTerm>();
                 term->var = term_int_lit;
 
                 return term;
@@ -38,10 +39,51 @@ class Parser
             
             if (auto ident = try_consume(TokenType::ident))
             {
-                auto term_ident = m_allocator.alloc<NodeTermIdent>();
+                if (try_consume(TokenType::open_square))
+                {
+                    auto term_index = m_allocator.emplace<NodeTermIndex>();
+                    term_index->ident = ident.value();
+                    term_index->index = parse_index();
+
+                    auto term = m_allocator.emplace<NodeTerm>();
+                    term->var = term_index;
+
+                    return term;
+                }
+
+                if (try_consume(TokenType::open_paren))
+                {
+                    auto term_call = m_allocator.emplace<NodeTermCall>();
+                    term_call->ident = ident.value();
+
+                    if (!try_consume(TokenType::close_paren))
+                    {
+                        do
+                        {
+                            const auto arg = parse_expr();
+
+                            if (!arg.has_value())
+                            {
+                                error("Fehler: Argument wird erwartet");
+                            }
+
+                            term_call->args.push_back(arg.value());
+                        }
+                        while (try_consume(TokenType::comma));
+
+                        try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+                    }
+
+                    auto term = m_allocator.emplace<NodeTerm>();
+                    term->var = term_call;
+
+                    return term;
+                }
+
+                auto term_ident = m_allocator.emplace<NodeTermIdent>();
                 term_ident->ident = ident.value();
 
-                auto term = m_allocator.alloc<NodeTerm>();
+                auto term = m_allocator.emplace<NodeTerm>();
                 term->var = term_ident;
                 
                 return term;
@@ -53,17 +95,15 @@ class Parser
 
                 if (!expr.has_value())
                 {
-                    std::cerr << "Fehler: Unerwarteter Ausdruck" << std::endl;
-
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Unerwarteter Ausdruck");
                 }
 
                 try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
 
-                auto term_paren = m_allocator.alloc<NodeTermParen>();
+                auto term_paren = m_allocator.emplace<NodeTermParen>();
                 term_paren->expr = expr.value();
 
-                auto term = m_allocator.alloc<NodeTerm>();
+                auto term = m_allocator.emplace<NodeTerm>();
                 term->var = term_paren;
 
                 return term;
@@ -72,6 +112,21 @@ class Parser
             return std::nullopt;
         }
 
+        // Parses the remainder of 'A[index]' after the opening bracket
+        NodeExpr* parse_index()
+        {
+            const auto index = parse_expr();
+
+            if (!index.has_value())
+            {
+                error("Fehler: Ungültiger Index");
+            }
+
+            try_consume(TokenType::close_square, "Fehler: Token ']' wird erwartet");
+
+            return index.value();
+        }
+
         std::optional<NodeExpr*> parse_expr(const size_t min_prec = 0)
         {
             std::optional<NodeTerm*> term_lhs = parse_term();
@@ -79,7 +134,7 @@ class Parser
             if (!term_lhs.has_value())
                 return std::nullopt;
         
-            auto expr_lhs = m_allocator.alloc<NodeExpr>();
+            auto expr_lhs = m_allocator.emplace<NodeExpr>();
             expr_lhs->var = term_lhs.value();
         
             while (true)
@@ -90,21 +145,23 @@ class Parser
                 if (!prec.has_value() || prec.value() < min_prec)
                     break;
             
-                const auto [type, value] = consume();
+                const TokenType type = consume().type;
                 const size_t next_min_prec = prec.value() + 1;
+
+                // 'kleiner gleich' and 'größer gleich' are spelled with two tokens
+                const bool or_equal = (type == TokenType::kleiner || type == TokenType::größer) &&
+                                      try_consume(TokenType::gleich).has_value();
             
                 auto expr_rhs = parse_expr(next_min_prec);
             
                 if (!expr_rhs.has_value())
                 {
-                    std::cerr << "Fehler: Ausdruck kann nicht geparst werden" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ausdruck kann nicht geparst werden");
                 }
 
                 if (type == TokenType::plus || type == TokenType::minus || type == TokenType::star || type == TokenType::slash)
                 {            
-                    auto bin_expr = m_allocator.alloc<NodeBinExpr>();
+                    auto bin_expr = m_allocator.emplace<NodeBinExpr>();
                     
                     bin_expr->lhs = expr_lhs;
                     
@@ -122,48 +179,36 @@ class Parser
 
                     else
                     {
-                        std::cerr << "Fehler: Ungültiger Binäroperator" << std::endl;
-
-                        exit(EXIT_FAILURE);
+                        error("Fehler: Ungültiger Binäroperator");
                     }
                 
                     bin_expr->rhs = expr_rhs.value();
                 
-                    expr_lhs = m_allocator.alloc<NodeExpr>();
+                    expr_lhs = m_allocator.emplace<NodeExpr>();
                     expr_lhs->var = bin_expr;
                 }
                 else if (type == TokenType::gleich || type == TokenType::ungleich ||
-                         type == TokenType::kleiner || type == TokenType::größer ||
-                         type == TokenType::und || type == TokenType::oder || type == TokenType::nicht)
+                         type == TokenType::kleiner || type == TokenType::größer)
                 {
-                    auto logic_expr = m_allocator.alloc<NodeLogicExpr>();
+                    auto logic_expr = m_allocator.emplace<NodeLogicExpr>();
                     
                     logic_expr->lhs = expr_lhs;
 
-                    // TODO
-
-                    // if (type == TokenType::gleich)
-                    //     logic_expr->op = LogicOp::Equal;
-
-                    // else if (type == TokenType::ungleich || )
-                    //     logic_expr->op = LogicOp::;
+                    if (type == TokenType::gleich)
+                        logic_expr->op = LogicOp::Equal;
 
-                    // else if (type == TokenType::)
-                    //     logic_expr->op = LogicOp::;
+                    else if (type == TokenType::ungleich)
+                        logic_expr->op = LogicOp::NotEqual;
 
-                    // else if (type == TokenType::)
-                    //     logic_expr->op = LogicOp::;
+                    else if (type == TokenType::kleiner)
+                        logic_expr->op = or_equal ? LogicOp::LessEqual : LogicOp::Less;
 
-                    // else
-                    // {
-                    //     std::cerr << "Fehler: Logic_expr 에러 메시지 재작성 필요" << std::endl;
-
-                    //     exit(EXIT_FAILURE);
-                    // }
+                    else
+                        logic_expr->op = or_equal ? LogicOp::GreaterEqual : LogicOp::Greater;
                 
                     logic_expr->rhs = expr_rhs.value();
                 
-                    expr_lhs = m_allocator.alloc<NodeExpr>();
+                    expr_lhs = m_allocator.emplace<NodeExpr>();
                     expr_lhs->var = logic_expr;
                 }
             }
@@ -178,13 +223,17 @@ class Parser
                 return std::nullopt;
             }
 
-            auto scope = m_allocator.alloc<NodeScope>();
+            auto scope = m_allocator.emplace<NodeScope>();
+
+            m_depth++;
 
             while (auto stmt = parse_stmt())
             {
                 scope->stmts.push_back(stmt.value());
             }
 
+            m_depth--;
+
             try_consume(TokenType::close_curly, "Fehler: Token '}' wird erwartet");
 
             return scope;
@@ -196,41 +245,57 @@ class Parser
             {
                 if (const auto scope = parse_scope())
                 {
-                    auto stmt = m_allocator.alloc<NodeStmt>();
+                    auto stmt = m_allocator.emplace<NodeStmt>();
                     stmt->var = scope.value();
 
                     return stmt;
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültiger Gültigkeitsbereich" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültiger Gültigkeitsbereich");
                 }
             }
 
             if (try_consume(TokenType::Bestimme))
             {
-                auto stmt_Bestimme = m_allocator.alloc<NodeStmtBestimme>();
+                auto stmt_Bestimme = m_allocator.emplace<NodeStmtBestimme>();
 
                 stmt_Bestimme->ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
 
                 try_consume(TokenType::als, "Fehler: Token 'als' wird erwartet");
 
-                if (const auto expr = parse_expr())
+                stmt_Bestimme->expr = nullptr;
+                stmt_Bestimme->length = 0;
+
+                if (try_consume(TokenType::Feld))
+                {
+                    try_consume(TokenType::open_square, "Fehler: Token '[' wird erwartet");
+
+                    const Token length = try_consume(TokenType::int_lit, "Fehler: Feldlänge wird erwartet");
+
+                    try_consume(TokenType::close_square, "Fehler: Token ']' wird erwartet");
+
+                    const std::string& text = length.value.value();
+
+                    if (text.size() > 6 || std::stoul(text) == 0 || std::stoul(text) > MAX_ARRAY_LENGTH)
+                    {
+                        compile_error_at(length.offset, "Fehler: Feldlänge muss zwischen 1 und ", MAX_ARRAY_LENGTH, " liegen");
+                    }
+
+                    stmt_Bestimme->length = std::stoul(text);
+                }
+                else if (const auto expr = parse_expr())
                 {
                     stmt_Bestimme->expr = expr.value();
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültiger 'Bestimme'-Ausdruck" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültiger 'Bestimme'-Ausdruck");
                 }
 
                 try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
 
-                auto stmt = m_allocator.alloc<NodeStmt>();
+                auto stmt = m_allocator.emplace<NodeStmt>();
                 stmt->var = stmt_Bestimme;
 
                 return stmt;
@@ -238,10 +303,15 @@ class Parser
 
             if (try_consume(TokenType::Ändere))
             {
-                auto stmt_Ändere = m_allocator.alloc<NodeStmtÄndere>();
+                auto stmt_Ändere = m_allocator.emplace<NodeStmtÄndere>();
 
                 stmt_Ändere->ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
 
+                if (try_consume(TokenType::open_square))
+                    stmt_Ändere->index = parse_index();
+                else
+                    stmt_Ändere->index = std::nullopt;
+
                 try_consume(TokenType::zu, "Fehler: Token 'zu' wird erwartet");
 
                 if (const auto expr = parse_expr())
@@ -250,14 +320,12 @@ class Parser
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültiger 'Ändere'-Ausdruck" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültiger 'Ändere'-Ausdruck");
                 }
 
                 try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
 
-                auto stmt = m_allocator.alloc<NodeStmt>();
+                auto stmt = m_allocator.emplace<NodeStmt>();
                 stmt->var = stmt_Ändere;
 
                 return stmt;
@@ -265,7 +333,7 @@ class Parser
             
             if (try_consume(TokenType::Falls))
             {
-                auto stmt_falls = m_allocator.alloc<NodeStmtFalls>();
+                auto stmt_falls = m_allocator.emplace<NodeStmtFalls>();
                 
                 try_consume(TokenType::open_paren, "Fehler: Token '(' wird erwartet");
                 
@@ -275,12 +343,16 @@ class Parser
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültige Anweisung" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültige Anweisung");
                 }
 
                 try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+
+                if (try_consume(TokenType::wahrscheinlich))
+                    stmt_falls->hint = BranchHint::Likely;
+                else if (try_consume(TokenType::unwahrscheinlich))
+                    stmt_falls->hint = BranchHint::Unlikely;
+
                 try_consume(TokenType::dann, "Fehler: Token 'dann' wird erwartet");
 
                 if (const auto scope = parse_scope())
@@ -289,9 +361,7 @@ class Parser
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültiger Gültigkeitsbereich" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültiger Gültigkeitsbereich");
                 }
 
                 if (try_consume(TokenType::Sonst))
@@ -302,23 +372,54 @@ class Parser
                     }
                     else
                     {
-                        std::cerr << "Fehler: falls-sonst 에러 메시지 재작성 필요" << std::endl;
-
-                        exit(EXIT_FAILURE);
+                        error("Fehler: Nach 'Sonst' wird eine Anweisung erwartet");
                     }
                 }
                 else
                     stmt_falls->sonst = std::nullopt;
 
-                auto stmt = m_allocator.alloc<NodeStmt>();
+                auto stmt = m_allocator.emplace<NodeStmt>();
                 stmt->var = stmt_falls;
 
                 return stmt;
             }
 
+            if (try_consume(TokenType::Solange))
+            {
+                auto stmt_solange = m_allocator.emplace<NodeStmtSolange>();
+                
+                try_consume(TokenType::open_paren, "Fehler: Token '(' wird erwartet");
+                
+                if (const auto expr = parse_expr())
+                {
+                    stmt_solange->expr = expr.value();
+                }
+                else
+                {
+                    error("Fehler: Ungültige 'Solange'-Bedingung");
+                }
+
+                try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+                try_consume(TokenType::dann, "Fehler: Token 'dann' wird erwartet");
+
+                if (const auto scope = parse_scope())
+                {
+                    stmt_solange->scope = scope.value();
+                }
+                else
+                {
+                    error("Fehler: Ungültiger Gültigkeitsbereich");
+                }
+
+                auto stmt = m_allocator.emplace<NodeStmt>();
+                stmt->var = stmt_solange;
+
+                return stmt;
+            }
+
             if (try_consume(TokenType::Beende))
             {
-                auto stmt_Beende = m_allocator.alloc<NodeStmtBeende>();
+                auto stmt_Beende = m_allocator.emplace<NodeStmtBeende>();
 
                 try_consume(TokenType::mit, "Fehler: Token 'mit' wird erwartet");
                 
@@ -328,23 +429,141 @@ class Parser
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültiger 'Beende'-Ausdruck" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültiger 'Beende'-Ausdruck");
                 }
 
                 try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
 
-                auto stmt = m_allocator.alloc<NodeStmt>();
+                auto stmt = m_allocator.emplace<NodeStmt>();
                 stmt->var = stmt_Beende;
 
                 return stmt;
             }
 
+            if (try_consume(TokenType::Schreibe))
+            {
+                auto stmt_Schreibe = m_allocator.emplace<NodeStmtSchreibe>();
+
+                if (const auto node_expr = parse_expr())
+                {
+                    stmt_Schreibe->expr = node_expr.value();
+                }
+                else
+                {
+                    error("Fehler: Ungültiger 'Schreibe'-Ausdruck");
+                }
+
+                try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                auto stmt = m_allocator.emplace<NodeStmt>();
+                stmt->var = stmt_Schreibe;
+
+                return stmt;
+            }
+
+            if (try_consume(TokenType::Lies))
+            {
+                auto stmt_Lies = m_allocator.emplace<NodeStmtLies>();
+
+                stmt_Lies->ident = try_consume(TokenType::ident, "Fehler: Bezeichner wird erwartet");
+
+                try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                auto stmt = m_allocator.emplace<NodeStmt>();
+                stmt->var = stmt_Lies;
+
+                return stmt;
+            }
+
+            if (peek().has_value() && peek().value().type == TokenType::Funktion)
+            {
+                if (m_depth > 0)
+                {
+                    error("Fehler: Funktionen können nur auf oberster Ebene definiert werden");
+                }
+
+                consume();
+
+                auto stmt_funktion = m_allocator.emplace<NodeStmtFunktion>();
+
+                stmt_funktion->ident = try_consume(TokenType::ident, "Fehler: Funktionsname wird erwartet");
+
+                try_consume(TokenType::open_paren, "Fehler: Token '(' wird erwartet");
+
+                if (!try_consume(TokenType::close_paren))
+                {
+                    do
+                    {
+                        const Token param = try_consume(TokenType::ident, "Fehler: Parametername wird erwartet");
+
+                        for (const Token& other : stmt_funktion->params)
+                        {
+                            if (other.value == param.value)
+                            {
+                                compile_error_at(param.offset, "Fehler: Parameter '", param.value.value(), "' wird bereits verwendet");
+                            }
+                        }
+
+                        stmt_funktion->params.push_back(param);
+                    }
+                    while (try_consume(TokenType::comma));
+
+                    try_consume(TokenType::close_paren, "Fehler: Token ')' wird erwartet");
+                }
+
+                m_in_function = true;
+
+                if (const auto scope = parse_scope())
+                {
+                    stmt_funktion->scope = scope.value();
+                }
+                else
+                {
+                    error("Fehler: Ungültiger Gültigkeitsbereich");
+                }
+
+                m_in_function = false;
+
+                auto stmt = m_allocator.emplace<NodeStmt>();
+                stmt->var = stmt_funktion;
+
+                return stmt;
+            }
+
+            if (peek().has_value() && peek().value().type == TokenType::Gib)
+            {
+                if (!m_in_function)
+                {
+                    error("Fehler: 'Gib ... zurück' ist nur in Funktionen erlaubt");
+                }
+
+                auto stmt_Gib = m_allocator.emplace<NodeStmtGib>();
+
+                stmt_Gib->offset = consume().offset;
+
+                if (const auto node_expr = parse_expr())
+                {
+                    stmt_Gib->expr = node_expr.value();
+                }
+                else
+                {
+                    error("Fehler: Ungültiger 'Gib'-Ausdruck");
+                }
+
+                try_consume(TokenType::zurück, "Fehler: Token 'zurück' wird erwartet");
+                try_consume(TokenType::dot, "Fehler: Token '.' wird erwartet");
+
+                auto stmt = m_allocator.emplace<NodeStmt>();
+                stmt->var = stmt_Gib;
+
+                return stmt;
+            }
+
             return std::nullopt;
         }
 
-        std::optional<NodeProg> parse_prog()
+        // 'stmt_ends' receives the token index after each top-level statement, for callers that reparse them one by one
+        std::optional<NodeProg> parse_prog(std::vector<size_t>* stmt_ends = nullptr)
         {
             NodeProg prog;
 
@@ -353,18 +572,21 @@ class Parser
                 if (auto stmt = parse_stmt())
                 {
                     prog.stmts.push_back(stmt.value());
+
+                    if (stmt_ends != nullptr)
+                        stmt_ends->push_back(m_index);
                 }
                 else
                 {
-                    std::cerr << "Fehler: Ungültige Anweisung" << std::endl;
-                    
-                    exit(EXIT_FAILURE);
+                    error("Fehler: Ungültige Anweisung");
                 }
             }
 
             return prog;
         }
 
+        static constexpr size_t MAX_ARRAY_LENGTH = 65536;
+
     private:
         [[nodiscard]] std::optional<Token> peek(const size_t& offset = 0) const
         {
@@ -408,9 +630,7 @@ class Parser
                 return consume();
             }
 
-            std::cerr << err_msg << std::endl;
-                
-            exit(EXIT_FAILURE);
+            error(err_msg);
         }
 
         Token try_consume(const size_t& offset, const TokenType& type, const std::string& err_msg)
@@ -420,13 +640,28 @@ class Parser
                 return consume();
             }
 
-            std::cerr << err_msg << std::endl;
-                
-            exit(EXIT_FAILURE);
+            error(err_msg);
+        }
+
+        // Fails at the token the parser stopped at, or at the last one once all are consumed
+        template <typename... Args>
+        [[noreturn]] void error(const Args&... args) const
+        {
+            uint32_t offset = 0;
+
+            if (m_index < m_tokens.size())
+                offset = m_tokens[m_index].offset;
+            else if (!m_tokens.empty())
+                offset = m_tokens.back().offset;
+
+            compile_error_at(offset, args...);
         }
 
         const std::vector<Token> m_tokens;
         size_t m_index = 0;
 
-        ArenaAllocator m_allocator;
+        size_t m_depth = 0;             // of nested scopes, definitions are only allowed outside of all of them
+        bool m_in_function = false;
+
+        ArenaAllocator& m_allocator;    // owned by the caller, so the nodes outlive the parser
 };
\ No newline at end of file
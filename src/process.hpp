@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "unique_id.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/* A file that a child process can open by path, kept in memory where the system allows it */
+class ScratchFile
+{
+    public:
+        explicit ScratchFile(std::string_view ext)
+        {
+#ifdef __linux__
+            // NASM reads its input once per pass, so it needs a seekable file rather than a pipe
+            m_fd = memfd_create("denk", MFD_CLOEXEC);
+
+            if (m_fd >= 0)
+            {
+                m_path = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(m_fd);
+
+                return;
+            }
+#endif
+
+            std::error_code ec;
+
+            m_path = (std::filesystem::temp_directory_path(ec) / ("denk-" + std::to_string(unique_id()))).string() + std::string(ext);
+        }
+
+        ScratchFile(const ScratchFile&) = delete;
+        ScratchFile& operator=(const ScratchFile&) = delete;
+
+        ~ScratchFile()
+        {
+#ifndef _WIN32
+            if (m_fd >= 0)
+            {
+                close(m_fd);
+
+                return;
+            }
+#endif
+
+            std::error_code ec;
+
+            std::filesystem::remove(m_path, ec);
+        }
+
+        const std::string& path() const
+        {
+            return m_path;
+        }
+
+        bool write(std::string_view contents) const
+        {
+#ifndef _WIN32
+            if (m_fd >= 0)
+            {
+                for (size_t offset = 0; offset < contents.size(); )
+                {
+                    const ssize_t count = pwrite(m_fd, contents.data() + offset, contents.size() - offset, static_cast<off_t>(offset));
+
+                    if (count < 0 && errno == EINTR)
+                        continue;
+
+                    if (count <= 0)
+                        return false;
+
+                    offset += static_cast<size_t>(count);
+                }
+
+                return true;
+            }
+#endif
+
+            std::ofstream file(m_path, std::ios::binary);
+
+            return static_cast<bool>(file << contents);
+        }
+
+        std::optional<std::string> read() const
+        {
+#ifndef _WIN32
+            if (m_fd >= 0)
+            {
+                struct stat info;
+
+                if (fstat(m_fd, &info) != 0)
+                    return std::nullopt;
+
+                std::string contents(static_cast<size_t>(info.st_size), '\0');
+
+                for (size_t offset = 0; offset < contents.size(); )
+                {
+                    const ssize_t count = pread(m_fd, contents.data() + offset, contents.size() - offset, static_cast<off_t>(offset));
+
+                    if (count < 0 && errno == EINTR)
+                        continue;
+
+                    if (count <= 0)
+                        return std::nullopt;
+
+                    offset += static_cast<size_t>(count);
+                }
+
+                return contents;
+            }
+#endif
+
+            std::ifstream file(m_path, std::ios::binary);
+
+            if (!file)
+                return std::nullopt;
+
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+    private:
+        std::string m_path;
+        int m_fd = -1;
+};
+
+struct ProcessResult
+{
+    int exit_code = -1;     // -1 if the program could not be started, 128 + signal if it was killed
+    std::string errors;     // everything the program wrote to stdout and stderr
+};
+
+#ifndef _WIN32
+// Runs 'args[0]' (searched in PATH) without a shell; stdin is empty, stdout and stderr are captured together
+inline ProcessResult run_process(const std::vector<std::string>& args)
+{
+    ProcessResult result;
+
+    std::vector<char*> argv;
+
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+
+    argv.push_back(nullptr);
+
+    // Close-on-exec, so children spawned by other threads do not keep the pipe open
+    int pipe_fds[2];
+
+    if (pipe2(pipe_fds, O_CLOEXEC) != 0)
+    {
+        result.errors = std::string("Fehler: Pipe konnte nicht erstellt werden: ") + std::strerror(errno) + "\n";
+
+        return result;
+    }
+
+    posix_spawn_file_actions_t actions;
+
+    int error = posix_spawn_file_actions_init(&actions);
+
+    if (error != 0)
+    {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+
+        result.errors = "Fehler: '" + args[0] + "' konnte nicht gestartet werden: " + std::strerror(error) + "\n";
+
+        return result;
+    }
+
+    // Each step only runs if the one before it succeeded, the first error is reported below
+    error = posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+    if (error == 0)
+        error = posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+
+    if (error == 0)
+        error = posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDERR_FILENO);
+
+    pid_t pid;
+
+    if (error == 0)
+        error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    close(pipe_fds[1]);
+
+    if (error != 0)
+    {
+        close(pipe_fds[0]);
+
+        result.errors = "Fehler: '" + args[0] + "' konnte nicht gestartet werden: " + std::strerror(error) + "\n";
+
+        return result;
+    }
+
+    char buffer[4096];
+
+    while (true)
+    {
+        const ssize_t count = read(pipe_fds[0], buffer, sizeof(buffer));
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count <= 0)
+            break;
+
+        result.errors.append(buffer, static_cast<size_t>(count));
+    }
+
+    close(pipe_fds[0]);
+
+    int status;
+
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+            return result;
+    }
+
+    if (WIFEXITED(status))
+        result.exit_code = WEXITSTATUS(status);
+
+    else if (WIFSIGNALED(status))
+        result.exit_code = 128 + WTERMSIG(status);
+
+    return result;
+}
+#else
+// Without posix_spawn the command still goes through the shell, with stdout and stderr captured in a scratch file
+inline ProcessResult run_process(const std::vector<std::string>& args)
+{
+    ProcessResult result;
+
+    const ScratchFile errors(".txt");
+
+    std::string command;
+
+    for (const std::string& arg : args)
+        command += "\"" + arg + "\" ";
+
+    command += "> \"" + errors.path() + "\" 2>&1";
+
+    // cmd.exe strips the outermost quotes of a command line that starts with one
+    result.exit_code = system(("\"" + command + "\"").c_str());
+    result.errors = errors.read().value_or("");
+
+    return result;
+}
+#endif
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "compiler.hpp"
+#include "line_index.hpp"
+#include "thread_pool.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Compile server protocol, one request after another on the same stream:
+ *
+ *   Request:  "COMPILE asm <n>\n" or "COMPILE obj <n>\n", followed by <n> bytes of DEnk source
+ *             "QUIT\n" ends the session
+ *   Response: "OK <n>\n" followed by <n> bytes of assembly or object code, or
+ *             "FEHLER <n>\n" followed by <n> bytes of diagnostics, one per line, each
+ *             prefixed with '<line>:<column>: ' when it has a location
+ *
+ * A source over MAX_REQUEST_SIZE is answered with "FEHLER" without reading it, which ends the session; so does a client
+ * that no longer reads its responses.
+ */
+static constexpr size_t MAX_REQUEST_SIZE = 256 * 1024 * 1024;  // 256 MiB
+
+inline void serve(std::istream& in, std::ostream& out, Compiler& compiler)
+{
+    std::string line;
+    std::string source;
+
+    while (out && std::getline(in, line))
+    {
+        if (line == "QUIT")
+            break;
+
+        std::istringstream request(line);
+        std::string command, kind;
+        size_t size = 0;
+
+        if (!(request >> command >> kind >> size) || command != "COMPILE" || (kind != "asm" && kind != "obj"))
+        {
+            const std::string message = "Fehler: Ungültige Anfrage '" + line + "'\n";
+
+            out << "FEHLER " << message.size() << "\n" << message << std::flush;
+
+            continue;
+        }
+
+        // The size comes from the client, so it must not decide how much memory the server takes
+        if (size > MAX_REQUEST_SIZE)
+        {
+            const std::string message = "Fehler: Der Quelltext ist größer als " + std::to_string(MAX_REQUEST_SIZE) + " Bytes\n";
+
+            out << "FEHLER " << message.size() << "\n" << message << std::flush;
+
+            break;
+        }
+
+        source.resize(size);
+
+        if (!in.read(source.data(), static_cast<std::streamsize>(size)))
+            break;
+
+        const CompileResult result = compiler.compile(source, { .assemble = kind == "obj" });
+
+        if (result.success)
+        {
+            const std::string& payload = kind == "obj" ? result.object : result.assembly;
+
+            out << "OK " << payload.size() << "\n" << payload << std::flush;
+        }
+        else
+        {
+            std::string message;
+            LineIndex lines(source);
+
+            for (const Diagnostic& diagnostic : result.diagnostics)
+            {
+                if (diagnostic.offset.has_value())
+                    message += lines.format(diagnostic.offset.value()) + ": ";
+
+                message += diagnostic.message + "\n";
+            }
+
+            out << "FEHLER " << message.size() << "\n" << message << std::flush;
+        }
+    }
+}
+
+#ifndef _WIN32
+/* Stream buffer over a socket, so 'serve' can talk to a client connection */
+class FdStreamBuf : public std::streambuf
+{
+    public:
+        explicit FdStreamBuf(const int fd)
+            : m_fd(fd)
+        {
+            setg(m_in, m_in, m_in);
+            setp(m_out, m_out + sizeof(m_out));
+        }
+
+        ~FdStreamBuf() override
+        {
+            sync();
+        }
+
+    protected:
+        int_type underflow() override
+        {
+            ssize_t count;
+
+            do
+                count = ::read(m_fd, m_in, sizeof(m_in));
+            while (count < 0 && errno == EINTR);
+
+            if (count <= 0)
+                return traits_type::eof();
+
+            setg(m_in, m_in, m_in + count);
+
+            return traits_type::to_int_type(*gptr());
+        }
+
+        int_type overflow(int_type ch) override
+        {
+            if (sync() != 0)
+                return traits_type::eof();
+
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+
+            return traits_type::not_eof(ch);
+        }
+
+        int sync() override
+        {
+            for (char* data = pbase(); data < pptr(); )
+            {
+                // A client that hung up raises EPIPE instead of SIGPIPE, which would end the whole server
+                const ssize_t count = ::send(m_fd, data, static_cast<size_t>(pptr() - data), MSG_NOSIGNAL);
+
+                if (count < 0 && errno == EINTR)
+                    continue;
+
+                if (count <= 0)
+                    return -1;
+
+                data += count;
+            }
+
+            setp(m_out, m_out + sizeof(m_out));
+
+            return 0;
+        }
+
+    private:
+        int m_fd;
+        char m_in[64 * 1024];
+        char m_out[64 * 1024];
+};
+
+// Accepts connections on a Unix domain socket and serves up to 'jobs' of them at once
+inline bool serve_socket(const std::string& path, const size_t jobs)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Fehler: Der Socket-Pfad ist zu lang" << std::endl;
+
+        return false;
+    }
+
+    path.copy(address.sun_path, path.size());
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    // A stale socket file from an earlier server would make 'bind' fail
+    unlink(path.c_str());
+
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+    {
+        std::cerr << "Fehler: Socket '" << path << "' konnte nicht geöffnet werden" << std::endl;
+
+        if (listener >= 0)
+            close(listener);
+
+        return false;
+    }
+
+    ThreadPool pool(jobs);
+
+    while (true)
+    {
+        const int client = accept(listener, nullptr, nullptr);
+
+        if (client < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        pool.submit([client]
+        {
+            // Every worker keeps one compiler, and with it a warm arena, for all of its connections
+            thread_local Compiler compiler;
+
+            {
+                FdStreamBuf buffer(client);
+                std::iostream stream(&buffer);
+
+                serve(stream, stream, compiler);
+            }
+
+            close(client);
+        });
+    }
+
+    close(listener);
+    unlink(path.c_str());
+
+    return true;
+}
+#endif
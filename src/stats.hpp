@@ -0,0 +1,242 @@
+#pragma once
+
+/*
+ * Per-phase compile statistics, only built with -DDENK_STATS (make STATS=1).
+ *
+ *   DENK_PHASE("name", label);     times the rest of the enclosing block as one phase
+ *   DENK_COUNT("counter", value);  attaches a counter to that phase
+ *
+ * Without DENK_STATS both macros expand to nothing and their arguments are never evaluated.
+ */
+#ifdef DENK_STATS
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Stats
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Event
+        {
+            std::string_view name;          // always a string literal
+            std::string label;              // usually the input file
+            size_t thread;
+            Clock::time_point start;
+            Clock::duration duration;
+            std::vector<std::pair<std::string_view, uint64_t>> counters;
+        };
+
+        static Stats& instance()
+        {
+            static Stats stats;
+
+            return stats;
+        }
+
+        // Small sequential ids read better in trace viewers than hashed std::thread::ids
+        static size_t thread_id()
+        {
+            static std::atomic<size_t> next = 1;
+            thread_local const size_t id = next++;
+
+            return id;
+        }
+
+        void record(Event event)
+        {
+            std::lock_guard lock(m_mutex);
+
+            m_events.push_back(std::move(event));
+        }
+
+        // Sums every phase over all inputs, in the order the phases first appeared
+        void print_table(std::ostream& out) const
+        {
+            struct Row
+            {
+                size_t count = 0;
+                Clock::duration total {};
+                Clock::duration max {};
+                std::map<std::string_view, uint64_t> counters;
+            };
+
+            std::vector<std::string_view> order;
+            std::map<std::string_view, Row> rows;
+
+            {
+                std::lock_guard lock(m_mutex);
+
+                for (const Event& event : m_events)
+                {
+                    if (!rows.contains(event.name))
+                        order.push_back(event.name);
+
+                    Row& row = rows[event.name];
+
+                    row.count++;
+                    row.total += event.duration;
+                    row.max = std::max(row.max, event.duration);
+
+                    for (const auto& [counter, value] : event.counters)
+                    {
+                        // High-water marks do not add up across inputs
+                        if (counter.ends_with("_max"))
+                            row.counters[counter] = std::max(row.counters[counter], value);
+                        else
+                            row.counters[counter] += value;
+                    }
+                }
+            }
+
+            out << std::left << std::setw(12) << "Phase"
+                << std::right << std::setw(8) << "Anzahl" << std::setw(14) << "Gesamt (ms)" << std::setw(14) << "Max (ms)"
+                << "  Zähler\n";
+
+            for (const std::string_view name : order)
+            {
+                const Row& row = rows.at(name);
+
+                out << std::left << std::setw(12) << name
+                    << std::right << std::setw(8) << row.count
+                    << std::fixed << std::setprecision(3)
+                    << std::setw(14) << milliseconds(row.total) << std::setw(14) << milliseconds(row.max) << " ";
+
+                for (const auto& [counter, value] : row.counters)
+                    out << " " << counter << "=" << value;
+
+                out << "\n";
+            }
+
+            out << std::flush;
+        }
+
+        // Chrome trace-event format, viewable in chrome://tracing or Perfetto
+        bool write_trace(const std::string& path) const
+        {
+            std::ofstream out(path, std::ios::binary);
+
+            if (!out)
+                return false;
+
+            std::lock_guard lock(m_mutex);
+
+            out << "{\"traceEvents\":[";
+
+            for (size_t i = 0; i < m_events.size(); i++)
+            {
+                const Event& event = m_events[i];
+
+                out << (i == 0 ? "\n" : ",\n")
+                    << "{\"name\":\"" << event.name << "\",\"cat\":\"denk\",\"ph\":\"X\",\"pid\":1"
+                    << ",\"tid\":" << event.thread
+                    << ",\"ts\":" << microseconds(event.start - s_epoch)
+                    << ",\"dur\":" << microseconds(event.duration)
+                    << ",\"args\":{\"file\":\"" << escape(event.label) << "\"";
+
+                for (const auto& [counter, value] : event.counters)
+                    out << ",\"" << counter << "\":" << value;
+
+                out << "}}";
+            }
+
+            out << "\n]}\n";
+
+            return static_cast<bool>(out);
+        }
+
+    private:
+        Stats() = default;
+
+        static double milliseconds(const Clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        static int64_t microseconds(const Clock::duration duration)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        }
+
+        static std::string escape(std::string_view text)
+        {
+            static constexpr char digits[] = "0123456789abcdef";
+
+            std::string escaped;
+
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    escaped += '\\';
+                    escaped += c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    escaped += "\\u00";
+                    escaped += digits[(c >> 4) & 0xF];
+                    escaped += digits[c & 0xF];
+                }
+                else
+                    escaped += c;
+            }
+
+            return escaped;
+        }
+
+        mutable std::mutex m_mutex;
+        std::vector<Stats::Event> m_events;
+
+        // Initialized at startup, so trace timestamps count from program start
+        static inline const Clock::time_point s_epoch = Clock::now();
+};
+
+/* Records the lifetime of one phase, also when it ends with an exception */
+class PhaseTimer
+{
+    public:
+        PhaseTimer(const std::string_view name, const std::string_view label)
+            : m_event{ name, std::string(label), Stats::thread_id(), Stats::Clock::now(), {}, {} }
+        {
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+        ~PhaseTimer()
+        {
+            m_event.duration = Stats::Clock::now() - m_event.start;
+
+            Stats::instance().record(std::move(m_event));
+        }
+
+        void count(const std::string_view counter, const uint64_t value)
+        {
+            m_event.counters.emplace_back(counter, value);
+        }
+
+    private:
+        Stats::Event m_event;
+};
+
+#define DENK_PHASE(name, label) PhaseTimer denk_phase_timer(name, label)
+#define DENK_COUNT(counter, value) denk_phase_timer.count(counter, static_cast<uint64_t>(value))
+
+#else
+
+#define DENK_PHASE(name, label) ((void) 0)
+#define DENK_COUNT(counter, value) ((void) 0)
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class ThreadPool
+{
+    public:
+        explicit ThreadPool(const size_t num_threads)
+        {
+            const size_t count = std::max<size_t>(num_threads, 1);
+
+            for (size_t i = 0; i < count; i++)
+                m_queues.push_back(std::make_unique<Queue>());
+
+            for (size_t i = 0; i < count; i++)
+                m_threads.emplace_back([this, i] { run(i); });
+        }
+
+        // Disable copy semantics, the workers hold a pointer to the pool
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(m_mutex);
+
+                m_stop = true;
+            }
+
+            m_wake.notify_all();
+
+            for (std::thread& thread : m_threads)
+                thread.join();
+        }
+
+        // Tasks submitted from a worker go to its own queue, others are spread round-robin
+        void submit(std::function<void()> task)
+        {
+            m_pending++;
+
+            const size_t index = t_worker_index < m_queues.size() && t_pool == this
+                               ? t_worker_index
+                               : m_next++ % m_queues.size();
+
+            {
+                std::lock_guard lock(m_queues[index]->mutex);
+
+                m_queues[index]->tasks.push_back(std::move(task));
+            }
+
+            {
+                std::lock_guard lock(m_mutex);
+
+                m_queued++;
+            }
+
+            m_wake.notify_one();
+        }
+
+        // Blocks until every submitted task, including tasks submitted by tasks, has finished
+        void wait()
+        {
+            std::unique_lock lock(m_mutex);
+
+            m_done.wait(lock, [&] { return m_pending == 0; });
+
+            if (m_error)
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+
+        size_t size() const
+        {
+            return m_threads.size();
+        }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        // A worker takes the newest task from its own queue (cache-warm) and steals the oldest from others
+        bool try_take(const size_t index, std::function<void()>& task)
+        {
+            for (size_t i = 0; i < m_queues.size(); i++)
+            {
+                Queue& queue = *m_queues[(index + i) % m_queues.size()];
+
+                std::lock_guard lock(queue.mutex);
+
+                if (queue.tasks.empty())
+                    continue;
+
+                if (i == 0)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+
+                m_queued--;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        void run(const size_t index)
+        {
+            t_worker_index = index;
+            t_pool = this;
+
+            while (true)
+            {
+                std::function<void()> task;
+
+                if (!try_take(index, task))
+                {
+                    std::unique_lock lock(m_mutex);
+
+                    m_wake.wait(lock, [&] { return m_stop || m_queued > 0; });
+
+                    if (m_stop && m_queued == 0)
+                        return;
+
+                    continue;
+                }
+
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(m_mutex);
+
+                    if (!m_error)
+                        m_error = std::current_exception();
+                }
+
+                if (--m_pending == 0)
+                {
+                    std::lock_guard lock(m_mutex);
+
+                    m_done.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+
+        std::atomic<size_t> m_pending = 0;  // submitted but not yet finished
+        std::atomic<size_t> m_queued = 0;   // submitted but not yet taken
+        std::atomic<size_t> m_next = 0;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake, m_done;
+        std::exception_ptr m_error;
+        bool m_stop = false;
+
+        static inline thread_local size_t t_worker_index = SIZE_MAX;
+        static inline thread_local const ThreadPool* t_pool = nullptr;
+};
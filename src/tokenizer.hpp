@@ -1,34 +1,50 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <vector>
 #include <optional>
 #include <fstream>
+#include <iterator>
 #include <unordered_map>
+#include <string_view>
+#include <utility>
+
+#include "diagnostics.hpp"
 
 enum class TokenType
 {
     ident, int_lit, 
-    dot, plus, minus, star, slash, 
-    open_paren, close_paren, open_curly, close_curly, 
-    Bestimme, als, 
+    dot, comma, plus, minus, star, slash, 
+    open_paren, close_paren, open_curly, close_curly, open_square, close_square, 
+    Bestimme, als, Feld, 
     Ändere, zu, 
-    Falls, Sonst, dann, gleich, ungleich, kleiner, größer, und, oder, nicht, 
+    Falls, Sonst, dann, wahrscheinlich, unwahrscheinlich, gleich, ungleich, kleiner, größer, und, oder, nicht, 
+    Solange, 
     Beende, mit, 
+    Schreibe, Lies, 
+    Funktion, Gib, zurück, 
 };
 
-inline std::optional<size_t>bin_prec(const TokenType type)
+constexpr std::optional<size_t> bin_prec(const TokenType type)
 {
     switch (type)
     {
+        case TokenType::gleich:
+        case TokenType::ungleich:
+        case TokenType::kleiner:
+        case TokenType::größer:
+            return 0;
+
         case TokenType::plus:
         case TokenType::minus:
-            return 0;
+            return 1;
 
         case TokenType::star:
         case TokenType::slash:
-            return 1;
+            return 2;
         
         default:
             return std::nullopt;
@@ -39,42 +55,164 @@ struct Token
 {
     TokenType type;
     std::optional<std::string> value {};
+    uint32_t offset = 0;    // byte offset of the token's first character in the source
 };
 
+/* Keywords, in both spellings; shared with the constexpr front end */
+inline constexpr std::pair<std::string_view, TokenType> KEYWORDS[] = {
+    {"Bestimme", TokenType::Bestimme}, {"bestimme", TokenType::Bestimme}, 
+    {"als", TokenType::als}, {"Als", TokenType::als}, 
+    {"Feld", TokenType::Feld}, {"feld", TokenType::Feld}, 
+    
+    {"Ändere", TokenType::Ändere}, {"ändere", TokenType::Ändere}, 
+    {"zu", TokenType::zu}, {"Zu", TokenType::zu}, 
+    
+    {"Falls", TokenType::Falls}, {"falls", TokenType::Falls}, 
+    {"Sonst", TokenType::Sonst}, {"sonst", TokenType::Sonst}, 
+    {"dann", TokenType::dann}, {"Dann", TokenType::dann}, 
+    {"wahrscheinlich", TokenType::wahrscheinlich}, {"Wahrscheinlich", TokenType::wahrscheinlich}, 
+    {"unwahrscheinlich", TokenType::unwahrscheinlich}, {"Unwahrscheinlich", TokenType::unwahrscheinlich}, 
+
+    {"gleich", TokenType::gleich}, {"Gleich", TokenType::gleich}, 
+    {"ungleich", TokenType::ungleich}, {"Ungleich", TokenType::ungleich}, 
+    {"kleiner", TokenType::kleiner}, {"Kleiner", TokenType::kleiner}, 
+    {"größer", TokenType::größer}, {"Größer", TokenType::größer}, 
+    {"und", TokenType::und}, {"Und", TokenType::und}, 
+    {"oder", TokenType::oder}, {"Oder", TokenType::oder}, 
+    {"nicht", TokenType::nicht}, {"Nicht", TokenType::nicht}, 
+
+    {"Solange", TokenType::Solange}, {"solange", TokenType::Solange}, 
+
+    {"Beende", TokenType::Beende}, {"beende", TokenType::Beende}, 
+    {"mit", TokenType::mit}, {"Mit", TokenType::mit}, 
+
+    {"Schreibe", TokenType::Schreibe}, {"schreibe", TokenType::Schreibe}, 
+    {"Lies", TokenType::Lies}, {"lies", TokenType::Lies},
+
+    {"Funktion", TokenType::Funktion}, {"funktion", TokenType::Funktion}, 
+    {"Gib", TokenType::Gib}, {"gib", TokenType::Gib}, 
+    {"zurück", TokenType::zurück}, {"Zurück", TokenType::zurück},
+};
+
+/* Character Classes */
+constexpr bool is_alpha(const char32_t c)
+{
+    return (c >= U'a' && c <= U'z') || 
+           (c >= U'A' && c <= U'Z') ||
+           (c >= 0x00C0 && c <= 0x00FF) || // Latin-1 (includes ß, ä, ö, ü, é, etc.)
+           (c >= 0x0100 && c <= 0x017F) || // Latin Extended-A
+           (c >= 0x0180 && c <= 0x024F);   // Latin Extended-B
+}
+
+constexpr bool is_digit(const char32_t c)
+{
+    return (c >= U'0' && c <= U'9');
+}
+
+constexpr bool is_alnum(const char32_t c)
+{
+    return is_alpha(c) || is_digit(c);
+}
+
+constexpr bool is_space(const char32_t c)
+{
+    return (c == U' ' || c == U'\n' || c == U'\r' || c == U'\t');
+}
+
+// Bytes of the UTF-8 sequence that starts with 'first', 1 for anything that does not start one
+constexpr size_t utf8_length(const unsigned char first)
+{
+    if ((first >> 5) == 0x06)
+        return 2;
+
+    if ((first >> 4) == 0x0E)
+        return 3;
+
+    if ((first >> 3) == 0x1E)
+        return 4;
+
+    return 1;
+}
+
+// Code point at byte 'index' of 'src', nothing at the end or for a truncated sequence
+constexpr std::optional<char32_t> decode_utf8(const std::string_view src, const size_t index)
+{
+    if (index >= src.size())
+        return std::nullopt;
+
+    const unsigned char first = src[index];
+
+    if (first < 0x80)
+        return first;
+
+    if ((first >> 5) == 0x06 && index + 1 < src.size())
+        return ((first & 0x1F) << 6) | (src[index + 1] & 0x3F);
+
+    if ((first >> 4) == 0x0E && index + 2 < src.size())
+        return ((first & 0x0F) << 12) | ((src[index + 1] & 0x3F) << 6)
+             | (src[index + 2] & 0x3F);
+
+    if ((first >> 3) == 0x1E && index + 3 < src.size())
+        return ((first & 0x07) << 18) | ((src[index + 1] & 0x3F) << 12)
+             | ((src[index + 2] & 0x3F) << 6)
+             | (src[index + 3] & 0x3F);
+
+    return std::nullopt;
+}
+
 class Tokenizer
 {
     public:
-        explicit Tokenizer(const std::string& src) : m_src(src) {}
+        explicit Tokenizer(std::string_view src) : m_src(src) {}
 
         std::vector<Token> tokenize()
         {
-            static const std::unordered_map<std::string, TokenType> keywords = {
-                {"Bestimme", TokenType::Bestimme}, {"bestimme", TokenType::Bestimme}, 
-                {"als", TokenType::als}, {"Als", TokenType::als}, 
-                
-                {"Ändere", TokenType::Ändere}, {"ändere", TokenType::Ändere}, 
-                {"zu", TokenType::zu}, {"Zu", TokenType::zu}, 
-                
-                {"Falls", TokenType::Falls}, {"falls", TokenType::Falls}, 
-                {"Sonst", TokenType::Sonst}, {"sonst", TokenType::Sonst}, 
-                {"dann", TokenType::dann}, {"Dann", TokenType::dann}, 
-
-                {"gleich", TokenType::gleich}, {"Gleich", TokenType::gleich}, 
-                {"ungleich", TokenType::ungleich}, {"Ungleich", TokenType::ungleich}, 
-                {"kleiner", TokenType::kleiner}, {"Kleiner", TokenType::kleiner}, 
-                {"größer", TokenType::größer}, {"Größer", TokenType::größer}, 
-                {"und", TokenType::und}, {"Und", TokenType::und}, 
-                {"oder", TokenType::oder}, {"Oder", TokenType::oder}, 
-                {"nicht", TokenType::nicht}, {"Nicht", TokenType::nicht}, 
-
-                {"Beende", TokenType::Beende}, {"beende", TokenType::Beende}, 
-                {"mit", TokenType::mit}, {"Mit", TokenType::mit}, 
-            };
+            return lex(nullptr, [](size_t) { return false; }, nullptr);
+        }
+
+        // Lexes one chunk of a larger source, which may end inside a block comment instead of failing;
+        // 'open_comment' then receives where that comment starts
+        std::vector<Token> tokenize_chunk(std::optional<uint32_t>& open_comment)
+        {
+            open_comment = std::nullopt;
+
+            return lex(&open_comment, [](size_t) { return false; }, nullptr);
+        }
+
+        // Lexes from byte 'start' up to the first position between two tokens that 'at_boundary' accepts; 'end' receives
+        // that position, or the size of the source if there was none. Used to re-lex only the edited part of a source.
+        template <typename AtBoundary>
+        std::vector<Token> tokenize_from(const size_t start, AtBoundary&& at_boundary, size_t& end)
+        {
+            m_index = start;
+
+            return lex(nullptr, at_boundary, &end);
+        }
+
+    private:
+        template <typename AtBoundary>
+        std::vector<Token> lex(std::optional<uint32_t>* open_comment, AtBoundary&& at_boundary, size_t* end)
+        {
+            static const std::unordered_map<std::string, TokenType> keywords(std::begin(KEYWORDS), std::end(KEYWORDS));
+
+            if (m_src.size() > std::numeric_limits<uint32_t>::max())
+                compile_error("Fehler: Quelltexte über 4 GiB werden nicht unterstützt");
 
             std::vector<Token> tokens;
+            size_t stop = m_src.size();
 
             while (peek().has_value())
             {
+                if (at_boundary(m_index))
+                {
+                    stop = m_index;
+
+                    break;
+                }
+
+                const size_t start = m_index;
+                const size_t count = tokens.size();
+
                 char32_t ch = peek().value();
 
                 if (is_alpha(ch))
@@ -105,6 +243,9 @@ class Tokenizer
                     if (one_char == ".")
                         tokens.push_back({ .type = TokenType::dot });
                     
+                    else if (one_char == ",")
+                        tokens.push_back({ .type = TokenType::comma });
+                    
                     else if (one_char == "+")
                         tokens.push_back({ .type = TokenType::plus });
                     
@@ -116,14 +257,13 @@ class Tokenizer
                     
                     else if (one_char == "/")
                     {
-                        if (peek().has_value())
+                        if (peek().has_value() && (peek().value() == U'/' || peek().value() == U'*'))
                         {
                             if (peek().value() == U'/')
                                 consume_while([&](char32_t c) { return c != U'\n'; });
 
                             else if (peek().value() == U'*')
                             {
-                                consume(); // consume '/'
                                 consume(); // consume '*'
 
                                 while (true)
@@ -132,9 +272,12 @@ class Tokenizer
                                 
                                     if (!peek().has_value())
                                     {
-                                        std::cerr << "Fehler: Mehrzeiliger Kommentar wurde nicht korrekt geschlossen (erwartetes '*/')\n";
+                                        if (open_comment == nullptr)
+                                            compile_error_at(static_cast<uint32_t>(start), "Fehler: Mehrzeiliger Kommentar wurde nicht korrekt geschlossen (erwartetes '*/')");
 
-                                        exit(EXIT_FAILURE);
+                                        *open_comment = static_cast<uint32_t>(start);
+
+                                        break;
                                     }
                                 
                                     if (peek().value() == U'*')
@@ -166,21 +309,30 @@ class Tokenizer
                     else if (one_char == "}")
                         tokens.push_back({ .type = TokenType::close_curly });
                     
+                    else if (one_char == "[")
+                        tokens.push_back({ .type = TokenType::open_square });
+                    
+                    else if (one_char == "]")
+                        tokens.push_back({ .type = TokenType::close_square });
+                    
                     else
                     {
-                        std::cerr << "Fehler: Ein Syntaxfehler ist aufgetreten\n";
-
-                        exit(EXIT_FAILURE);
+                        compile_error_at(static_cast<uint32_t>(start), "Fehler: Ein Syntaxfehler ist aufgetreten");
                     }
                 }
+
+                if (tokens.size() != count)
+                    tokens.back().offset = static_cast<uint32_t>(start);
             }
 
+            if (end != nullptr)
+                *end = stop;
+
             m_index = 0;
 
             return tokens;
         }
 
-    private:
         template <typename Predicate>
         std::string consume_while(Predicate pred)
         {
@@ -194,29 +346,7 @@ class Tokenizer
 
         std::optional<char32_t> peek(const size_t& offset = 0) const
         {
-            size_t peek_index = m_index + offset;
-            
-            if (peek_index >= m_src.size())
-                return std::nullopt;
-
-            unsigned char first = m_src[peek_index];
-
-            if (first < 0x80)
-                return first;
-
-            if ((first >> 5) == 0x06 && peek_index + 1 < m_src.size())
-                return ((first & 0x1F) << 6) | (m_src[peek_index + 1] & 0x3F);
-
-            if ((first >> 4) == 0x0E && peek_index + 2 < m_src.size())
-                return ((first & 0x0F) << 12) | ((m_src[peek_index + 1] & 0x3F) << 6)
-                     | (m_src[peek_index + 2] & 0x3F);
-
-            if ((first >> 3) == 0x1E && peek_index + 3 < m_src.size())
-                return ((first & 0x07) << 18) | ((m_src[peek_index + 1] & 0x3F) << 12)
-                     | ((m_src[peek_index + 2] & 0x3F) << 6)
-                     | (m_src[peek_index + 3] & 0x3F);
-
-            return std::nullopt;
+            return decode_utf8(m_src, m_index + offset);
         }
 
         std::string consume()
@@ -224,52 +354,15 @@ class Tokenizer
             if (m_index >= m_src.size())
                 return "";
 
-            unsigned char first = m_src[m_index];
-            size_t len = 1;
+            const size_t len = utf8_length(m_src[m_index]);
 
-            if (first < 0x80)
-                len = 1;
-            
-            else if ((first >> 5) == 0x06)
-                len = 2;
-            
-            else if ((first >> 4) == 0x0E)
-                len = 3;
-            
-            else if ((first >> 3) == 0x1E)
-                len = 4;
-
-            std::string result = m_src.substr(m_index, len);
+            std::string result(m_src.substr(m_index, len));
 
             m_index += len;
 
             return result;
         }
 
-        inline bool is_alpha(char32_t c) const
-        {
-            return (c >= U'a' && c <= U'z') || 
-                   (c >= U'A' && c <= U'Z') ||
-                   (c >= 0x00C0 && c <= 0x00FF) || // Latin-1 (includes ß, ä, ö, ü, é, etc.)
-                   (c >= 0x0100 && c <= 0x017F) || // Latin Extended-A
-                   (c >= 0x0180 && c <= 0x024F);   // Latin Extended-B
-        }
-
-        inline bool is_alnum(char32_t c) const
-        {
-            return is_alpha(c) || is_digit(c);
-        }
-
-        inline bool is_digit(char32_t c) const
-        {
-            return (c >= U'0' && c <= U'9');
-        }
-
-        inline bool is_space(char32_t c) const
-        {
-            return (c == U' ' || c == U'\n' || c == U'\r' || c == U'\t');
-        }
-
-        const std::string m_src;
+        const std::string_view m_src;   // not owned, the caller keeps the source alive while tokenizing
         size_t m_index = 0;
 };
\ No newline at end of file
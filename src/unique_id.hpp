@@ -0,0 +1,14 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+// Distinguishes temporary files of concurrent writers, both threads and processes
+inline uint64_t unique_id()
+{
+    static const uint64_t process_id = [] { std::random_device rd; return (uint64_t{ rd() } << 32) | rd(); }();
+    static std::atomic<uint64_t> counter = 0;
+
+    return process_id ^ counter++;
+}
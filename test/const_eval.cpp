@@ -0,0 +1,96 @@
+#include "const_eval.hpp"
+
+/*
+ * Compile-time checks of the constexpr front end; 'make check' only has to compile this file, every check is a
+ * static_assert.
+ */
+
+/* The example of the header */
+constexpr auto rules = const_parse(R"(Bestimme x als 0. Lies x. Beende mit x * 2.)");
+
+static_assert(rules.has_value());
+
+constexpr auto doubled = rules->tabulate<16>();
+
+static_assert(doubled.has_value() && (*doubled)[0] == 0 && (*doubled)[7] == 14 && (*doubled)[15] == 30);
+
+/* Loops and output */
+constexpr auto sum = const_parse(R"(
+    Bestimme N als 100.
+    Bestimme S als 0.
+    Bestimme I als 0.
+    Bestimme K als 3.
+    Solange (I kleiner N) dann {
+        Ändere S zu S + I * (K + 2) / 5.
+        Ändere I zu I + 1.
+    }
+    Beende mit S / 100.
+)");
+
+static_assert(sum.has_value() && sum->run()->result == 49);
+
+constexpr auto count = const_parse(R"(
+    Bestimme I als 0.
+    Solange (I kleiner 5) dann {
+        Falls (I gleich 2) dann { Schreibe 20. } Sonst { Schreibe I. }
+        Ändere I zu I + 1.
+    }
+)");
+
+constexpr auto written = count->run<8>();
+
+static_assert(written.has_value() && written->result == 0 && written->output_count == 5);
+static_assert(written->output[0] == 0 && written->output[1] == 1 && written->output[2] == 20 && written->output[4] == 4);
+
+/* Arrays, element-wise and by index */
+constexpr auto arrays = const_parse(R"(
+    Bestimme A als Feld[4].
+    Bestimme B als Feld[4].
+    Bestimme I als 0.
+    Solange (I kleiner 4) dann {
+        Ändere A[I] zu I + 1.
+        Ändere I zu I + 1.
+    }
+    Ändere B zu A * A.
+    Ändere B zu B - 1.
+    Beende mit B[0] + B[1] + B[2] + B[3].
+)");
+
+static_assert(arrays.has_value() && arrays->run()->result == 26);
+
+/* Arithmetic wraps around like in the compiled program */
+constexpr auto wrapped = const_parse(R"(Bestimme X als 9223372036854775807. Beende mit X + 1 - X.)");
+
+static_assert(wrapped.has_value() && wrapped->run()->result == 1);
+
+/* An index out of range ends the program with 255 like the bounds check, whether it is read or written */
+constexpr auto read_outside = const_parse(R"(Bestimme A als Feld[4]. Bestimme I als 0. Lies I. Beende mit A[I].)");
+
+static_assert(read_outside.has_value());
+
+constexpr int64_t four[] = { 4 };
+constexpr int64_t minus_one[] = { -1 };
+constexpr int64_t three[] = { 3 };
+
+static_assert(read_outside->run(four)->result == 255);
+static_assert(read_outside->run(minus_one)->result == 255);
+static_assert(read_outside->run(three)->result == 0);
+
+constexpr auto write_outside = const_parse(R"(Bestimme A als Feld[4]. Bestimme I als 5. Ändere A[I] zu 1. Beende mit 3.)");
+
+static_assert(write_outside.has_value() && write_outside->run()->result == 255);
+
+/* Errors come back as values */
+static_assert(!const_parse(R"(Beende mit Y.)").has_value());
+static_assert(!const_parse(R"(Bestimme A als Feld[4]. Beende mit A.)").has_value());
+
+constexpr auto endless = const_parse(R"(Bestimme I als 0. Solange (I kleiner 1) dann { Ändere I zu 0. })");
+
+static_assert(endless.has_value() && !endless->run().has_value());
+
+constexpr auto by_zero = const_parse(R"(Bestimme Z als 0. Beende mit 1 / Z.)");
+
+static_assert(by_zero.has_value() && !by_zero->run().has_value());
+
+/* 'Funktion' and 'Gib' are left to the compiler */
+static_assert(!const_parse(R"(Funktion F() { Gib 1 zurück. } Beende mit F().)").has_value());
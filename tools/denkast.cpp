@@ -0,0 +1,174 @@
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "ast_file.hpp"
+
+/*
+ * Prints a tree written by '--emit-ast', read straight from the mapped file:
+ *
+ *   denkast Programm.dast
+ *
+ * One statement per line, nested scopes indented, followed by the node and string counts.
+ */
+static std::string format_node(const AstView& ast, const AstNode& node)
+{
+    static constexpr const char* bin_ops[] = { " + ", " - ", " * ", " / " };
+    static constexpr const char* logic_ops[] = { " ungleich ", " gleich ", " kleiner ", " kleiner gleich ", " größer ", " größer gleich " };
+
+    switch (node.kind)
+    {
+        case AstKind::IntLit:
+        case AstKind::Ident:
+            return std::string(ast.text(node.text));
+
+        case AstKind::Index:
+            return std::string(ast.text(node.text)).append("[").append(format_node(ast, *node.index())).append("]");
+
+        case AstKind::Paren:
+            return std::string("(").append(format_node(ast, *node.expr())).append(")");
+
+        case AstKind::BinExpr:
+            return format_node(ast, *node.lhs()) + bin_ops[node.op] + format_node(ast, *node.rhs());
+
+        case AstKind::LogicExpr:
+            return format_node(ast, *node.lhs()) + logic_ops[node.op] + format_node(ast, *node.rhs());
+
+        case AstKind::Call:
+        {
+            std::string text = std::string(ast.text(node.text)).append("(");
+
+            for (uint32_t i = 0; i < node.args().size(); i++)
+                text.append(i > 0 ? ", " : "").append(format_node(ast, node.args()[i]));
+
+            return text.append(")");
+        }
+
+        default:
+            return "?";
+    }
+}
+
+static void print_stmt(const AstView& ast, const AstNode& stmt, const size_t depth)
+{
+    const std::string indent(depth * 4, ' ');
+
+    switch (stmt.kind)
+    {
+        case AstKind::Scope:
+        {
+            std::cout << indent << "{\n";
+
+            for (uint32_t i = 0; i < stmt.stmts().size(); i++)
+                print_stmt(ast, stmt.stmts()[i], depth + 1);
+
+            std::cout << indent << "}\n";
+
+            break;
+        }
+
+        case AstKind::Bestimme:
+            std::cout << indent << "Bestimme " << ast.text(stmt.text) << " als "
+                      << (stmt.expr() != nullptr ? format_node(ast, *stmt.expr()) : std::string("Feld[").append(std::to_string(stmt.length)).append("]")) << ".\n";
+            break;
+
+        case AstKind::Ändere:
+            std::cout << indent << "Ändere " << ast.text(stmt.text)
+                      << (stmt.index() != nullptr ? std::string("[").append(format_node(ast, *stmt.index())).append("]") : "")
+                      << " zu " << format_node(ast, *stmt.expr()) << ".\n";
+            break;
+
+        case AstKind::Falls:
+            std::cout << indent << "Falls (" << format_node(ast, *stmt.expr()) << ")" << hint_text(static_cast<BranchHint>(stmt.op))
+                      << " dann\n";
+
+            print_stmt(ast, *stmt.scope(), depth);
+
+            if (stmt.sonst() != nullptr)
+            {
+                std::cout << indent << "Sonst\n";
+
+                print_stmt(ast, *stmt.sonst(), depth);
+            }
+
+            break;
+
+        case AstKind::Solange:
+            std::cout << indent << "Solange (" << format_node(ast, *stmt.expr()) << ") dann\n";
+
+            print_stmt(ast, *stmt.scope(), depth);
+
+            break;
+
+        case AstKind::Beende:
+            std::cout << indent << "Beende mit " << format_node(ast, *stmt.expr()) << ".\n";
+            break;
+
+        case AstKind::Schreibe:
+            std::cout << indent << "Schreibe " << format_node(ast, *stmt.expr()) << ".\n";
+            break;
+
+        case AstKind::Lies:
+            std::cout << indent << "Lies " << ast.text(stmt.text) << ".\n";
+            break;
+
+        case AstKind::Funktion:
+        {
+            std::cout << indent << "Funktion " << ast.text(stmt.text) << "(";
+
+            for (uint32_t i = 0; i < stmt.params().size(); i++)
+                std::cout << (i > 0 ? ", " : "") << ast.text(stmt.params()[i].text);
+
+            std::cout << ")\n";
+
+            print_stmt(ast, *stmt.scope(), depth);
+
+            break;
+        }
+
+        case AstKind::Gib:
+            std::cout << indent << "Gib " << format_node(ast, *stmt.expr()) << " zurück.\n";
+            break;
+
+        default:
+            std::cout << indent << "?\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Verwendung: denkast Programm.dast" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<MappedFile> file = MappedFile::open(argv[1]);
+
+    if (!file.has_value())
+    {
+        std::cerr << "Fehler: Die Datei '" << argv[1] << "' konnte nicht geöffnet werden" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    const std::optional<AstView> ast = AstView::open(file->bytes());
+
+    if (!ast.has_value())
+    {
+        std::cerr << "Fehler: '" << argv[1] << "' ist keine AST-Datei der Version " << AST_VERSION << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < ast->program().size(); i++)
+        print_stmt(ast.value(), ast->program()[i], 0);
+
+    std::cout << "; " << ast->program().size() << " Anweisungen, " << ast->nodes() << " Knoten, "
+              << ast->string_count() << " Zeichenketten, " << file->bytes().size() << " Bytes\n";
+
+    return EXIT_SUCCESS;
+}
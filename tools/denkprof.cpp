@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Hot-spot report for programs built with '--profile-gen':
+ *
+ *   denkprof [--top N] Programm.profmap Programm.prof
+ *
+ * The map comes from the compiler, the counters from running the program.
+ */
+struct Row
+{
+    std::string path;
+    std::string text;
+
+    uint64_t count = 0;
+    std::optional<uint64_t> then;       // 'Falls' only
+    std::optional<uint64_t> loop;       // 'Solange' only
+    std::optional<int64_t> cycles;      // top-level statements only, negative if the program ended inside
+};
+
+static constexpr std::string_view PROFILE_MAGIC = "DENKPROF";
+static constexpr int PROFILE_VERSION = 1;
+
+static bool read_map(const std::string& path, std::vector<std::pair<std::string, size_t>>& counters, std::vector<Row>& rows)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string line;
+
+    int version = 0;
+    size_t count = 0;
+
+    if (!std::getline(file, line) || std::sscanf(line.c_str(), "DEnk-Profil\t%d\t%zu", &version, &count) != 2 || version != PROFILE_VERSION)
+    {
+        std::cerr << "Fehler: '" << path << "' ist keine DEnk-Profilbeschreibung (Version " << PROFILE_VERSION << ")" << std::endl;
+
+        return false;
+    }
+
+    std::map<std::string, size_t> row_of_path;
+
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string index, kind, stmt_path, text;
+
+        if (!std::getline(fields, index, '\t') || !std::getline(fields, kind, '\t') || !std::getline(fields, stmt_path, '\t'))
+            continue;
+
+        std::getline(fields, text);
+
+        const auto [it, inserted] = row_of_path.try_emplace(stmt_path, rows.size());
+
+        if (inserted)
+            rows.push_back({ .path = stmt_path, .text = text, .count = 0, .then = std::nullopt, .loop = std::nullopt, .cycles = std::nullopt });
+
+        counters.emplace_back(kind, it->second);
+    }
+
+    if (counters.size() != count)
+    {
+        std::cerr << "Fehler: '" << path << "' ist unvollständig" << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+static bool read_counters(const std::string& path, const std::vector<std::pair<std::string, size_t>>& counters, std::vector<Row>& rows)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    char magic[8];
+    uint64_t count = 0;
+
+    if (!file.read(magic, sizeof(magic)) || std::string_view(magic, sizeof(magic)) != PROFILE_MAGIC
+        || !file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        std::cerr << "Fehler: '" << path << "' ist keine DEnk-Profildatei" << std::endl;
+
+        return false;
+    }
+
+    // An empty program still reserves one counter
+    if (count != std::max<size_t>(counters.size(), 1))
+    {
+        std::cerr << "Fehler: '" << path << "' passt nicht zur Profilbeschreibung" << std::endl;
+
+        return false;
+    }
+
+    for (const auto& [kind, row] : counters)
+    {
+        uint64_t value;
+
+        if (!file.read(reinterpret_cast<char*>(&value), sizeof(value)))
+        {
+            std::cerr << "Fehler: '" << path << "' ist unvollständig" << std::endl;
+
+            return false;
+        }
+
+        if (kind == "Anweisung")
+            rows[row].count = value;
+
+        else if (kind == "dann")
+            rows[row].then = value;
+
+        else if (kind == "Durchlauf")
+            rows[row].loop = value;
+
+        else if (kind == "Zyklen")
+            rows[row].cycles = static_cast<int64_t>(value);
+    }
+
+    return true;
+}
+
+static void print_report(std::vector<Row> rows, const size_t top)
+{
+    const auto shorten = [](const std::string& text)
+    {
+        return text.size() > 60 ? text.substr(0, 57) + "..." : text;
+    };
+
+    int64_t total_cycles = 0;
+
+    for (const Row& row : rows)
+        if (row.cycles.has_value() && row.cycles.value() > 0)
+            total_cycles += row.cycles.value();
+
+    std::ranges::stable_sort(rows, std::greater{}, [](const Row& row) { return row.cycles.value_or(std::numeric_limits<int64_t>::min()); });
+
+    std::cout << "Zeit je Anweisung der obersten Ebene:\n";
+    std::cout << std::right << std::setw(16) << "Zyklen" << std::setw(9) << "Anteil" << "  " << std::left << std::setw(10) << "Pfad" << "Anweisung\n";
+
+    for (size_t i = 0; i < std::min(top, rows.size()) && rows[i].cycles.has_value(); i++)
+    {
+        const Row& row = rows[i];
+
+        std::cout << std::right;
+
+        // The program ended inside this statement, so the start time was never balanced
+        if (row.cycles.value() < 0)
+            std::cout << std::setw(17) << "unvollständig" << std::setw(9) << "";   // 'ä' takes two bytes
+        else
+            std::cout << std::setw(16) << row.cycles.value() << std::setw(8) << std::fixed << std::setprecision(1)
+                      << (total_cycles > 0 ? 100.0 * static_cast<double>(row.cycles.value()) / static_cast<double>(total_cycles) : 0.0) << "%";
+
+        std::cout << "  " << std::left << std::setw(10) << row.path << shorten(row.text) << "\n";
+    }
+
+    std::ranges::stable_sort(rows, std::greater{}, &Row::count);
+
+    std::cout << "\nHäufigste Anweisungen:\n";
+    std::cout << std::right << std::setw(17) << "Ausführungen" << "  " << std::left << std::setw(10) << "Pfad" << "Anweisung\n";
+
+    for (size_t i = 0; i < std::min(top, rows.size()) && rows[i].count > 0; i++)
+    {
+        const Row& row = rows[i];
+
+        std::cout << std::right << std::setw(16) << row.count << "  " << std::left << std::setw(10) << row.path << shorten(row.text);
+
+        if (row.then.has_value())
+            std::cout << "  [dann " << std::fixed << std::setprecision(1) << 100.0 * static_cast<double>(row.then.value()) / static_cast<double>(row.count) << "%]";
+
+        if (row.loop.has_value())
+            std::cout << "  [" << std::fixed << std::setprecision(1) << static_cast<double>(row.loop.value()) / static_cast<double>(row.count) << " Durchläufe]";
+
+        std::cout << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t top = 20;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--top" && i + 1 < argc)
+        {
+            const std::string_view value = argv[++i];
+
+            if (std::from_chars(value.data(), value.data() + value.size(), top).ec != std::errc{})
+            {
+                std::cerr << "Fehler: Ungültige Anzahl '" << value << "'" << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+        else
+            files.emplace_back(arg);
+    }
+
+    if (files.size() != 2)
+    {
+        std::cerr << "Verwendung: denkprof [--top N] Programm.profmap Programm.prof" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::pair<std::string, size_t>> counters;
+    std::vector<Row> rows;
+
+    if (!read_map(files[0], counters, rows) || !read_counters(files[1], counters, rows))
+        return EXIT_FAILURE;
+
+    print_report(std::move(rows), top);
+
+    return EXIT_SUCCESS;
+}